@@ -1,25 +1,119 @@
 #include "Assignment.h"
 #include <algorithm>
 
-bool CompareDancers(const Studancer& dancer1, const Studancer& dancer2)
+// Position of a dancer in the assignment
+struct AssignedSlot
 {
-	if (dancer1.priorityGroup == dancer2.priorityGroup)
+	int classIndex;
+	int slot;
+};
+
+// Sorts every class on (priority group, index) with two stable counting sorts over all assigned dancers at once
+// index is a unique position from the shuffle, so the order within a priority group stays random
+void ResortAssignment(Assignment& assignment)
+{
+	// Scratch space is kept per thread, so resorting the same size of assignment again does not allocate
+	thread_local std::vector<AssignedSlot> slots;
+	thread_local std::vector<AssignedSlot> byIndex;
+	thread_local std::vector<int> start;
+	thread_local std::vector<int> order;
+	thread_local std::vector<int> classStart;
+
+	int numSlots = 0;
+	int numIndices = 0;
+	for (auto& classAssignment : assignment)
 	{
-		//return dancer1.relationNumber < dancer2.relationNumber;
-		// Random order should be kept only order based on prio group
-		return dancer1.index < dancer2.index;
+		numSlots += (int)classAssignment.second.size();
+		for (auto& dancer : classAssignment.second)
+		{
+			numIndices = std::max(numIndices, dancer.index + 1);
+		}
 	}
 
-	return dancer1.priorityGroup < dancer2.priorityGroup;
-}
+	if (numSlots == 0)
+	{
+		return;
+	}
 
-void ResortAssignment(Assignment& assignment)
-{
+	slots.clear();
+	classStart.assign(assignment.size() + 1, 0);
+	for (int classIndex = 0; classIndex < assignment.size(); classIndex++)
+	{
+		classStart[classIndex + 1] = classStart[classIndex] + (int)assignment[classIndex].second.size();
+		for (int slot = 0; slot < assignment[classIndex].second.size(); slot++)
+		{
+			slots.push_back({ classIndex, slot });
+		}
+	}
+
+	auto dancerAt = [&](const AssignedSlot& assignedSlot) -> const Studancer& {
+		return assignment[assignedSlot.classIndex].second[assignedSlot.slot];
+	};
+
+	// Counting sort on index, board members can be in two classes so an index can occur more than once
+	start.assign(numIndices + 1, 0);
+	for (auto& assignedSlot : slots)
+	{
+		start[dancerAt(assignedSlot).index + 1]++;
+	}
+	for (int i = 0; i < numIndices; i++)
+	{
+		start[i + 1] += start[i];
+	}
+	byIndex.resize(numSlots);
+	for (auto& assignedSlot : slots)
+	{
+		byIndex[start[dancerAt(assignedSlot).index]++] = assignedSlot;
+	}
+
+	// Stable counting sort on priority group keeps the index order within a group
+	int groupStart[DancerPriorityGroup::Count + 1] = {};
+	for (auto& assignedSlot : byIndex)
+	{
+		groupStart[dancerAt(assignedSlot).priorityGroup + 1]++;
+	}
+	for (int group = 0; group < DancerPriorityGroup::Count; group++)
+	{
+		groupStart[group + 1] += groupStart[group];
+	}
+	for (auto& assignedSlot : byIndex)
+	{
+		slots[groupStart[dancerAt(assignedSlot).priorityGroup]++] = assignedSlot;
+	}
+
+	// order[classStart[c] + k] is the current slot of the dancer that goes to slot k of class c
+	order.resize(numSlots);
+	for (auto& assignedSlot : slots)
+	{
+		order[classStart[assignedSlot.classIndex]++] = assignedSlot.slot;
+	}
+
+	// Apply the order in place by following its cycles, dancers are only moved, never compared or copied
+	int first = 0;
 	for (auto& classAssignment : assignment)
 	{
-		if (classAssignment.second.size() > 0)
+		std::vector<Studancer>& classDancers = classAssignment.second;
+		int* classOrder = order.data() + first;
+		first += (int)classDancers.size();
+
+		for (int slot = 0; slot < classDancers.size(); slot++)
 		{
-			std::sort(classAssignment.second.begin(), classAssignment.second.end(), CompareDancers);
+			if (classOrder[slot] == slot)
+			{
+				continue;
+			}
+
+			Studancer moved = std::move(classDancers[slot]);
+			int current = slot;
+			while (classOrder[current] != slot)
+			{
+				int next = classOrder[current];
+				classDancers[current] = std::move(classDancers[next]);
+				classOrder[current] = current;
+				current = next;
+			}
+			classDancers[current] = std::move(moved);
+			classOrder[current] = current;
 		}
 	}
-}
\ No newline at end of file
+}
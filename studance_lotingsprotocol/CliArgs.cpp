@@ -26,6 +26,16 @@ CliArguments InitializeCliArgs(int argc, char* argv[])
     }
 
     bool parseNextArgAsMaxUnenroll = false;
+    bool parseNextArgAsSimulations = false;
+    bool parseNextArgAsSeed = false;
+    bool parseNextArgAsEnsemble = false;
+    bool parseNextArgAsTimeBudget = false;
+    bool parseNextArgAsSocket = false;
+    bool parseNextArgAsScenarios = false;
+    bool parseNextArgAsCostModel = false;
+    bool parseNextArgAsCostSweep = false;
+    bool parseNextArgAsVerify = false;
+    bool parseNextArgAsExplain = false;
     for (auto& arg : args)
     {
         if (parseNextArgAsMaxUnenroll)
@@ -41,6 +51,102 @@ CliArguments InitializeCliArgs(int argc, char* argv[])
             }
         }
 
+        if (parseNextArgAsSimulations)
+        {
+            parseNextArgAsSimulations = false;
+            if (is_number(arg))
+            {
+                cliArgs.simulations = stoi(arg);
+            }
+            else
+            {
+                cliArgs.parseFailures.push_back("Did not find number after --simulate");
+            }
+        }
+
+        if (parseNextArgAsEnsemble)
+        {
+            parseNextArgAsEnsemble = false;
+            if (is_number(arg))
+            {
+                cliArgs.ensembleRuns = stoi(arg);
+            }
+            else
+            {
+                cliArgs.parseFailures.push_back("Did not find number after --ensemble");
+            }
+        }
+
+        if (parseNextArgAsTimeBudget)
+        {
+            parseNextArgAsTimeBudget = false;
+            if (is_number(arg))
+            {
+                cliArgs.timeBudget = stoi(arg);
+            }
+            else
+            {
+                cliArgs.parseFailures.push_back("Did not find number after --time-budget");
+            }
+        }
+
+        if (parseNextArgAsSeed)
+        {
+            parseNextArgAsSeed = false;
+            if (is_number(arg))
+            {
+                cliArgs.seed = (unsigned int)stoul(arg);
+                cliArgs.hasSeed = true;
+            }
+            else
+            {
+                cliArgs.parseFailures.push_back("Did not find number after --seed");
+            }
+        }
+
+        if (parseNextArgAsSocket)
+        {
+            parseNextArgAsSocket = false;
+            cliArgs.socketPath = arg;
+        }
+
+        if (parseNextArgAsScenarios)
+        {
+            parseNextArgAsScenarios = false;
+            cliArgs.scenariosFile = arg;
+        }
+
+        if (parseNextArgAsCostModel)
+        {
+            parseNextArgAsCostModel = false;
+            cliArgs.costModelFile = arg;
+        }
+
+        if (parseNextArgAsCostSweep)
+        {
+            parseNextArgAsCostSweep = false;
+            cliArgs.costSweepFile = arg;
+        }
+
+        if (parseNextArgAsVerify)
+        {
+            parseNextArgAsVerify = false;
+            cliArgs.verifyFile = arg;
+        }
+
+        if (parseNextArgAsExplain)
+        {
+            parseNextArgAsExplain = false;
+            if (is_number(arg))
+            {
+                cliArgs.explainRelationNumbers.push_back(stoi(arg));
+            }
+            else
+            {
+                cliArgs.parseFailures.push_back("Did not find a relation number after --explain");
+            }
+        }
+
         if (arg == "--help" || arg == "-h")
         {
             cliArgs.displayHelp = true;
@@ -65,10 +171,138 @@ CliArguments InitializeCliArgs(int argc, char* argv[])
         {
             cliArgs.isUpdate = true;
         }
+        else if (arg == "--simulate")
+        {
+            parseNextArgAsSimulations = true;
+        }
+        else if (arg == "--seed")
+        {
+            parseNextArgAsSeed = true;
+        }
+        else if (arg == "--ensemble")
+        {
+            parseNextArgAsEnsemble = true;
+        }
+        else if (arg == "--huge-pages")
+        {
+            cliArgs.hugePages = true;
+        }
+        else if (arg == "--components")
+        {
+            cliArgs.components = true;
+        }
+        else if (arg == "--presolve")
+        {
+            cliArgs.presolve = true;
+        }
+        else if (arg == "--tiers")
+        {
+            cliArgs.tiers = true;
+        }
+        else if (arg == "--time-budget")
+        {
+            parseNextArgAsTimeBudget = true;
+        }
+        else if (arg == "--waitlists")
+        {
+            cliArgs.waitlists = true;
+        }
+        else if (arg == "--sensitivity")
+        {
+            cliArgs.sensitivity = true;
+        }
+        else if (arg == "--verify-sensitivity")
+        {
+            cliArgs.sensitivity = true;
+            cliArgs.verifySensitivity = true;
+        }
+        else if (arg == "--scenarios")
+        {
+            parseNextArgAsScenarios = true;
+        }
+        else if (arg == "--sweep-max-unenroll")
+        {
+            cliArgs.sweepMaxUnenroll = true;
+        }
+        else if (arg == "--cost-model")
+        {
+            parseNextArgAsCostModel = true;
+        }
+        else if (arg == "--cost-sweep")
+        {
+            parseNextArgAsCostSweep = true;
+        }
+        else if (arg == "--verify")
+        {
+            parseNextArgAsVerify = true;
+        }
+        else if (arg == "--explain")
+        {
+            parseNextArgAsExplain = true;
+        }
+        else if (arg == "--daemon")
+        {
+            cliArgs.daemon = true;
+        }
+        else if (arg == "--socket")
+        {
+            cliArgs.daemon = true;
+            parseNextArgAsSocket = true;
+        }
+    }
+
+    if (parseNextArgAsSimulations)
+    {
+        cliArgs.parseFailures.push_back("Did not find number after --simulate");
+    }
+
+    if (parseNextArgAsEnsemble)
+    {
+        cliArgs.parseFailures.push_back("Did not find number after --ensemble");
+    }
+
+    if (parseNextArgAsTimeBudget)
+    {
+        cliArgs.parseFailures.push_back("Did not find number after --time-budget");
+    }
+
+    if (parseNextArgAsSeed)
+    {
+        cliArgs.parseFailures.push_back("Did not find number after --seed");
+    }
+
+    if (parseNextArgAsSocket)
+    {
+        cliArgs.parseFailures.push_back("Did not find a path after --socket");
+    }
+
+    if (parseNextArgAsScenarios)
+    {
+        cliArgs.parseFailures.push_back("Did not find a file after --scenarios");
+    }
+
+    if (parseNextArgAsCostModel)
+    {
+        cliArgs.parseFailures.push_back("Did not find a file after --cost-model");
+    }
+
+    if (parseNextArgAsCostSweep)
+    {
+        cliArgs.parseFailures.push_back("Did not find a file after --cost-sweep");
+    }
+
+    if (parseNextArgAsVerify)
+    {
+        cliArgs.parseFailures.push_back("Did not find a file after --verify");
+    }
+
+    if (parseNextArgAsExplain)
+    {
+        cliArgs.parseFailures.push_back("Did not find a relation number after --explain");
     }
 
-    // auto enable mcmf
-    if (cliArgs.mcmf == cliArgs.lottery && cliArgs.mcmf == false)
+    // auto enable mcmf, unless only a simulation, ensemble, sweep, time budgeted run, verification or explanation was requested
+    if (cliArgs.mcmf == cliArgs.lottery && cliArgs.mcmf == false && cliArgs.simulations == 0 && cliArgs.ensembleRuns == 0 && cliArgs.scenariosFile.empty() && !cliArgs.sweepMaxUnenroll && cliArgs.costSweepFile.empty() && cliArgs.timeBudget == 0 && cliArgs.verifyFile.empty() && cliArgs.explainRelationNumbers.empty())
     {
         cliArgs.mcmf = true;
         cliArgs.lottery = false;
@@ -100,10 +334,36 @@ void DisplayHelp(CliArguments& cliArgs)
         }
     }
 
-    printf("Usage: studance_lotingsprotocol.exe [-h|--help] [-t|--txt] [-m|--mcmf|-l|--lottery]\n");
+    printf("Usage: studance_lotingsprotocol.exe [-h|--help] [-t|--txt] [-m|--mcmf|-l|--lottery] [--simulate N] [--ensemble K] [--seed S] [--huge-pages] [--components] [--presolve] [--tiers] [--time-budget MS] [--waitlists] [--sensitivity|--verify-sensitivity] [--scenarios FILE] [--sweep-max-unenroll] [--cost-model FILE] [--cost-sweep FILE] [--verify FILE] [--explain RELNR] [--daemon|--socket PATH]\n");
     printf("Command explanation:\n");
     printf("  [-h|--help]    : Display this help dialog\n");
     printf("  [-t|--txt]     : Ouptut as text file instead of csv\n");
     printf("  [-m|--mcmf]    : Display this help dialog\n");
     printf("  [-l|--lottery] : Use test data instead of the input data\n");
+    printf("  [--simulate N] : Run the lottery N times and export placement probabilities per dancer, group and class\n");
+    printf("  [--ensemble K] : Solve MCMF for K shuffled dancer orders with the same search as -m and export placement probabilities\n");
+    printf("                   Every order is solved from scratch, so a run places the same dancers as -m would for that order\n");
+    printf("  [--seed S]     : Seed for --simulate, --ensemble and --time-budget, the same seed gives the same result\n");
+    printf("  [--huge-pages] : Back the MCMF network with transparent huge pages where the OS supports them\n");
+    printf("  [--components] : Solve MCMF per group of classes that no dancer chose together with a class outside it, on all threads\n");
+    printf("  [--presolve]   : Place dancers whose cheapest choice is not full below its minimum size for everyone that chose it, before solving MCMF for the rest\n");
+    printf("  [--tiers]      : Solve MCMF for the board, the existing members and everyone else in that order, then repair the whole network\n");
+    printf("  [--time-budget MS] : Start from a lottery draw and improve it towards the MCMF assignment for at most MS milliseconds\n");
+    printf("                       and export it with its cost and a lower bound on the optimal cost, --seed seeds the draw\n");
+    printf("  [--waitlists]  : Also export the ranked waiting list of every class for when it gets one more seat\n");
+    printf("  [--sensitivity]: Also export what one seat more or less in every class changes in the cost and how many dancers move\n");
+    printf("  [--verify-sensitivity] : Like --sensitivity, and check every change by applying it to a copy of the solved network\n");
+    printf("  [--scenarios FILE] : Solve MCMF for every scenario of class sizes in FILE and export a comparison\n");
+    printf("                       FILE has the columns Scenario,Naam,Maximale Ruimte,Extra Speel Ruimte, empty sizes are not changed\n");
+    printf("  [--sweep-max-unenroll] : Solve MCMF for every --max-unenroll from no limit down to the smallest that places everyone\n");
+    printf("                           and export the cost and unenrolled dancers per group, stops at --max-unenroll when given\n");
+    printf("  [--cost-model FILE] : Read the MCMF costs from FILE instead of CostModel.txt in the input folder\n");
+    printf("  [--cost-sweep FILE] : Solve MCMF for every set of costs in FILE and export which dancers are placed differently\n");
+    printf("                        Every set starts with [name] followed by lines like in CostModel.txt, a | between costs makes a grid\n");
+    printf("  [--verify FILE] : Check an exported assignment, also one edited by hand, and prove whether it is the optimal MCMF assignment\n");
+    printf("                    FILE is looked up in the output folder, its _Certificate.csv makes the proof a single pass\n");
+    printf("  [--explain RELNR] : Explain per higher choice of the dancer who is in the way and what placing it there would cost\n");
+    printf("                      With -m after the solve, otherwise from the last MCMF export, can be given more than once\n");
+    printf("  [--daemon]     : Solve once and keep answering line delimited JSON commands on stdin until it closes\n");
+    printf("  [--socket PATH]: Like --daemon, but listen on a Unix domain socket at PATH instead of stdin\n");
 }
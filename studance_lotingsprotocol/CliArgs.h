@@ -10,6 +10,26 @@ struct CliArguments
     bool lottery;
     bool isUpdate;
     int maxUnenroll;
+    int simulations;
+    int ensembleRuns;
+    bool hasSeed;
+    unsigned int seed;
+    bool hugePages;
+    bool components;
+    bool presolve;
+    bool tiers;
+    int timeBudget;
+    std::string verifyFile;
+    std::vector<int> explainRelationNumbers;
+    bool waitlists;
+    bool sensitivity;
+    bool verifySensitivity;
+    std::string scenariosFile;
+    bool sweepMaxUnenroll;
+    std::string costModelFile;
+    std::string costSweepFile;
+    bool daemon;
+    std::string socketPath;
     std::vector<std::string> unknownArgs;
     std::vector<std::string> parseFailures;
 };
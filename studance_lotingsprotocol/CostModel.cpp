@@ -0,0 +1,388 @@
+#include "CostModel.h"
+#include "Utils.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+constexpr CostModelParameters BuildBuiltinCostModelParameters()
+{
+    CostModelParameters parameters = {};
+
+    // Layout is:
+    //    [0-2]: 1st - 3rd choice
+    //    [3]  : unrolled cost
+    // If someone decides not to enroll for 3 classes, the choice to unroll them is made earlier
+    const int64_t boardAndDamnCost[4] = {
+        0,
+        0,
+        300000000,
+        600000000
+    };
+
+    const int64_t hbboardCost[4] = {
+        0,
+        200000000,
+        300000000,
+        600000000
+    };
+
+    // Every next group starts past the 3rd choice of the group before it, with steps of a third of that group
+    // so that two members of a group going from 3rd to 1st choice, or four going from 2nd to 1st,
+    // outweigh a single member of the group before it
+    int64_t baseCost = 300000;
+
+    int64_t start[3] = { 0, 0, 0 };
+    int64_t increment[3] = { 0, 0, 0 };
+
+    increment[0] = 377923;
+    start[0] = baseCost + increment[0] * 3 + 1;
+
+    for (int i = 0; i < 2; i++)
+    {
+        increment[i + 1] = increment[i] / 3 + 1;
+        start[i + 1] = start[i] + 2 * increment[i] + 10; // added padding
+    }
+
+    int64_t groupCost[3][4] = {};
+
+    for (int i = 0; i < 3; i++)
+    {
+        groupCost[i][0] = start[i];
+        for (int j = 1; j < 3; j++)
+        {
+            groupCost[i][j] = groupCost[i][j - 1] + increment[i];
+        }
+    }
+
+    int64_t unenrollBase = groupCost[0][2];
+    groupCost[0][3] = unenrollBase * 1.5f;
+    groupCost[1][3] = unenrollBase * 1.4f;
+    groupCost[2][3] = groupCost[2][2] + 100;
+
+    // Groups that share a cost level differ by a few units, the first of them has the highest priority
+    for (int i = 0; i < 4; i++)
+    {
+        parameters.rankCost[KBBoard][i] = boardAndDamnCost[i];
+        parameters.rankCost[Damn][i] = boardAndDamnCost[i];
+        parameters.rankCost[HBBoard][i] = hbboardCost[i];
+
+        parameters.rankCost[ExistingMember][i] = groupCost[0][i];
+
+        parameters.rankCost[NonDancerLastYear][i] = groupCost[1][i];
+        parameters.rankCost[UnrolledLastYear][i] = groupCost[1][i] + 1;
+        parameters.rankCost[NonFemale][i] = groupCost[1][i] + 2;
+        parameters.rankCost[Female][i] = groupCost[1][i] + 3;
+
+        parameters.rankCost[HalfYear][i] = groupCost[2][i];
+        parameters.rankCost[GapYear][i] = groupCost[2][i] + 1 + i;
+        parameters.rankCost[HalfGapYear][i] = groupCost[2][i] + 2 + i;
+        parameters.rankCost[NonStudying][i] = groupCost[2][i] + 3 + i;
+        parameters.rankCost[HalfNonStudying][i] = groupCost[2][i] + 4 + i;
+    }
+
+    // if four ExistingMembers can go from unenrolled to 1st choice to stop an advised choice it will happen
+    parameters.hasAdvisedCost[ExistingMember] = true;
+    parameters.advisedCost[ExistingMember] = 0;
+
+    parameters.underMinBoundsCost = 0;
+    parameters.withinClassBoundsCost = 125975;
+    parameters.additionalSpaceCost = 125975 + 41992;
+
+    return parameters;
+}
+
+constexpr CostModelParameters builtinCostModelParameters = BuildBuiltinCostModelParameters();
+
+const CostModelParameters& BuiltinCostModelParameters()
+{
+    return builtinCostModelParameters;
+}
+
+CostModel CompileCostModel(const CostModelParameters& parameters)
+{
+    CostModel costModel = {};
+    for (int group = 0; group < DancerPriorityGroup::Count; group++)
+    {
+        for (int rank = 0; rank < 4; rank++)
+        {
+            for (int flags = 0; flags < ChoiceCostFlagCount; flags++)
+            {
+                int64_t cost = parameters.rankCost[group][rank];
+                if (flags & UnenrolledClass)
+                {
+                    // flat cost of +1 such that it is better to not unenroll someone when the choice is between
+                    // moving someone to 2nd or 3rd choice or someone to unenrolled
+                    cost = parameters.rankCost[group][3] + 1;
+                }
+                else if ((flags & FollowsAdvice) && rank == 0 && parameters.hasAdvisedCost[group])
+                {
+                    cost = parameters.advisedCost[group];
+                }
+                costModel.choiceCost[group][rank][flags] = cost;
+            }
+        }
+    }
+
+    costModel.underMinBoundsCost = parameters.underMinBoundsCost;
+    costModel.withinClassBoundsCost = parameters.withinClassBoundsCost;
+    costModel.additionalSpaceCost = parameters.additionalSpaceCost;
+    return costModel;
+}
+
+// Parses the comma separated costs after the colon of a line in CostModel.txt
+std::vector<int64_t> ParseCostValues(const std::string& values, const std::string& key)
+{
+    std::vector<int64_t> costs;
+    std::stringstream stream(values);
+    std::string field;
+    while (std::getline(stream, field, ','))
+    {
+        trim(field);
+        bool isNumber = !field.empty() && std::all_of(field.begin() + (field[0] == '-' ? 1 : 0), field.end(), ::isdigit) && field != "-";
+        if (!isNumber)
+        {
+            printf("ERROR: cost %s of %s in the cost model is not a number\n", field.c_str(), key.c_str());
+            exit(-1);
+        }
+        costs.push_back(std::stoll(field));
+    }
+    return costs;
+}
+
+// Sets the weight of a single "<key>: <costs>" line, where the key is a priority group with the costs of the 1st, 2nd and 3rd choice
+// and unenrolled, "<priority group> advised" with the cost of an advised 1st choice or one of the class seat costs
+void ParseCostModelLine(CostModelParameters& parameters, const std::string& line)
+{
+    size_t colon = line.find(':');
+    if (colon == std::string::npos)
+    {
+        printf("ERROR: line \"%s\" in the cost model has no colon\n", line.c_str());
+        exit(-1);
+    }
+
+    std::string key = line.substr(0, colon);
+    trim(key);
+    tolower(key);
+    std::vector<int64_t> costs = ParseCostValues(line.substr(colon + 1), key);
+
+    int64_t* classCost = nullptr;
+    if (key == "under min bounds")
+    {
+        classCost = &parameters.underMinBoundsCost;
+    }
+    else if (key == "within class bounds")
+    {
+        classCost = &parameters.withinClassBoundsCost;
+    }
+    else if (key == "additional space")
+    {
+        classCost = &parameters.additionalSpaceCost;
+    }
+
+    if (classCost != nullptr)
+    {
+        if (costs.size() != 1)
+        {
+            printf("ERROR: %s in the cost model needs a single cost\n", key.c_str());
+            exit(-1);
+        }
+        *classCost = costs[0];
+        return;
+    }
+
+    bool found = false;
+    for (int group = 0; group < DancerPriorityGroup::Count && !found; group++)
+    {
+        std::string groupName = DancerPriorityGroupToString((DancerPriorityGroup)group);
+        tolower(groupName);
+
+        if (key == groupName)
+        {
+            if (costs.size() != 4)
+            {
+                printf("ERROR: %s in the cost model needs the costs of the 1st, 2nd and 3rd choice and unenrolled\n", key.c_str());
+                exit(-1);
+            }
+            std::copy(costs.begin(), costs.end(), parameters.rankCost[group]);
+            found = true;
+        }
+        else if (key == groupName + " advised")
+        {
+            if (costs.size() != 1)
+            {
+                printf("ERROR: %s in the cost model needs a single cost\n", key.c_str());
+                exit(-1);
+            }
+            parameters.hasAdvisedCost[group] = true;
+            parameters.advisedCost[group] = costs[0];
+            found = true;
+        }
+    }
+
+    if (!found)
+    {
+        printf("ERROR: unknown cost %s in the cost model\n", key.c_str());
+        exit(-1);
+    }
+}
+
+// Finds a file as given or in the input folder
+fs::path FindCostModelFile(const std::string& fileName)
+{
+    fs::path costModelFilePath = fileName;
+    if (!fs::exists(costModelFilePath))
+    {
+        costModelFilePath = GetInputFolder() / fileName;
+    }
+    if (!fs::exists(costModelFilePath))
+    {
+        printf("ERROR: could not find cost model file %s\n", fileName.c_str());
+        exit(-1);
+    }
+    return costModelFilePath;
+}
+
+CostModelParameters LoadCostModelParameters(const std::string& fileName)
+{
+    CostModelParameters parameters = builtinCostModelParameters;
+
+    fs::path costModelFilePath;
+    if (fileName.empty())
+    {
+        costModelFilePath = GetInputFolder() / "CostModel.txt";
+        if (!fs::exists(costModelFilePath))
+        {
+            return parameters;
+        }
+    }
+    else
+    {
+        costModelFilePath = FindCostModelFile(fileName);
+    }
+
+    std::ifstream costModelFile(costModelFilePath);
+    std::string line;
+    while (std::getline(costModelFile, line))
+    {
+        trim(line);
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+
+        ParseCostModelLine(parameters, line);
+    }
+
+    return parameters;
+}
+
+std::vector<NamedCostModel> LoadCostModelSweep(const std::string& fileName, const std::string& baseName, const CostModelParameters& base)
+{
+    struct SweepSection
+    {
+        std::string name;
+        std::vector<std::string> lines;                         // weights of every set of the section
+        std::vector<std::vector<std::string>> gridLines;        // alternatives of the weights that span the grid
+    };
+
+    std::vector<SweepSection> sections;
+
+    std::ifstream sweepFile(FindCostModelFile(fileName));
+    std::string line;
+    while (std::getline(sweepFile, line))
+    {
+        trim(line);
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+
+        if (line.front() == '[' && line.back() == ']')
+        {
+            std::string name = line.substr(1, line.size() - 2);
+            trim(name);
+            sections.push_back({ name, {}, {} });
+            continue;
+        }
+
+        if (sections.empty())
+        {
+            printf("ERROR: the cost sweep file needs a [name] line before the first weight\n");
+            exit(-1);
+        }
+
+        // "<key>: <costs> | <costs> | ..." gives one set per alternative
+        size_t colon = line.find(':');
+        if (colon == std::string::npos || line.find('|') == std::string::npos)
+        {
+            sections.back().lines.push_back(line);
+            continue;
+        }
+
+        std::vector<std::string> alternatives;
+        std::stringstream stream(line.substr(colon + 1));
+        std::string alternative;
+        while (std::getline(stream, alternative, '|'))
+        {
+            trim(alternative);
+            alternatives.push_back(line.substr(0, colon + 1) + " " + alternative);
+        }
+        sections.back().gridLines.push_back(alternatives);
+    }
+
+    std::vector<NamedCostModel> sweep;
+    sweep.push_back({ baseName, base });
+
+    for (const SweepSection& section : sections)
+    {
+        // Walks every combination of the alternatives, the first grid line changes slowest
+        std::vector<int> choice(section.gridLines.size(), 0);
+        while (true)
+        {
+            NamedCostModel named = { section.name, base };
+            for (const std::string& sectionLine : section.lines)
+            {
+                ParseCostModelLine(named.parameters, sectionLine);
+            }
+
+            std::string gridName;
+            for (int i = 0; i < section.gridLines.size(); i++)
+            {
+                const std::string& gridLine = section.gridLines[i][choice[i]];
+                ParseCostModelLine(named.parameters, gridLine);
+                gridName += (i == 0 ? "" : "; ") + gridLine;
+            }
+            if (!gridName.empty())
+            {
+                named.name += " (" + gridName + ")";
+            }
+            sweep.push_back(named);
+
+            int i = (int)choice.size() - 1;
+            while (i >= 0 && ++choice[i] == section.gridLines[i].size())
+            {
+                choice[i] = 0;
+                i--;
+            }
+            if (i < 0)
+            {
+                break;
+            }
+        }
+    }
+
+    return sweep;
+}
+
+CostModel activeCostModel = CompileCostModel(builtinCostModelParameters);
+
+const CostModel& GetCostModel()
+{
+    return activeCostModel;
+}
+
+void SetCostModel(const CostModel& costModel)
+{
+    activeCostModel = costModel;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Studancer.h"
+
+// Weights of the cost model as they are written in CostModel.txt
+struct CostModelParameters
+{
+    int64_t rankCost[DancerPriorityGroup::Count][4];    // 1st, 2nd and 3rd choice and unenrolled, per priority group
+    bool hasAdvisedCost[DancerPriorityGroup::Count];    // without it an advised 1st choice costs the same as any 1st choice
+    int64_t advisedCost[DancerPriorityGroup::Count];    // 1st choice that is one of the advised classes
+    int64_t underMinBoundsCost;                         // seat below the minimum size of a class
+    int64_t withinClassBoundsCost;                      // seat between the minimum and maximum size, or in a special class
+    int64_t additionalSpaceCost;                        // seat in the additional space of a class
+};
+
+// The cost model compiled into a flat table, the cost of an arc from a dancer to a class is a single lookup
+struct CostModel
+{
+    int64_t choiceCost[DancerPriorityGroup::Count][4][ChoiceCostFlagCount];
+    int64_t underMinBoundsCost;
+    int64_t withinClassBoundsCost;
+    int64_t additionalSpaceCost;
+};
+
+// The weights the lottery was tuned with, used when there is no CostModel.txt
+const CostModelParameters& BuiltinCostModelParameters();
+
+CostModel CompileCostModel(const CostModelParameters& parameters);
+
+// Reads the weights from fileName, weights that are not in the file keep their built in value
+// An empty fileName reads CostModel.txt from the input folder when it exists
+CostModelParameters LoadCostModelParameters(const std::string& fileName);
+
+struct NamedCostModel
+{
+    std::string name;
+    CostModelParameters parameters;
+};
+
+// Reads the sets of a cost sweep, every set starts with a "[name]" line followed by weights like in CostModel.txt
+// Weights that are not in a set keep their value in base, base itself is always the first set
+// A weight with alternatives separated by | spans a grid, the set is repeated for every combination of them
+std::vector<NamedCostModel> LoadCostModelSweep(const std::string& fileName, const std::string& baseName, const CostModelParameters& base);
+
+// The cost model used to encode networks, the built in one until SetCostModel() is called
+const CostModel& GetCostModel();
+
+// Only call this before solving, the networks that were already encoded keep their costs
+void SetCostModel(const CostModel& costModel);
+
+// Rank 3 is unenrolled, a rank above it is counted as unenrolled too
+inline int64_t GetChoiceCost(const CostModel& costModel, DancerPriorityGroup group, int rank, int flags)
+{
+    return costModel.choiceCost[group][rank > 3 ? 3 : rank][flags];
+}
+
+// Cost of the arc from a dancer to chosenClasses[choiceIndex], its choiceNumber-th choice not counting empty choices
+inline int64_t GetChoiceArcCost(const CostModel& costModel, const Studancer& dancer, int choiceIndex, int choiceNumber)
+{
+    return GetChoiceCost(costModel, dancer.priorityGroup, choiceNumber, dancer.choiceFlags[choiceIndex]);
+}
@@ -0,0 +1,826 @@
+#include "Daemon.h"
+#include "MinCostMaxFlow.h"
+#include "Assignment.h"
+#include "Export.h"
+#include "Statistics.h"
+#include "TaskPool.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// A value of a flat JSON object, strings are unescaped and numbers and literals are kept as written
+struct JsonValue
+{
+    std::string text;
+    bool isString;
+};
+
+typedef std::map<std::string, JsonValue> JsonObject;
+
+inline void SkipJsonSpace(const std::string& line, size_t& offset)
+{
+    while (offset < line.size() && isspace((unsigned char)line[offset]))
+    {
+        offset++;
+    }
+}
+
+// Parses the quoted string at offset, \u escapes are only supported for ASCII characters
+bool ParseJsonString(const std::string& line, size_t& offset, std::string& value)
+{
+    if (offset >= line.size() || line[offset] != '"')
+    {
+        return false;
+    }
+    offset++;
+
+    value.clear();
+    while (offset < line.size())
+    {
+        char c = line[offset++];
+        if (c == '"')
+        {
+            return true;
+        }
+
+        if (c != '\\')
+        {
+            value += c;
+            continue;
+        }
+
+        if (offset >= line.size())
+        {
+            return false;
+        }
+
+        char escaped = line[offset++];
+        switch (escaped)
+        {
+        case '"': case '\\': case '/': value += escaped; break;
+        case 'b': value += '\b'; break;
+        case 'f': value += '\f'; break;
+        case 'n': value += '\n'; break;
+        case 'r': value += '\r'; break;
+        case 't': value += '\t'; break;
+        case 'u':
+        {
+            if (offset + 4 > line.size() || !std::all_of(line.begin() + offset, line.begin() + offset + 4, ::isxdigit))
+            {
+                return false;
+            }
+            int code = std::stoi(line.substr(offset, 4), nullptr, 16);
+            if (code >= 0x80)
+            {
+                return false;
+            }
+            value += (char)code;
+            offset += 4;
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+
+    return false;
+}
+
+bool IsJsonLiteral(const std::string& text)
+{
+    if (text == "true" || text == "false" || text == "null")
+    {
+        return true;
+    }
+
+    if (text.empty() || !(text[0] == '-' || isdigit((unsigned char)text[0])))
+    {
+        return false;
+    }
+
+    char* end = nullptr;
+    strtod(text.c_str(), &end);
+    return end == text.c_str() + text.size();
+}
+
+// Parses a line holding a single JSON object, only string, number and literal values are supported
+bool ParseJsonObject(const std::string& line, JsonObject& object, std::string& error)
+{
+    size_t offset = 0;
+    SkipJsonSpace(line, offset);
+    if (offset >= line.size() || line[offset] != '{')
+    {
+        error = "expected a JSON object";
+        return false;
+    }
+    offset++;
+
+    SkipJsonSpace(line, offset);
+    bool isDone = offset < line.size() && line[offset] == '}';
+    if (isDone)
+    {
+        offset++;
+    }
+
+    while (!isDone)
+    {
+        std::string key;
+        if (!ParseJsonString(line, offset, key))
+        {
+            error = "expected a quoted key";
+            return false;
+        }
+
+        SkipJsonSpace(line, offset);
+        if (offset >= line.size() || line[offset] != ':')
+        {
+            error = "expected : after " + key;
+            return false;
+        }
+        offset++;
+        SkipJsonSpace(line, offset);
+
+        JsonValue value = {};
+        if (offset < line.size() && line[offset] == '"')
+        {
+            value.isString = true;
+            if (!ParseJsonString(line, offset, value.text))
+            {
+                error = "invalid string for " + key;
+                return false;
+            }
+        }
+        else
+        {
+            size_t start = offset;
+            while (offset < line.size() && line[offset] != ',' && line[offset] != '}' && !isspace((unsigned char)line[offset]))
+            {
+                offset++;
+            }
+            value.text = line.substr(start, offset - start);
+            if (!IsJsonLiteral(value.text))
+            {
+                error = "unsupported value for " + key;
+                return false;
+            }
+        }
+        object[key] = value;
+
+        SkipJsonSpace(line, offset);
+        if (offset < line.size() && line[offset] == ',')
+        {
+            offset++;
+            SkipJsonSpace(line, offset);
+        }
+        else if (offset < line.size() && line[offset] == '}')
+        {
+            offset++;
+            isDone = true;
+        }
+        else
+        {
+            error = "expected , or } after " + key;
+            return false;
+        }
+    }
+
+    SkipJsonSpace(line, offset);
+    if (offset != line.size())
+    {
+        error = "unexpected text after the object";
+        return false;
+    }
+
+    return true;
+}
+
+// Reads a whole number given either as a number or as a string
+bool GetJsonInt(const JsonObject& object, const std::string& key, int& value)
+{
+    auto it = object.find(key);
+    if (it == object.end())
+    {
+        return false;
+    }
+
+    const std::string& text = it->second.text;
+    size_t start = !text.empty() && text[0] == '-' ? 1 : 0;
+    if (start == text.size() || text.size() - start > 9 || !std::all_of(text.begin() + start, text.end(), ::isdigit))
+    {
+        return false;
+    }
+
+    value = std::stoi(text);
+    return true;
+}
+
+bool GetJsonString(const JsonObject& object, const std::string& key, std::string& value)
+{
+    auto it = object.find(key);
+    if (it == object.end() || !it->second.isString)
+    {
+        return false;
+    }
+
+    value = it->second.text;
+    return true;
+}
+
+// Everything a read needs, a new one is published as a whole after every change
+// so reads never see the network while it is being changed
+struct DaemonSnapshot
+{
+    int version;                                            // number of changes applied since the solve
+    Assignment assignment;                                  // resorted like an export
+    std::map<int, std::vector<std::string>> placements;     // relation number of every enrolled dancer -> its placements as JSON objects
+};
+
+// Where the responses to the commands of one input go, each response is written as a whole line
+struct DaemonConnection
+{
+    explicit DaemonConnection(int socket) : socket(socket) {}
+    ~DaemonConnection();
+
+    void WriteLine(const std::string& line);
+
+    int socket;                 // -1 for stdout
+    std::mutex writeMutex;
+};
+
+DaemonConnection::~DaemonConnection()
+{
+#ifndef _WIN32
+    if (socket != -1)
+    {
+        close(socket);
+    }
+#endif
+}
+
+void DaemonConnection::WriteLine(const std::string& line)
+{
+    std::lock_guard<std::mutex> lock(writeMutex);
+
+    if (socket == -1)
+    {
+        fwrite(line.data(), 1, line.size(), stdout);
+        fputc('\n', stdout);
+        fflush(stdout);
+        return;
+    }
+
+#ifndef _WIN32
+    std::string data = line + "\n";
+    size_t written = 0;
+    while (written < data.size())
+    {
+        ssize_t result = send(socket, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+        if (result <= 0)
+        {
+            // The client went away, there is nobody left to answer
+            return;
+        }
+        written += (size_t)result;
+    }
+#endif
+}
+
+struct Daemon
+{
+    CliArguments cliArgs;
+    std::vector<Studancer> dancers;         // every dancer that was ever in the network, withdrawn dancers keep their node
+    std::vector<DanceClass> classes;
+    MinCostMaxFlowArgs mcmf;
+    std::map<int, int> enrolledDancers;     // relation number -> index in dancers
+    int version;
+
+    // Changes wait here and are applied one at a time in arrival order by a single task on the pool
+    std::mutex changesMutex;
+    std::deque<std::function<void()>> changes;
+    bool isApplyingChanges;
+
+    std::mutex snapshotMutex;
+    std::shared_ptr<const DaemonSnapshot> snapshot;
+
+    std::mutex exportMutex;                 // exports write the same files
+
+    std::mutex tasksMutex;
+    std::condition_variable tasksCondition;
+    int pendingTasks;
+};
+
+void SubmitDaemonTask(Daemon& daemon, std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(daemon.tasksMutex);
+        daemon.pendingTasks++;
+    }
+
+    GetTaskPool().Submit([&daemon, task]() {
+        task();
+
+        std::lock_guard<std::mutex> lock(daemon.tasksMutex);
+        daemon.pendingTasks--;
+        daemon.tasksCondition.notify_all();
+    });
+}
+
+void WaitForDaemonTasks(Daemon& daemon)
+{
+    std::unique_lock<std::mutex> lock(daemon.tasksMutex);
+    daemon.tasksCondition.wait(lock, [&]() { return daemon.pendingTasks == 0; });
+}
+
+void ApplyChanges(Daemon& daemon)
+{
+    while (true)
+    {
+        std::function<void()> change;
+        {
+            std::lock_guard<std::mutex> lock(daemon.changesMutex);
+            if (daemon.changes.empty())
+            {
+                daemon.isApplyingChanges = false;
+                return;
+            }
+            change = std::move(daemon.changes.front());
+            daemon.changes.pop_front();
+        }
+
+        change();
+    }
+}
+
+void QueueChange(Daemon& daemon, std::function<void()> change)
+{
+    bool startApplying = false;
+    {
+        std::lock_guard<std::mutex> lock(daemon.changesMutex);
+        daemon.changes.push_back(std::move(change));
+        startApplying = !daemon.isApplyingChanges;
+        daemon.isApplyingChanges = true;
+    }
+
+    if (startApplying)
+    {
+        SubmitDaemonTask(daemon, [&daemon]() { ApplyChanges(daemon); });
+    }
+}
+
+std::shared_ptr<const DaemonSnapshot> GetSnapshot(Daemon& daemon)
+{
+    std::lock_guard<std::mutex> lock(daemon.snapshotMutex);
+    return daemon.snapshot;
+}
+
+// Reads are answered right away on the thread that read the command, from the last published snapshot
+// They never wait for the changes that are queued or being applied, the pool can be busy with those
+void AnswerRead(Daemon& daemon, const std::function<void(const DaemonSnapshot&)>& read)
+{
+    std::shared_ptr<const DaemonSnapshot> snapshot = GetSnapshot(daemon);
+    read(*snapshot);
+}
+
+// Decodes the network into a new snapshot, only called while no change is being applied
+void PublishSnapshot(Daemon& daemon)
+{
+    auto snapshot = std::make_shared<DaemonSnapshot>();
+    snapshot->version = daemon.version;
+    snapshot->assignment = DecodeMinCostMaxFlow(daemon.mcmf);
+    ResortAssignment(snapshot->assignment);
+
+    for (auto& enrolledDancer : daemon.enrolledDancers)
+    {
+        snapshot->placements[enrolledDancer.first];
+    }
+
+    for (auto& classAssignment : snapshot->assignment)
+    {
+        std::string className = classAssignment.first.name;
+        for (auto& dancer : classAssignment.second)
+        {
+            int choiceIndex = FindItemInVector(dancer.chosenClasses, className);
+            snapshot->placements[dancer.relationNumber].push_back(
+                "{\"class\":" + ToJsonString(className) + ",\"choice\":" + ToJsonString(ChoiceNumberToString(choiceIndex)) + "}");
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(daemon.snapshotMutex);
+    daemon.snapshot = snapshot;
+}
+
+// Writes a response, body holds the members after the id
+void Respond(DaemonConnection& connection, const std::string& id, const std::string& body)
+{
+    connection.WriteLine("{" + (id.empty() ? "" : "\"id\":" + id + ",") + body + "}");
+}
+
+void RespondError(DaemonConnection& connection, const std::string& id, const std::string& error)
+{
+    Respond(connection, id, "\"ok\":false,\"error\":" + ToJsonString(error));
+}
+
+// Answers with the placements of a dancer in the snapshot
+void RespondPlacements(DaemonConnection& connection, const std::string& id, const DaemonSnapshot& snapshot, int relationNumber)
+{
+    auto it = snapshot.placements.find(relationNumber);
+    if (it == snapshot.placements.end())
+    {
+        RespondError(connection, id, "dancer " + std::to_string(relationNumber) + " is not enrolled");
+        return;
+    }
+
+    std::string placements;
+    for (auto& placement : it->second)
+    {
+        placements += (placements.empty() ? "" : ",") + placement;
+    }
+
+    Respond(connection, id, "\"ok\":true,\"version\":" + std::to_string(snapshot.version) +
+        ",\"relationNumber\":" + std::to_string(relationNumber) + ",\"placements\":[" + placements + "]");
+}
+
+void AddDaemonDancer(Daemon& daemon, DaemonConnection& connection, const std::string& id, const std::string& row)
+{
+    Studancer dancer;
+    std::string error;
+    if (!ParseDancer(row, daemon.classes, dancer, error))
+    {
+        RespondError(connection, id, error);
+        return;
+    }
+
+    if (daemon.enrolledDancers.count(dancer.relationNumber) > 0)
+    {
+        RespondError(connection, id, "dancer " + std::to_string(dancer.relationNumber) + " is already enrolled");
+        return;
+    }
+
+    dancer.index = (int)daemon.dancers.size();
+    daemon.dancers.push_back(dancer);
+    AddDancer(daemon.mcmf, daemon.dancers, daemon.classes, daemon.cliArgs);
+    daemon.enrolledDancers[dancer.relationNumber] = dancer.index;
+
+    daemon.version++;
+    PublishSnapshot(daemon);
+    RespondPlacements(connection, id, *GetSnapshot(daemon), dancer.relationNumber);
+}
+
+void WithdrawDaemonDancer(Daemon& daemon, DaemonConnection& connection, const std::string& id, int relationNumber)
+{
+    auto it = daemon.enrolledDancers.find(relationNumber);
+    if (it == daemon.enrolledDancers.end())
+    {
+        RespondError(connection, id, "dancer " + std::to_string(relationNumber) + " is not enrolled");
+        return;
+    }
+
+    WithdrawDancer(daemon.mcmf, it->second);
+    daemon.enrolledDancers.erase(it);
+
+    daemon.version++;
+    PublishSnapshot(daemon);
+    Respond(connection, id, "\"ok\":true,\"version\":" + std::to_string(daemon.version));
+}
+
+void ChangeDaemonClassCapacity(Daemon& daemon, DaemonConnection& connection, const std::string& id, std::string className, int maxSize)
+{
+    tolower(className);
+    trim(className);
+
+    int classIndex = -1;
+    for (int i = 0; i < daemon.classes.size(); i++)
+    {
+        if (daemon.classes[i].name == className)
+        {
+            classIndex = i;
+            break;
+        }
+    }
+
+    if (classIndex == -1)
+    {
+        RespondError(connection, id, "unknown class " + className);
+        return;
+    }
+
+    DanceClass& danceClass = daemon.classes[classIndex];
+    const bool isSpecialClass = danceClass.name == "niet-dansend lid" || danceClass.name == "unenrolled";
+    if (!isSpecialClass && maxSize < danceClass.minSize)
+    {
+        RespondError(connection, id, "class " + className + " needs room for at least " + std::to_string(danceClass.minSize) + " dancers");
+        return;
+    }
+    if (maxSize < 0)
+    {
+        RespondError(connection, id, "the size of a class cannot be negative");
+        return;
+    }
+
+    const int oldMaxSize = danceClass.maxSize;
+    const size_t oldNumDecisions = daemon.mcmf.decisions.size();
+    danceClass.maxSize = maxSize;
+    bool isChanged = TryChangeClassCapacity(daemon.mcmf, classIndex, isSpecialClass ? maxSize : maxSize - danceClass.minSize);
+    if (!isChanged)
+    {
+        // Growing back to the old size always succeeds and moves the dancers that were already moved out back where they are cheapest
+        danceClass.maxSize = oldMaxSize;
+        TryChangeClassCapacity(daemon.mcmf, classIndex, isSpecialClass ? oldMaxSize : oldMaxSize - danceClass.minSize);
+    }
+
+    // A failed change can still have moved dancers between equally cheap places, the snapshot follows the network
+    if (isChanged || daemon.mcmf.decisions.size() != oldNumDecisions)
+    {
+        daemon.version++;
+        PublishSnapshot(daemon);
+    }
+
+    if (!isChanged)
+    {
+        RespondError(connection, id, "cannot shrink " + className + " to " + std::to_string(maxSize) + ", its dancers have nowhere else to go");
+        return;
+    }
+    Respond(connection, id, "\"ok\":true,\"version\":" + std::to_string(daemon.version));
+}
+
+void ExportDaemonAssignment(Daemon& daemon, DaemonConnection& connection, const std::string& id, const DaemonSnapshot& snapshot)
+{
+    std::string output;
+    {
+        std::lock_guard<std::mutex> lock(daemon.exportMutex);
+        ScopedOutputBuffer outputBuffer(&output);
+        ExportAssignment(snapshot.assignment, "ClassAssignment_MCMF", daemon.cliArgs);
+    }
+    fputs(output.c_str(), stderr);
+
+    auto outputPath = GetOutputFolder() / (daemon.cliArgs.asText ? "ClassAssignment_MCMF.txt" : "ClassAssignment_MCMF.csv");
+    Respond(connection, id, "\"ok\":true,\"version\":" + std::to_string(snapshot.version) + ",\"path\":" + ToJsonString(outputPath.string()));
+}
+
+// Handles one line of input, returns false when the daemon should shut down
+bool HandleCommand(Daemon& daemon, const std::shared_ptr<DaemonConnection>& connection, const std::string& line)
+{
+    if (line.find_first_not_of(" \t\r") == std::string::npos)
+    {
+        return true;
+    }
+
+    JsonObject request;
+    std::string error;
+    if (!ParseJsonObject(line, request, error))
+    {
+        RespondError(*connection, "", error);
+        return true;
+    }
+
+    std::string id;
+    if (request.count("id") > 0)
+    {
+        id = request["id"].isString ? ToJsonString(request["id"].text) : request["id"].text;
+    }
+
+    std::string command;
+    GetJsonString(request, "command", command);
+
+    if (command == "add")
+    {
+        std::string row;
+        if (!GetJsonString(request, "row", row))
+        {
+            RespondError(*connection, id, "add needs a row");
+            return true;
+        }
+        QueueChange(daemon, [&daemon, connection, id, row]() { AddDaemonDancer(daemon, *connection, id, row); });
+    }
+    else if (command == "withdraw")
+    {
+        int relationNumber = 0;
+        if (!GetJsonInt(request, "relationNumber", relationNumber))
+        {
+            RespondError(*connection, id, "withdraw needs a relationNumber");
+            return true;
+        }
+        QueueChange(daemon, [&daemon, connection, id, relationNumber]() { WithdrawDaemonDancer(daemon, *connection, id, relationNumber); });
+    }
+    else if (command == "capacity")
+    {
+        std::string className;
+        int maxSize = 0;
+        if (!GetJsonString(request, "class", className) || !GetJsonInt(request, "maxSize", maxSize))
+        {
+            RespondError(*connection, id, "capacity needs a class and a maxSize");
+            return true;
+        }
+        QueueChange(daemon, [&daemon, connection, id, className, maxSize]() { ChangeDaemonClassCapacity(daemon, *connection, id, className, maxSize); });
+    }
+    else if (command == "query")
+    {
+        int relationNumber = 0;
+        if (!GetJsonInt(request, "relationNumber", relationNumber))
+        {
+            RespondError(*connection, id, "query needs a relationNumber");
+            return true;
+        }
+        AnswerRead(daemon, [connection, id, relationNumber](const DaemonSnapshot& snapshot) {
+            RespondPlacements(*connection, id, snapshot, relationNumber);
+        });
+    }
+    else if (command == "export")
+    {
+        AnswerRead(daemon, [&daemon, connection, id](const DaemonSnapshot& snapshot) { ExportDaemonAssignment(daemon, *connection, id, snapshot); });
+    }
+    else if (command == "shutdown")
+    {
+        WaitForDaemonTasks(daemon);
+        Respond(*connection, id, "\"ok\":true");
+        return false;
+    }
+    else
+    {
+        RespondError(*connection, id, command.empty() ? "missing command" : "unknown command " + command);
+    }
+
+    return true;
+}
+
+void ServeStdin(Daemon& daemon)
+{
+    auto connection = std::make_shared<DaemonConnection>(-1);
+
+    std::string line;
+    while (std::getline(std::cin, line))
+    {
+        if (!HandleCommand(daemon, connection, line))
+        {
+            break;
+        }
+    }
+}
+
+#ifndef _WIN32
+// Reads the lines of one client until it disconnects, returns false when it asked to shut down
+bool ServeSocketConnection(Daemon& daemon, const std::shared_ptr<DaemonConnection>& connection)
+{
+    std::string pending;
+    char buffer[4096];
+    while (true)
+    {
+        ssize_t received = recv(connection->socket, buffer, sizeof(buffer), 0);
+        if (received <= 0)
+        {
+            return true;
+        }
+        pending.append(buffer, (size_t)received);
+
+        size_t lineStart = 0;
+        size_t lineEnd;
+        while ((lineEnd = pending.find('\n', lineStart)) != std::string::npos)
+        {
+            if (!HandleCommand(daemon, connection, pending.substr(lineStart, lineEnd - lineStart)))
+            {
+                return false;
+            }
+            lineStart = lineEnd + 1;
+        }
+        pending.erase(0, lineStart);
+    }
+}
+#endif
+
+void ServeSocket(Daemon& daemon, const std::string& socketPath)
+{
+#ifdef _WIN32
+    printf("ERROR: --socket is only supported on systems with Unix domain sockets, use --daemon to read commands from stdin\n");
+    exit(-1);
+#else
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path))
+    {
+        printf("ERROR: socket path %s is too long\n", socketPath.c_str());
+        exit(-1);
+    }
+    memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    int listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socketPath.c_str());
+    if (listenSocket == -1 || bind(listenSocket, (sockaddr*)&address, sizeof(address)) != 0 || listen(listenSocket, 16) != 0)
+    {
+        printf("ERROR: could not listen on %s\n", socketPath.c_str());
+        exit(-1);
+    }
+    fprintf(stderr, "Listening on %s\n", socketPath.c_str());
+
+    // Every client gets a thread that reads its commands, the commands themselves run on the pool
+    std::mutex clientsMutex;
+    std::vector<std::thread> clients;
+    std::vector<int> clientSockets;
+    bool isShuttingDown = false;
+
+    while (true)
+    {
+        int clientSocket = accept(listenSocket, nullptr, nullptr);
+        if (clientSocket == -1)
+        {
+            std::lock_guard<std::mutex> lock(clientsMutex);
+            if (isShuttingDown)
+            {
+                break;
+            }
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        clientSockets.push_back(clientSocket);
+        clients.emplace_back([&, clientSocket]() {
+            auto connection = std::make_shared<DaemonConnection>(clientSocket);
+            bool keepServing = ServeSocketConnection(daemon, connection);
+
+            std::lock_guard<std::mutex> lock(clientsMutex);
+            clientSockets.erase(std::find(clientSockets.begin(), clientSockets.end(), clientSocket));
+            if (!keepServing)
+            {
+                isShuttingDown = true;
+
+                // Wake up accept() and the other clients
+                shutdown(listenSocket, SHUT_RDWR);
+                for (int otherSocket : clientSockets)
+                {
+                    shutdown(otherSocket, SHUT_RD);
+                }
+            }
+        });
+    }
+
+    for (auto& client : clients)
+    {
+        client.join();
+    }
+
+    close(listenSocket);
+    unlink(socketPath.c_str());
+#endif
+}
+
+void RunDaemon(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const CliArguments& cliArgs)
+{
+    Daemon daemon;
+    daemon.cliArgs = cliArgs;
+    daemon.dancers = dancers;
+    daemon.classes = classes;
+    daemon.version = 0;
+    daemon.isApplyingChanges = false;
+    daemon.pendingTasks = 0;
+
+    for (auto& dancer : daemon.dancers)
+    {
+        daemon.enrolledDancers[dancer.relationNumber] = dancer.index;
+    }
+
+    // stdout only carries responses, the report of the solve goes to stderr
+    std::string output;
+    {
+        ScopedOutputBuffer outputBuffer(&output);
+        daemon.mcmf = EncodeMinCostMaxFlow(daemon.dancers, daemon.classes, cliArgs);
+        auto result = MinCostMaxFlow(daemon.mcmf, cliArgs);
+        Print("Solved %i dancers with cost %lli and flow %i\n", (int)daemon.dancers.size(), (long long)result.first, result.second);
+    }
+    fputs(output.c_str(), stderr);
+
+    // The changes search from class and sink nodes too, so every node needs a valid potential
+    if (!ComputeAllPotentials(daemon.mcmf))
+    {
+        printf("ERROR: the solved network still contains a negative cycle\n");
+        exit(-1);
+    }
+
+    PublishSnapshot(daemon);
+
+    if (cliArgs.socketPath.empty())
+    {
+        ServeStdin(daemon);
+    }
+    else
+    {
+        ServeSocket(daemon, cliArgs.socketPath);
+    }
+
+    WaitForDaemonTasks(daemon);
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <vector>
+#include "Studancer.h"
+#include "DanceClass.h"
+#include "CliArgs.h"
+
+// Solves the assignment once and keeps the solved network in memory to answer line delimited JSON commands,
+// read from stdin or from the connections of a Unix domain socket when cliArgs.socketPath is set
+// Commands, one JSON object per line, an "id" is echoed back in the response:
+//   {"command":"add","row":"<row in the format of the dancers file>"}
+//   {"command":"withdraw","relationNumber":N}
+//   {"command":"capacity","class":"<name>","maxSize":N}
+//   {"command":"query","relationNumber":N}
+//   {"command":"export"}
+//   {"command":"shutdown"}
+// Changes are applied one at a time to the solved network, queries and exports are answered right away from the last published assignment
+// A capacity change that leaves dancers with nowhere to go is undone and answered with "ok":false
+void RunDaemon(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const CliArguments& cliArgs);
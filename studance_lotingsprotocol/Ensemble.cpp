@@ -0,0 +1,124 @@
+#include "Ensemble.h"
+#include "MinCostMaxFlow.h"
+#include "Utils.h"
+#include "TaskPool.h"
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <random>
+
+// State of a single ensemble thread, the network buffers are reused for every seed it solves
+struct EnsembleWorker
+{
+    MinCostMaxFlowArgs args;
+    std::vector<int> order;             // shuffled position -> dancer index
+    std::vector<int> position;          // dancer index -> shuffled position
+    SimulationResult result;
+};
+
+void RunEnsembleSeed(EnsembleWorker& worker, const MinCostMaxFlowArgs& base, const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes,
+                     const StatisticsInput& statisticsInput, const std::vector<int>& canonicalOrder, unsigned int seed, int run)
+{
+    std::seed_seq seedSequence = { seed, (unsigned int)run };
+    std::mt19937 rng(seedSequence);
+
+    worker.order = canonicalOrder;
+    std::shuffle(worker.order.begin(), worker.order.end(), rng);
+    for (int i = 0; i < worker.order.size(); i++)
+    {
+        worker.position[worker.order[i]] = i;
+    }
+
+    // The production search, the ties between equal cost paths decide who gets a seat and Dijkstra breaks them differently
+    PermuteDancerNodes(base, worker.position, worker.args);
+    BellmanFordShortestPaths(worker.args);
+
+    MinCostMaxFlowArgs& args = worker.args;
+    std::vector<int> classSizes(classes.size(), 0);
+    for (int dancerIndex = 0; dancerIndex < dancers.size(); dancerIndex++)
+    {
+        const Studancer& dancer = dancers[dancerIndex];
+        int dancerNode = args.dancerOffset + worker.position[dancerIndex];
+
+        for (int neighbour : args.adjecencyList[dancerNode])
+        {
+            // Flow from the dancer to a class node means the dancer was assigned to it
+            bool isClass = neighbour >= args.classOffset && neighbour < args.classCostOffset;
+            if (!isClass || args.flow[(size_t)dancerNode * args.numNodes + neighbour] <= 0)
+            {
+                continue;
+            }
+
+            int classIndex = neighbour - args.classOffset;
+            auto choice = std::find(dancer.chosenClasses.begin(), dancer.chosenClasses.end(), classes[classIndex].name);
+            int rank = std::min((int)(choice - dancer.chosenClasses.begin()), 3);
+
+            worker.result.dancerOutcomes[dancerIndex][rank]++;
+            worker.result.classOutcomes[classIndex][rank]++;
+            CountPlacement(worker.result.statistics, statisticsInput, dancerIndex, classIndex);
+            classSizes[classIndex]++;
+        }
+    }
+
+    for (int classIndex = 0; classIndex < classes.size(); classIndex++)
+    {
+        if (classSizes[classIndex] >= classes[classIndex].maxSize)
+        {
+            worker.result.classFull[classIndex]++;
+        }
+    }
+
+    worker.result.runs++;
+    worker.result.statistics.runs++;
+}
+
+SimulationResult EnsembleMinCostMaxFlow(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const StatisticsInput& statisticsInput, const CliArguments& cliArgs, int runs, unsigned int seed)
+{
+    // Encode the network once, all seeds share its topology
+    MinCostMaxFlowArgs base = EncodeMinCostMaxFlow(dancers, classes, cliArgs);
+
+    // A solution loaded for --update can leave negative cycles, every seed starts from the flow without them
+    if (cliArgs.isUpdate)
+    {
+        CancelNegativeCycles(base);
+    }
+
+    // Start every seed from the relation number order so the same seed always gives the same result
+    std::vector<int> canonicalOrder(dancers.size());
+    std::iota(canonicalOrder.begin(), canonicalOrder.end(), 0);
+    std::sort(canonicalOrder.begin(), canonicalOrder.end(), [&](int a, int b) {
+        return dancers[a].relationNumber < dancers[b].relationNumber;
+    });
+
+    TaskPool& pool = GetTaskPool();
+    int numThreads = std::min(pool.GetNumThreads(), std::max(1, runs));
+
+    std::vector<EnsembleWorker> workers(numThreads);
+    for (auto& worker : workers)
+    {
+        worker.args = AllocateMinCostMaxFlow(base.numNodes, std::make_shared<SolverArena>(cliArgs.hugePages));
+        worker.order.resize(dancers.size());
+        worker.position.resize(dancers.size());
+        ClearSimulationResult(worker.result, (int)dancers.size(), (int)classes.size());
+    }
+
+    std::atomic<int> nextRun(0);
+    pool.ParallelFor(numThreads, [&](int workerIndex) {
+        EnsembleWorker& worker = workers[workerIndex];
+        int run = nextRun.fetch_add(1);
+        while (run < runs)
+        {
+            RunEnsembleSeed(worker, base, dancers, classes, statisticsInput, canonicalOrder, seed, run);
+            run = nextRun.fetch_add(1);
+        }
+    });
+
+    SimulationResult result;
+    ClearSimulationResult(result, (int)dancers.size(), (int)classes.size());
+    for (auto& worker : workers)
+    {
+        MergeSimulationResult(result, worker.result);
+    }
+
+    return result;
+}
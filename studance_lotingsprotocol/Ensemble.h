@@ -0,0 +1,11 @@
+#pragma once
+#include <vector>
+#include "Studancer.h"
+#include "DanceClass.h"
+#include "CliArgs.h"
+#include "Simulation.h"
+
+// Solves the MCMF assignment for a number of seeded dancer orders in parallel
+// The network is encoded once, every seed only permutes the dancer nodes and solves it with the path search of MinCostMaxFlow(),
+// so a seed places the same dancers as the real protocol for that order. The outcome counts are in the same format as the lottery simulation.
+SimulationResult EnsembleMinCostMaxFlow(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const StatisticsInput& statisticsInput, const CliArguments& cliArgs, int runs, unsigned int seed);
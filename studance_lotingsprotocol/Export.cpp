@@ -1,98 +1,140 @@
 #include "Export.h"
 #include "Utils.h"
+#include "TaskPool.h"
+#include <algorithm>
+#include <cstring>
 #include <fstream>
-#include <sstream>
-#include <map>
 
-void ExportAssignmentAsTxt(const Assignment& assignment, const std::string& outputName)
+// Copies size bytes to the cursor and returns the position after them
+inline char* AppendBytes(char* cursor, const char* data, size_t size)
+{
+    memcpy(cursor, data, size);
+    return cursor + size;
+}
+
+inline char* AppendBytes(char* cursor, const std::string& data)
+{
+    return AppendBytes(cursor, data.data(), data.size());
+}
+
+// Writes a whole file at once, the sections were already formatted in memory
+// A snapshot of the assignment is written next to it for reloading it with --update
+void WriteExportFile(const Assignment& assignment, const fs::path& outputPath, const std::string& buffer)
 {
-    std::string outputFileName = outputName + ".txt";
-    auto outputPath = GetOutputFolder() / outputFileName;
     std::ofstream outputFile(outputPath);
+    outputFile.write(buffer.data(), (std::streamsize)buffer.size());
+    outputFile.close();
+
+    WriteAssignmentSnapshot(assignment, outputPath, HashExportContent(buffer.data(), buffer.size()));
+
+    Print("Exported to: %s\n\n", outputPath.string().c_str());
+}
+
+void ExportAssignmentAsTxt(const Assignment& assignment, const std::string& outputName)
+{
+    const std::string classEnd = "\n\n\n\n";
 
+    size_t totalSize = 0;
     for (auto& classAssignment : assignment)
     {
-        outputFile << classAssignment.first.name << ":\n";
+        totalSize += classAssignment.first.name.size() + 2 + classEnd.size();
         for (auto& dancer : classAssignment.second)
         {
-            outputFile << dancer.tableRow << "\n";
+            totalSize += dancer.tableRow.size() + 1;
         }
-        outputFile << "\n\n\n\n";
     }
 
-    outputFile.close();
+    std::string buffer(totalSize, '\0');
+    char* cursor = &buffer[0];
+    for (auto& classAssignment : assignment)
+    {
+        cursor = AppendBytes(cursor, classAssignment.first.name);
+        cursor = AppendBytes(cursor, ":\n", 2);
+        for (auto& dancer : classAssignment.second)
+        {
+            cursor = AppendBytes(cursor, dancer.tableRow);
+            *cursor++ = '\n';
+        }
+        cursor = AppendBytes(cursor, classEnd);
+    }
 
-    printf("Exported to: %ls\n\n", outputPath.c_str());
+    std::string outputFileName = outputName + ".txt";
+    WriteExportFile(assignment, GetOutputFolder() / outputFileName, buffer);
 }
 
 void ExportAssignmentAsCsv(const Assignment& assignment, const std::string& outputName)
 {
-    // We need to inject a comma for the dance class
-    std::string header = GetDancersInputHeader();
-
-    int offset = 0;
-    ParseTillNextComma(header, offset);
-
-    std::string preHeader = header.substr(0, offset);
-    std::string postHeader = header.substr(offset, header.length());
-
-    int commas = 1;
-    while (offset < header.length())
+    // We need to inject a comma for the dance class, right after the first field
+    const std::string header = GetDancersInputHeader();
+    const int headerSplit = GetDancersInputHeaderSplit();
+    const int columns = GetDancersInputHeaderColumns();
+
+    const std::string preHeader = header.substr(0, headerSplit);
+    const std::string postHeader = header.substr(headerSplit);
+
+    const std::string emptyRow = std::string(columns, ',') + "\n";
+    const std::string preTotal = ",Totaal:,";
+    const std::string postTotal = std::string(std::max(columns - 2, 0), ',') + "\n";
+    const int emptyRowsAfterClass = 4;
+
+    // Size every class section first, so they can be formatted in parallel straight into one buffer
+    const int numClasses = (int)assignment.size();
+    std::vector<std::string> totals(numClasses);
+    std::vector<size_t> sectionStart(numClasses + 1, 0);
+    for (int i = 0; i < numClasses; i++)
     {
-        ParseTillNextComma(header, offset);
-        commas += 1;
-    }
+        auto& classAssignment = assignment[i];
+        totals[i] = std::to_string(classAssignment.second.size());
 
-    std::string emptyRow = "";
-    for (int i = 0; i < commas; i++)
-    {
-        emptyRow += ",";
-    }
+        size_t size = preHeader.size() + classAssignment.first.name.size() + 1 + postHeader.size() + 1;
+        for (auto& dancer : classAssignment.second)
+        {
+            size += dancer.tableRow.size() + 2;
+        }
+        size += preTotal.size() + totals[i].size() + postTotal.size();
+        size += emptyRowsAfterClass * emptyRow.size();
 
-    std::string preTotal = ",Totaal:,";
-    std::string postTotal = "";
-    for (int i = 0; i < commas - 2; i++)
-    {
-        postTotal += ",";
+        sectionStart[i + 1] = sectionStart[i] + size;
     }
 
-    std::string outputFileName = outputName + ".csv";
-    auto outputPath = GetOutputFolder() / outputFileName;
-    std::ofstream outputFile(outputPath);
+    std::string buffer(sectionStart[numClasses], '\0');
+    GetTaskPool().ParallelFor(numClasses, [&](int i) {
+        auto& classAssignment = assignment[i];
+        char* cursor = &buffer[sectionStart[i]];
 
-    for (auto& classAssignment : assignment)
-    {
-        std::string name = classAssignment.first.name;
-        name[0] = toupper(name[0]);
-        outputFile << preHeader;
-        outputFile << name << ",";
-        outputFile << postHeader << "\n";
+        cursor = AppendBytes(cursor, preHeader);
+        const std::string& name = classAssignment.first.name;
+        if (!name.empty())
+        {
+            *cursor++ = (char)toupper(name[0]);
+            cursor = AppendBytes(cursor, name.data() + 1, name.size() - 1);
+        }
+        *cursor++ = ',';
+        cursor = AppendBytes(cursor, postHeader);
+        *cursor++ = '\n';
 
         for (auto& dancer : classAssignment.second)
         {
-            offset = 0;
-            ParseTillNextComma(dancer.tableRow, offset);
-
-            std::string preDancer = dancer.tableRow.substr(0, offset);
-            std::string postDancer = dancer.tableRow.substr(offset, dancer.tableRow.length());
-
-            // We need to inject a comma for the dance class
-            outputFile << preDancer << "," << postDancer << "\n";
+            const std::string& row = dancer.tableRow;
+            size_t split = std::min((size_t)dancer.tableRowSplit, row.size());
+            cursor = AppendBytes(cursor, row.data(), split);
+            *cursor++ = ',';
+            cursor = AppendBytes(cursor, row.data() + split, row.size() - split);
+            *cursor++ = '\n';
         }
 
-        outputFile << preTotal;
-        outputFile << classAssignment.second.size();
-        outputFile << postTotal << "\n";
-
-        outputFile << emptyRow << "\n";
-        outputFile << emptyRow << "\n";
-        outputFile << emptyRow << "\n";
-        outputFile << emptyRow << "\n";
-    }
+        cursor = AppendBytes(cursor, preTotal);
+        cursor = AppendBytes(cursor, totals[i]);
+        cursor = AppendBytes(cursor, postTotal);
 
-    outputFile.close();
+        for (int row = 0; row < emptyRowsAfterClass; row++)
+        {
+            cursor = AppendBytes(cursor, emptyRow);
+        }
+    });
 
-    printf("Exported to: %ls\n\n", outputPath.c_str());
+    std::string outputFileName = outputName + ".csv";
+    WriteExportFile(assignment, GetOutputFolder() / outputFileName, buffer);
 }
 
 void ExportAssignment(const Assignment& assignment, const std::string& outputName, const CliArguments& cliArgs)
@@ -107,34 +149,93 @@ void ExportAssignment(const Assignment& assignment, const std::string& outputNam
     }
 }
 
-Assignment LoadExportAssignment(const std::string& fileName, const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes)
+void ExportWaitlists(const std::vector<std::vector<WaitlistEntry>>& waitlists, const Assignment& assignment,
+                     const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const std::string& outputName)
 {
-    Assignment result;
+    // Classes every dancer is placed in now
+    std::vector<std::string> placedIn(dancers.size());
+    for (auto& classAssignment : assignment)
+    {
+        for (auto& dancer : classAssignment.second)
+        {
+            std::string& names = placedIn[dancer.index];
+            names += (names.empty() ? "" : " + ") + classAssignment.first.name;
+        }
+    }
 
-    std::string line;
+    auto outputPath = GetOutputFolder() / (outputName + ".csv");
+    std::ofstream outputFile(outputPath);
+    char line[512];
 
-    std::vector<std::string> fileNames = {
-        fileName
-    };
+    for (int classIndex = 0; classIndex < classes.size(); classIndex++)
+    {
+        const std::string& className = classes[classIndex].name;
+        if (className == "niet-dansend lid" || className == "unenrolled")
+        {
+            continue;
+        }
+
+        outputFile << className << "\n";
+        outputFile << "Rank,Relatienummer,Priority group,Choice,Placed in,Cost reduction\n";
+
+        int rank = 1;
+        for (const WaitlistEntry& entry : waitlists[classIndex])
+        {
+            const Studancer& dancer = dancers[entry.dancer];
+            int choiceIndex = (int)(std::find(dancer.chosenClasses.begin(), dancer.chosenClasses.end(), className) - dancer.chosenClasses.begin());
+            snprintf(line, sizeof(line), "%i,%i,%s,%s,%s,%lli\n", rank, dancer.relationNumber,
+                DancerPriorityGroupToString(dancer.priorityGroup).c_str(), ChoiceNumberToString(choiceIndex).c_str(),
+                placedIn[entry.dancer].c_str(), (long long)entry.costReduction);
+            outputFile << line;
+            rank++;
+        }
+        outputFile << "\n\n";
+    }
 
-    std::map<int, Studancer> dancerMap;
-    std::map<std::string, int> classMap;
+    outputFile.close();
 
-    for (auto& dancer : dancers)
+    Print("Exported to: %s\n\n", outputPath.string().c_str());
+}
+
+// Formats the cost change and moved dancers of a seat change as two csv fields
+std::string SeatChangeToString(const SeatChange& change)
+{
+    if (!change.isPossible)
     {
-        dancerMap.emplace(std::make_pair(dancer.relationNumber, dancer));
+        return "n/a,n/a";
     }
+    return std::to_string(change.costChange) + "," + std::to_string(change.dancersMoved);
+}
+
+void ExportSensitivity(const std::vector<ClassSensitivity>& sensitivity, const Assignment& assignment, const std::string& outputName)
+{
+    auto outputPath = GetOutputFolder() / (outputName + ".csv");
+    std::ofstream outputFile(outputPath);
 
-    int classIndex = 0;
-    for (auto& danceClass : classes)
+    outputFile << "Class,Max size,Assigned,One more seat cost change,One more seat dancers moved,One less seat cost change,One less seat dancers moved\n";
+    for (int classIndex = 0; classIndex < assignment.size(); classIndex++)
     {
-        result.push_back(std::make_pair(danceClass, std::vector<Studancer>()));
-        classMap.emplace(std::make_pair(danceClass.name, classIndex));
-        classIndex++;
+        const DanceClass& danceClass = assignment[classIndex].first;
+        if (danceClass.name == "niet-dansend lid" || danceClass.name == "unenrolled")
+        {
+            continue;
+        }
+
+        outputFile << danceClass.name << "," << danceClass.maxSize << "," << assignment[classIndex].second.size() << ","
+            << SeatChangeToString(sensitivity[classIndex].extraSeat) << "," << SeatChangeToString(sensitivity[classIndex].removedSeat) << "\n";
     }
 
-    fs::path assignmentPath;
-    FindOutputFile(fileNames, assignmentPath);
+    outputFile.close();
+
+    Print("Exported to: %s\n\n", outputPath.string().c_str());
+}
+
+// Reads the placements back from the csv, every class section starts with a header line naming the class
+std::vector<AssignmentPlacement> LoadExportPlacementsFromCsv(const fs::path& assignmentPath, const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes)
+{
+    std::string line;
+    std::vector<int> relationNumbers;
+    std::vector<int> placementClasses;
 
     std::ifstream assignmentCsv(assignmentPath);
 
@@ -150,8 +251,26 @@ Assignment LoadExportAssignment(const std::string& fileName, const std::vector<S
 
         if (isHeaderLine)
         {
+            // The export capitalizes the class name
             std::string className = ParseTillNextComma(line, offset);
-            int index = classMap[className];
+            tolower(className);
+            trim(className);
+
+            int index = -1;
+            for (int i = 0; i < classes.size(); i++)
+            {
+                if (classes[i].name == className)
+                {
+                    index = i;
+                    break;
+                }
+            }
+
+            if (index == -1)
+            {
+                printf("ERROR: class %s of %s is not in the input\n", className.c_str(), assignmentPath.string().c_str());
+                exit(-1);
+            }
 
             while (std::getline(assignmentCsv, line))
             {
@@ -161,14 +280,48 @@ Assignment LoadExportAssignment(const std::string& fileName, const std::vector<S
                 {
                     break;
                 }
-                int relationNumber = std::stoi(relationNumberString);
-
-                Studancer dancer = dancerMap[relationNumber];
 
-                result[index].second.push_back(dancer);
+                relationNumbers.push_back(std::stoi(relationNumberString));
+                placementClasses.push_back(index);
             }
         }
     }
 
-    return result;
+    std::vector<int> dancerIndices = FindDancersByRelationNumber(dancers, relationNumbers);
+
+    std::vector<AssignmentPlacement> placements;
+    placements.reserve(relationNumbers.size());
+    for (int i = 0; i < relationNumbers.size(); i++)
+    {
+        if (dancerIndices[i] == -1)
+        {
+            Print("Dancer %i from the existing solution is not in the input anymore\n", relationNumbers[i]);
+            continue;
+        }
+        placements.push_back({ dancerIndices[i], placementClasses[i] });
+    }
+
+    Print("Loaded existing solution from: %s\n", assignmentPath.string().c_str());
+    return placements;
+}
+
+std::vector<AssignmentPlacement> LoadExportPlacements(const std::string& fileName, const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes)
+{
+    std::vector<std::string> fileNames = {
+        fileName
+    };
+
+    fs::path assignmentPath = fileName;
+    if (!fs::exists(assignmentPath))
+    {
+        FindOutputFile(fileNames, assignmentPath);
+    }
+
+    std::vector<AssignmentPlacement> placements;
+    if (LoadAssignmentSnapshot(assignmentPath, dancers, classes, placements))
+    {
+        return placements;
+    }
+
+    return LoadExportPlacementsFromCsv(assignmentPath, dancers, classes);
 }
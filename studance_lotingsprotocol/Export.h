@@ -1,7 +1,17 @@
 #pragma once
 #include "Assignment.h"
 #include "MinCostMaxFlow.h"
+#include "Snapshot.h"
 
 void ExportAssignment(const Assignment& assignment, const std::string& outputName, const CliArguments& cliArgs);
 
-Assignment LoadExportAssignment(const std::string& fileName, const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes);
+// Writes the waiting list of every class to <outputName>.csv, with the classes the dancers are placed in now
+void ExportWaitlists(const std::vector<std::vector<WaitlistEntry>>& waitlists, const Assignment& assignment,
+                     const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const std::string& outputName);
+
+// Writes what one seat more or less in every class does to the assignment to <outputName>.csv
+void ExportSensitivity(const std::vector<ClassSensitivity>& sensitivity, const Assignment& assignment, const std::string& outputName);
+
+// Loads an exported assignment from the output folder, or from fileName itself when that is an existing path
+// The snapshot written next to it is used when it still matches the export, the csv is parsed otherwise
+std::vector<AssignmentPlacement> LoadExportPlacements(const std::string& fileName, const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes);
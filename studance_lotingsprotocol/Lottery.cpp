@@ -1,99 +1,160 @@
 #include "Lottery.h"
 #include "Utils.h"
 #include <random>
+#include <algorithm>
+#include <map>
+#include <numeric>
 
-typedef std::map<std::string, std::pair<DanceClass, std::vector<Studancer>>> LotteryAssignment;
-
-void AssignPriorityGroup(std::vector<Studancer>& group, LotteryAssignment& assignment)
+LotteryInput PrepareLottery(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes)
 {
-    for (auto& dancer : group)
+    LotteryInput input = {};
+    input.numDancers = (int)dancers.size();
+    input.numClasses = (int)classes.size();
+
+    // for easier finding of classes
+    std::map<std::string, int> classMap;
+    input.classId.resize(classes.size());
+    input.classCapacity.resize(classes.size());
+    for (int i = 0; i < classes.size(); i++)
+    {
+        auto inserted = classMap.emplace(classes[i].name, i);
+        input.classId[i] = inserted.first->second;
+        input.classCapacity[i] = classes[input.classId[i]].maxSize;
+    }
+
+    input.choiceStart.push_back(0);
+    input.priorityGroup.resize(dancers.size());
+    input.followsAdvice.resize(dancers.size());
+    for (int d = 0; d < dancers.size(); d++)
     {
+        const Studancer& dancer = dancers[d];
         for (auto& chosenClass : dancer.chosenClasses)
         {
             if (chosenClass == "")
             {
+                input.choices.push_back(-1);
                 continue;
             }
 
-            if (assignment.find(chosenClass) == assignment.end())
+            auto classEntry = classMap.find(chosenClass);
+            if (classEntry == classMap.end())
             {
                 printf("not found: %s", chosenClass.c_str());
                 exit(-1);
             }
-            auto& classAssignment = assignment[chosenClass];
+            input.choices.push_back(classEntry->second);
+        }
+        input.choiceStart.push_back((int)input.choices.size());
+
+        input.priorityGroup[d] = dancer.priorityGroup;
+        input.followsAdvice[d] = dancer.priorityGroup == ExistingMember &&
+            dancer.chosenClasses.size() > 0 &&
+            dancer.chosenClasses[0] != "" &&
+            contains(dancer.advisedClasses, dancer.chosenClasses[0]);
+    }
+
+    return input;
+}
+
+inline void AssignDancer(LotteryState& state, int dancer, int classId)
+{
+    state.remaining[classId]--;
+    state.assignedClass[dancer] = classId;
+    state.placements.push_back(dancer);
+}
+
+void AssignPriorityBucket(const LotteryInput& input, LotteryState& state, int bucket)
+{
+    for (int i = state.bucketStart[bucket]; i < state.bucketEnd[bucket]; i++)
+    {
+        int dancer = state.buckets[i];
+        int firstChoice = input.choiceStart[dancer];
+        for (int choice = firstChoice; choice < input.choiceStart[dancer + 1]; choice++)
+        {
+            int classId = input.choices[choice];
+            if (classId == -1 || (choice == firstChoice && state.firstChoiceCleared[dancer]))
+            {
+                continue;
+            }
 
             // Check if there is space in this class
-            if (classAssignment.second.size() < classAssignment.first.maxSize)
+            if (state.remaining[classId] > 0)
             {
                 // There is space, so assign the dancer
-                classAssignment.second.push_back(dancer);
+                AssignDancer(state, dancer, classId);
                 break;
             }
         }
     }
 }
 
-Assignment Lottery(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes)
+void DrawLottery(const LotteryInput& input, const std::vector<int>& order, std::mt19937& rng, LotteryState& state)
 {
-    std::vector<Studancer> priorityBuckets[DancerPriorityGroup::Count + 1];
-
-    std::vector<Studancer> followingAdvice;
-
-    // NOTE: dancers are already suffled in LoadDancers()
-    for (auto& dancer : dancers)
+    const int numBuckets = DancerPriorityGroup::Count + 1;
+    const int adviceBucket = numBuckets;
+
+    state.remaining = input.classCapacity;
+    state.firstChoiceCleared.assign(input.numDancers, 0);
+    state.assignedClass.assign(input.numDancers, -1);
+    state.placements.clear();
+    state.placements.reserve(input.numDancers);
+
+    // Count the bucket sizes, the ExistingMember bucket keeps room for the dancers following advice that do not fit
+    state.bucketStart.assign(numBuckets + 1, 0);
+    state.bucketEnd.assign(numBuckets + 1, 0);
+    for (int dancer : order)
     {
-        if (dancer.priorityGroup == ExistingMember &&
-            dancer.chosenClasses.size() > 0 &&
-            dancer.chosenClasses[0] != "" &&
-            contains(dancer.advisedClasses, dancer.chosenClasses[0]))
+        int bucket = input.followsAdvice[dancer] ? adviceBucket : input.priorityGroup[dancer];
+        state.bucketEnd[bucket]++;
+        if (bucket == adviceBucket)
         {
-            followingAdvice.push_back(dancer);
-        }
-        else
-        {
-            priorityBuckets[dancer.priorityGroup].push_back(dancer);
+            state.bucketEnd[ExistingMember]++;
         }
     }
+    int start = 0;
+    for (int bucket = 0; bucket <= numBuckets; bucket++)
+    {
+        int size = state.bucketEnd[bucket];
+        state.bucketStart[bucket] = start;
+        state.bucketEnd[bucket] = start;
+        start += size;
+    }
 
-    // for easier finding of classes
-    LotteryAssignment assignment;
-    for (int i = 0; i < classes.size(); i++)
+    // NOTE: the order is the shuffle, so filling the buckets in order keeps it within every bucket
+    state.buckets.resize(start);
+    for (int dancer : order)
     {
-        assignment.emplace(std::make_pair(classes[i].name, std::make_pair(classes[i], std::vector<Studancer>())));
+        int bucket = input.followsAdvice[dancer] ? adviceBucket : input.priorityGroup[dancer];
+        state.buckets[state.bucketEnd[bucket]++] = dancer;
     }
 
     // Assign board and damn
     for (int p = 0; p <= DancerPriorityGroup::Damn; p++)
     {
-        AssignPriorityGroup(priorityBuckets[p], assignment);
+        AssignPriorityBucket(input, state, p);
     }
 
     // Special case: Existing members following advice
     {
         bool reshuffle = false;
-        for (auto& dancer : followingAdvice)
+        for (int i = state.bucketStart[adviceBucket]; i < state.bucketEnd[adviceBucket]; i++)
         {
-            std::string chosenClass = dancer.chosenClasses[0];
-            if (chosenClass == "")
-            {
-                continue;
-            }
-
-            auto& classAssignment = assignment[chosenClass];
+            int dancer = state.buckets[i];
+            int classId = input.choices[input.choiceStart[dancer]];
 
             // Check if there is space in this class
-            if (classAssignment.second.size() < classAssignment.first.maxSize)
+            if (state.remaining[classId] > 0)
             {
                 // There is space, so assign the dancer
-                classAssignment.second.push_back(dancer);
+                AssignDancer(state, dancer, classId);
             }
             else
             {
                 // Disable this dancer from trying to pick this class again
-                dancer.chosenClasses[0] = "";
+                state.firstChoiceCleared[dancer] = 1;
 
                 // Reinsert this dancer
-                priorityBuckets[DancerPriorityGroup::ExistingMember].push_back(dancer);
+                state.buckets[state.bucketEnd[ExistingMember]++] = dancer;
 
                 reshuffle = true;
             }
@@ -103,27 +164,87 @@ Assignment Lottery(const std::vector<Studancer>& dancers, const std::vector<Danc
         {
             // Reshuffle the ExistingMember prio group again, because otherwise the 'following advice' people will always
             // be at the back of the buffer.
-            std::random_device rd;
-            std::mt19937 g(rd());
-            std::shuffle(priorityBuckets[DancerPriorityGroup::ExistingMember].begin(), priorityBuckets[DancerPriorityGroup::ExistingMember].end(), g);
+            std::shuffle(state.buckets.begin() + state.bucketStart[ExistingMember], state.buckets.begin() + state.bucketEnd[ExistingMember], rng);
         }
     }
 
     // Assign other priority groups
     for (int p = DancerPriorityGroup::ExistingMember; p <= DancerPriorityGroup::Count; p++)
     {
-        AssignPriorityGroup(priorityBuckets[p], assignment);
+        AssignPriorityBucket(input, state, p);
     }
+}
 
-    // Create final assignment type
-    Assignment finalAssignment;
-    for (auto& danceClass : classes)
+int GetLotteryChoiceRank(const LotteryInput& input, int dancer, int classId)
+{
+    int firstChoice = input.choiceStart[dancer];
+    for (int choice = firstChoice; choice < input.choiceStart[dancer + 1] && choice - firstChoice < 3; choice++)
     {
-        finalAssignment.push_back(assignment[danceClass.name]);
+        if (input.choices[choice] == classId)
+        {
+            return choice - firstChoice;
+        }
     }
+    return 3;
+}
 
-    printf("Assigned everyone\n");
+Assignment Lottery(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes)
+{
+    std::random_device rd;
+    std::mt19937 g(rd());
+    return Lottery(dancers, classes, g);
+}
+
+Assignment Lottery(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, std::mt19937& rng)
+{
+    LotteryInput input = PrepareLottery(dancers, classes);
+
+    // NOTE: dancers are already suffled in LoadDancers()
+    std::vector<int> order(dancers.size());
+    for (int i = 0; i < order.size(); i++)
+    {
+        order[i] = i;
+    }
 
+    LotteryState state;
+    DrawLottery(input, order, rng, state);
+
+    // Create final assignment type, dancers are listed in the order they were assigned
+    std::vector<std::vector<Studancer>> assignedDancers(classes.size());
+    for (int dancer : state.placements)
+    {
+        Studancer assignedDancer = dancers[dancer];
+        if (state.firstChoiceCleared[dancer])
+        {
+            assignedDancer.chosenClasses[0] = "";
+        }
+        assignedDancers[state.assignedClass[dancer]].push_back(assignedDancer);
+    }
+
+    Assignment finalAssignment;
+    for (int i = 0; i < classes.size(); i++)
+    {
+        int classId = input.classId[i];
+        finalAssignment.push_back(std::make_pair(classes[classId], assignedDancers[classId]));
+    }
 
     return finalAssignment;
 }
+
+std::vector<AssignmentPlacement> LotteryPlacements(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, std::mt19937& rng)
+{
+    LotteryInput input = PrepareLottery(dancers, classes);
+
+    std::vector<int> order(dancers.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    LotteryState state;
+    DrawLottery(input, order, rng, state);
+
+    std::vector<AssignmentPlacement> placements;
+    for (int dancer : state.placements)
+    {
+        placements.push_back({ dancer, state.assignedClass[dancer] });
+    }
+    return placements;
+}
@@ -2,6 +2,49 @@
 #include "DanceClass.h"
 #include "Studancer.h"
 #include "Assignment.h"
+#include "Snapshot.h"
 #include <vector>
+#include <random>
 
 Assignment Lottery(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes);
+
+// Same as above, but draws the reshuffle of the ExistingMember group from the given generator
+Assignment Lottery(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, std::mt19937& rng);
+
+// The dancers and classes of a lottery translated to integer ids once, so it can be drawn many times
+// without looking up class names or copying dancers
+struct LotteryInput
+{
+    int numDancers;
+    int numClasses;
+    std::vector<int> classId;               // class index -> id, classes with the same name share the id of the first one
+    std::vector<int> classCapacity;         // max size per class id
+    std::vector<int> choiceStart;           // choices of dancer d are choices[choiceStart[d]] until choices[choiceStart[d + 1]]
+    std::vector<int> choices;               // class id per choice in order of preference, -1 for an empty choice
+    std::vector<int> priorityGroup;         // per dancer
+    std::vector<char> followsAdvice;        // per dancer, ExistingMember whose first choice was advised
+};
+
+// Buffers of a single draw, reused by the next draw so drawing does not allocate
+struct LotteryState
+{
+    std::vector<int> remaining;             // remaining space per class id
+    std::vector<int> bucketStart;           // start of every priority bucket in buckets
+    std::vector<int> bucketEnd;
+    std::vector<int> buckets;               // dancers per priority bucket, followed by the dancers following advice
+    std::vector<char> firstChoiceCleared;   // per dancer, the advised first choice was full so it is skipped
+    std::vector<int> assignedClass;         // class id per dancer, -1 when unassigned
+    std::vector<int> placements;            // dancers in the order they were assigned
+};
+
+LotteryInput PrepareLottery(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes);
+
+// Draws the lottery with the dancers in the given order (position -> dancer), the order takes the place of the
+// shuffle of LoadDancers(). Gives the same assignment as Lottery() on the dancers in that order with the same generator
+void DrawLottery(const LotteryInput& input, const std::vector<int>& order, std::mt19937& rng, LotteryState& state);
+
+// Rank of the class id in the choices of the dancer, 0-2 for the 1st-3rd choice and 3 for anything else
+int GetLotteryChoiceRank(const LotteryInput& input, int dancer, int classId);
+
+// Draws a single lottery and returns the class of every placed dancer, in the order they were placed
+std::vector<AssignmentPlacement> LotteryPlacements(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, std::mt19937& rng);
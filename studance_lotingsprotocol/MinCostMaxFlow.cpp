@@ -1,7 +1,12 @@
 #include "MinCostMaxFlow.h"
 #include "Utils.h"
 #include "Export.h"
+#include "TaskPool.h"
+#include "Presolve.h"
 #include <algorithm>
+#include <climits>
+#include <numeric>
+#include <atomic>
 #include <cstring>
 #include <queue>
 #include <utility>
@@ -9,6 +14,7 @@
 #include <fstream>
 #include <filesystem>
 #include <chrono>
+#include <functional>
 
 #define MAXN 1000
 
@@ -27,19 +33,25 @@ inline void DumpBuffer(const MinCostMaxFlowArgs& args)
 
     std::ofstream output(path, std::ios::out | std::ios::binary | std::ios::app);
 
-    int offsets[4] = {
-        args.sourceNode,
-        args.sinkNode,
-        args.numNodes,
-        args.bufferDwords
+    // The arrays are aligned inside the arena, so their offsets (in dwords) are part of the header
+    const char* data = args.arena->GetData();
+    uint64_t offsets[10] = {
+        (uint64_t)args.sourceNode,
+        (uint64_t)args.sinkNode,
+        (uint64_t)args.numNodes,
+        (uint64_t)(args.arena->GetUsed() / sizeof(int)),
+        (uint64_t)((const char*)args.distance - data) / sizeof(int),
+        (uint64_t)((const char*)args.potential - data) / sizeof(int),
+        (uint64_t)((const char*)args.parent - data) / sizeof(int),
+        (uint64_t)((const char*)args.flow - data) / sizeof(int),
+        (uint64_t)((const char*)args.cost - data) / sizeof(int),
+        (uint64_t)((const char*)args.capacity - data) / sizeof(int)
     };
 
     const char* offsetData = (const char*)&offsets[0];
-    output.write(offsetData, 4 * sizeof(int));
+    output.write(offsetData, sizeof(offsets));
 
-    const char* data = (const char*) args.buffer;
-
-    output.write(data, args.bufferDwords * sizeof(args.cost[0]));
+    output.write(data, args.arena->GetUsed());
 
     output.close();
 }
@@ -97,7 +109,7 @@ inline NodeType GetNodeType(const MinCostMaxFlowArgs& args, int node)
     }
 }
 
-inline std::string GetNodeName(const MinCostMaxFlowArgs& args, int node)
+std::string GetNodeName(const MinCostMaxFlowArgs& args, int node)
 {
     NodeType nodeType = GetNodeType(args, node);
     if (nodeType == Source)
@@ -106,7 +118,13 @@ inline std::string GetNodeName(const MinCostMaxFlowArgs& args, int node)
     }
     else if (nodeType == Dancer)
     {
-        return std::to_string(args.dancers->operator[](node - args.dancerOffset).relationNumber);
+        // Slots reserved by AddDancer() have no dancer yet
+        int dancerIndex = node - args.dancerOffset;
+        if (dancerIndex >= (int)args.dancers->size())
+        {
+            return "Free dancer slot " + std::to_string(dancerIndex);
+        }
+        return std::to_string(args.dancers->operator[](dancerIndex).relationNumber);
     }
     else if (nodeType == Class)
     {
@@ -160,6 +178,12 @@ inline const Studancer& GetDancerFromNode(const MinCostMaxFlowArgs& args, int no
     return args.dancers->operator[](node - args.dancerOffset);
 }
 
+// Index of the arc u -> v in the numNodes * numNodes arrays, computed in size_t as it does not fit an int for large networks
+inline size_t ArcIndex(const MinCostMaxFlowArgs& args, int u, int v)
+{
+    return (size_t)u * (size_t)args.numNodes + (size_t)v;
+}
+
 // inline functions for bidirectional accesses
 inline int64_t GetDistance(const MinCostMaxFlowArgs& args, int u)
 {
@@ -213,7 +237,7 @@ inline int GetFlow(const MinCostMaxFlowArgs& args, int u, int v)
         DumpBuffer(args);
         exit(-1);
     }
-    return args.flow[u * args.numNodes + v];
+    return args.flow[ArcIndex(args, u, v)];
 }
 inline void SetFlow(MinCostMaxFlowArgs& args, int u, int v, int value)
 {
@@ -223,7 +247,7 @@ inline void SetFlow(MinCostMaxFlowArgs& args, int u, int v, int value)
         DumpBuffer(args);
         exit(-1);
     }
-    args.flow[u * args.numNodes + v] = value;
+    args.flow[ArcIndex(args, u, v)] = value;
 }
 inline void AddFlow(MinCostMaxFlowArgs& args, int u, int v, int value)
 {
@@ -233,7 +257,7 @@ inline void AddFlow(MinCostMaxFlowArgs& args, int u, int v, int value)
         DumpBuffer(args);
         exit(-1);
     }
-    args.flow[u * args.numNodes + v] += value;
+    args.flow[ArcIndex(args, u, v)] += value;
 }
 inline int64_t GetCost(const MinCostMaxFlowArgs& args, int u, int v)
 {
@@ -243,7 +267,7 @@ inline int64_t GetCost(const MinCostMaxFlowArgs& args, int u, int v)
         DumpBuffer(args);
         exit(-1);
     }
-    return args.cost[u * args.numNodes + v];
+    return args.cost[ArcIndex(args, u, v)];
 }
 inline void SetCost(MinCostMaxFlowArgs& args, int u, int v, int64_t value)
 {
@@ -253,7 +277,7 @@ inline void SetCost(MinCostMaxFlowArgs& args, int u, int v, int64_t value)
         DumpBuffer(args);
         exit(-1);
     }
-    args.cost[u * args.numNodes + v] = value;
+    args.cost[ArcIndex(args, u, v)] = value;
 }
 inline int GetCapacity(const MinCostMaxFlowArgs& args, int u, int v)
 {
@@ -263,7 +287,7 @@ inline int GetCapacity(const MinCostMaxFlowArgs& args, int u, int v)
         DumpBuffer(args);
         exit(-1);
     }
-    return args.capacity[u * args.numNodes + v];
+    return args.capacity[ArcIndex(args, u, v)];
 }
 inline void SetCapacity(MinCostMaxFlowArgs& args, int u, int v, int value)
 {
@@ -273,7 +297,7 @@ inline void SetCapacity(MinCostMaxFlowArgs& args, int u, int v, int value)
         DumpBuffer(args);
         exit(-1);
     }
-    args.capacity[u * args.numNodes + v] = value;
+    args.capacity[ArcIndex(args, u, v)] = value;
 }
 inline int CanFlow(const MinCostMaxFlowArgs& args, int u, int v)
 {
@@ -285,16 +309,16 @@ inline int CanFlow(const MinCostMaxFlowArgs& args, int u, int v)
     }
     return GetFlow(args, u, v) < GetCapacity(args, u, v);
 }
-inline void InitArray(int* array, int value, int numElements)
+inline void InitArray(int* array, int value, size_t numElements)
 {
-    for (int i = 0; i < numElements; i++)
+    for (size_t i = 0; i < numElements; i++)
     {
         array[i] = value;
     }
 }
-inline void InitArray64(int64_t* array, int64_t value, int numElements)
+inline void InitArray64(int64_t* array, int64_t value, size_t numElements)
 {
-    for (int i = 0; i < numElements; i++)
+    for (size_t i = 0; i < numElements; i++)
     {
         array[i] = value;
     }
@@ -423,17 +447,347 @@ std::pair<int64_t, int> BellmanFord(MinCostMaxFlowArgs& args, bool debug = false
     return std::make_pair(GetDistance(args, args.sinkNode), args.sinkNode);
 }
 
+// The shortest distances of a search are valid potentials for the residual graph it searched
+inline void StoreDistancesAsPotentials(MinCostMaxFlowArgs& args)
+{
+    for (int node = 0; node < args.numNodes; node++)
+    {
+        // Unreachable nodes stay unreachable after augmenting, so their potential does not matter
+        if (args.distance[node] != INF64)
+        {
+            args.potential[node] = args.distance[node];
+        }
+    }
+}
+
+// Pushes one unit of flow from startNode to endNode along the parent pointers and returns the cost of the path
+// The nodes of the path are added from end to start to changedNodes when it is given
+int64_t AugmentAlongParents(MinCostMaxFlowArgs& args, std::vector<int>* changedNodes, int startNode, int endNode)
+{
+    int64_t pathCost = 0;
+
+    int currentNode = endNode;
+    while (currentNode != startNode)
+    {
+        if (changedNodes)
+        {
+            changedNodes->push_back(currentNode);
+        }
+        int p = GetParent(args, currentNode);
+
+        // Update flow in both the normal and residual graph
+        if (GetCapacity(args, p, currentNode) > 0)
+        {
+            // normal graph
+            AddFlow(args, p, currentNode, 1);
+            pathCost += GetCost(args, p, currentNode);
+        }
+        else
+        {
+            // residual graph
+            AddFlow(args, currentNode, p, -1);
+            pathCost -= GetCost(args, currentNode, p);
+        }
+
+        currentNode = p;
+    }
+
+    if (changedNodes)
+    {
+        changedNodes->push_back(startNode);
+    }
+
+    return pathCost;
+}
+
+// Pushes one unit of flow from the source to the sink along the parent pointers and returns the cost of the path
+int64_t AugmentAlongParents(MinCostMaxFlowArgs& args, std::vector<int>* changedNodes)
+{
+    return AugmentAlongParents(args, changedNodes, args.sourceNode, args.sinkNode);
+}
+
+bool ComputePotentials(MinCostMaxFlowArgs& args)
+{
+    std::pair<int64_t, int> bfOutput = BellmanFord(args);
+    if (bfOutput.first == -INF64)
+    {
+        return false;
+    }
+
+    StoreDistancesAsPotentials(args);
+    return true;
+}
+
+// Arc of the residual graph, used by the cycle search
+struct ResidualArc
+{
+    int from;
+    int to;
+    int64_t cost;
+};
+
+// Collects every arc with room left in the normal graph and every arc that can cancel flow in the residual graph
+// Arcs back into the source are only collected with intoSource, cycles through them give the seat of one dancer to another
+void CollectResidualArcs(const MinCostMaxFlowArgs& args, std::vector<ResidualArc>& arcs, bool intoSource = false)
+{
+    arcs.clear();
+    for (int currentNode = 0; currentNode < args.numNodes; currentNode++)
+    {
+        for (int neighbour : args.adjecencyList[currentNode])
+        {
+            if (CanFlow(args, currentNode, neighbour))
+            {
+                arcs.push_back({ currentNode, neighbour, GetCost(args, currentNode, neighbour) });
+            }
+
+            // Like the shortest path searches, flow is normally never sent back into the source
+            if ((intoSource || neighbour != args.sourceNode) && GetFlow(args, neighbour, currentNode) > 0)
+            {
+                arcs.push_back({ currentNode, neighbour, -GetCost(args, neighbour, currentNode) });
+            }
+        }
+    }
+}
+
+// Karp's algorithm, finds the cycle with the lowest mean cost in the residual graph
+// Returns false when there is no cycle with a negative cost, otherwise cycle holds its nodes with the first node repeated at the end
+// walkDistance and walkParent are scratch space of (numNodes + 1) * numNodes elements
+bool FindMinimumMeanCycle(const MinCostMaxFlowArgs& args, const std::vector<ResidualArc>& arcs, std::vector<int64_t>& walkDistance,
+                          std::vector<int>& walkParent, std::vector<int>& cycle)
+{
+    const size_t n = (size_t)args.numNodes;
+
+    // walkDistance[k * n + v] is the cheapest walk of exactly k arcs ending in v, starting anywhere
+    std::fill(walkDistance.begin(), walkDistance.begin() + n, 0);
+    std::fill(walkDistance.begin() + n, walkDistance.end(), INF64);
+    for (size_t k = 1; k <= n; k++)
+    {
+        const int64_t* previous = &walkDistance[(k - 1) * n];
+        int64_t* current = &walkDistance[k * n];
+        int* parent = &walkParent[k * n];
+        for (const ResidualArc& arc : arcs)
+        {
+            if (previous[arc.from] != INF64 && previous[arc.from] + arc.cost < current[arc.to])
+            {
+                current[arc.to] = previous[arc.from] + arc.cost;
+                parent[arc.to] = arc.from;
+            }
+        }
+    }
+
+    // The minimum mean is the lowest over all nodes of the highest (D_n(v) - D_k(v)) / (n - k)
+    int bestNode = -1;
+    double bestMean = 0.0;
+    const int64_t* last = &walkDistance[n * n];
+    for (size_t v = 0; v < n; v++)
+    {
+        if (last[v] == INF64)
+        {
+            continue;
+        }
+
+        double worstMean = -(double)INF64;
+        for (size_t k = 0; k < n; k++)
+        {
+            const int64_t distance = walkDistance[k * n + v];
+            if (distance != INF64)
+            {
+                worstMean = std::max(worstMean, (double)(last[v] - distance) / (double)(n - k));
+            }
+        }
+
+        if (worstMean < bestMean)
+        {
+            bestMean = worstMean;
+            bestNode = (int)v;
+        }
+    }
+
+    if (bestNode == -1)
+    {
+        return false;
+    }
+
+    // The walk of n arcs to the best node repeats a node, the part between the repeats is a minimum mean cycle
+    std::vector<int> walk(n + 1);
+    walk[n] = bestNode;
+    for (size_t k = n; k > 0; k--)
+    {
+        walk[k - 1] = walkParent[k * n + walk[k]];
+    }
+
+    std::vector<int> seenAt(n, -1);
+    for (int k = (int)n; k >= 0; k--)
+    {
+        int node = walk[k];
+        if (seenAt[node] != -1)
+        {
+            cycle.assign(walk.begin() + k, walk.begin() + seenAt[node] + 1);
+            return true;
+        }
+        seenAt[node] = k;
+    }
+
+    return false;
+}
+
+// Bellman-Ford from a virtual node with a zero cost arc to every node, stops at the first cycle in the parent pointers
+// Every cycle in the parent pointers has a negative cost, so this usually finds one after a few passes instead of numNodes
+// Returns false when there is no cycle with a negative cost, the distances are then valid potentials
+bool FindNegativeCycle(MinCostMaxFlowArgs& args, const std::vector<ResidualArc>& arcs, std::vector<int>& cycle)
+{
+    InitArray64(args.distance, 0, args.numNodes);
+    InitArray(args.parent, -1, args.numNodes);
+    std::vector<int> visitedFrom(args.numNodes);
+
+    for (int bfIteration = 0; bfIteration <= args.numNodes; bfIteration++)
+    {
+        bool hadUpdate = false;
+        for (const ResidualArc& arc : arcs)
+        {
+            if (args.distance[arc.from] + arc.cost < args.distance[arc.to])
+            {
+                args.distance[arc.to] = args.distance[arc.from] + arc.cost;
+                args.parent[arc.to] = arc.from;
+                hadUpdate = true;
+            }
+        }
+
+        if (!hadUpdate)
+        {
+            return false;
+        }
+
+        // Walk the parent pointers from every node, a walk that meets itself is a cycle
+        std::fill(visitedFrom.begin(), visitedFrom.end(), -1);
+        for (int start = 0; start < args.numNodes; start++)
+        {
+            int node = start;
+            while (node != -1 && visitedFrom[node] == -1)
+            {
+                visitedFrom[node] = start;
+                node = args.parent[node];
+            }
+
+            if (node != -1 && visitedFrom[node] == start)
+            {
+                // Parents point backwards, so the walk gives the cycle in reverse
+                cycle.clear();
+                int cycleNode = node;
+                do
+                {
+                    cycle.push_back(cycleNode);
+                    cycleNode = args.parent[cycleNode];
+                } while (cycleNode != node);
+                cycle.push_back(node);
+                std::reverse(cycle.begin(), cycle.end());
+                return true;
+            }
+        }
+    }
+
+    printf("ERROR: Bellman-Ford did not converge, but found no cycle in the parent pointers\n");
+    exit(-1);
+}
+
+// Pushes as much flow around the cycle as its tightest arc allows and logs it as a CycleCancel decision
+// cycle holds its nodes with the first node repeated at the end, returns the change in cost of the flow
+int64_t CancelCycle(MinCostMaxFlowArgs& args, const std::vector<int>& cycle)
+{
+    int amount = INF;
+    int64_t cycleCost = 0;
+    for (size_t i = 0; i + 1 < cycle.size(); i++)
+    {
+        int u = cycle[i];
+        int v = cycle[i + 1];
+        if (GetCapacity(args, u, v) > 0)
+        {
+            amount = std::min(amount, GetCapacity(args, u, v) - GetFlow(args, u, v));
+            cycleCost += GetCost(args, u, v);
+        }
+        else
+        {
+            amount = std::min(amount, GetFlow(args, v, u));
+            cycleCost -= GetCost(args, v, u);
+        }
+    }
+
+    if (cycleCost >= 0 || amount <= 0)
+    {
+        printf("ERROR: found a cycle of cost %lli with room for %i flow while cancelling negative cycles\n", (long long)cycleCost, amount);
+        DumpBuffer(args);
+        exit(-1);
+    }
+
+    Decision decision = {};
+    decision.type = CycleCancel;
+    for (size_t i = 0; i + 1 < cycle.size(); i++)
+    {
+        int u = cycle[i];
+        int v = cycle[i + 1];
+        if (GetCapacity(args, u, v) > 0)
+        {
+            AddFlow(args, u, v, amount);
+        }
+        else
+        {
+            AddFlow(args, v, u, -amount);
+        }
+    }
+
+    // Nodes are logged from the end to the start, like the paths of AssignDancer
+    decision.changedNodes.assign(cycle.rbegin(), cycle.rend());
+    decision.costChange = cycleCost * amount;
+    args.decisions.push_back(decision);
+
+    return decision.costChange;
+}
+
+int64_t CancelNegativeCycles(MinCostMaxFlowArgs& args, bool intoSource)
+{
+    const size_t n = (size_t)args.numNodes;
+    std::vector<ResidualArc> arcs;
+    std::vector<int64_t> walkDistance((n + 1) * n);
+    std::vector<int> walkParent((n + 1) * n, -1);
+    std::vector<int> cycle;
+
+    int64_t totalCostChange = 0;
+    while (true)
+    {
+        CollectResidualArcs(args, arcs, intoSource);
+        if (!FindMinimumMeanCycle(args, arcs, walkDistance, walkParent, cycle))
+        {
+            break;
+        }
+
+        totalCostChange += CancelCycle(args, cycle);
+    }
+
+    return totalCostChange;
+}
+
 std::pair<int64_t, int> MinCostMaxFlow(MinCostMaxFlowArgs& args, const CliArguments& cliArgs) {
 
     int64_t minCost = 0;
     int maxFlow = 0;
 
+    // A loaded solution was optimal for the old input, after late registrations or capacity changes dancers
+    // can often be moved to better choices. Those moves are cycles the search from the source cannot reach
+    if (cliArgs.isUpdate)
+    {
+        minCost += CancelNegativeCycles(args);
+    }
+
     // first stores distance, second stores node
     std::pair<int64_t, int> bfOutput = BellmanFord(args);
+    if (bfOutput.first != -INF64)
+    {
+        StoreDistancesAsPotentials(args);
+    }
 
     std::chrono::system_clock::time_point start = {};
 
-    printf("Assigned:\n");
+    Print("Assigned:\n");
     while (bfOutput.first < INF64) {
 
         Decision decision = {};
@@ -447,29 +801,7 @@ std::pair<int64_t, int> MinCostMaxFlow(MinCostMaxFlowArgs& args, const CliArgume
 
             int64_t initialCost = minCost;
 
-            int currentNode = args.sinkNode;
-            while (currentNode != args.sourceNode)
-            {
-                decision.changedNodes.push_back(currentNode);
-                int p = GetParent(args, currentNode);
-
-                // Update flow in both the normal and residual graph
-                if (GetCapacity(args, p, currentNode) > 0)
-                {
-                    // normal graph
-                    AddFlow(args, p, currentNode, 1);
-                    minCost += GetCost(args, p, currentNode);
-                }
-                else
-                {
-                    // residual graph
-                    AddFlow(args, currentNode, p, -1);
-                    minCost -= GetCost(args, currentNode, p);
-                }
-
-                currentNode = p;
-            }
-            decision.changedNodes.push_back(args.sourceNode);
+            minCost += AugmentAlongParents(args, &decision.changedNodes);
 
             for (int node = 1; node < args.sinkNode; node++)
             {
@@ -510,11 +842,6 @@ std::pair<int64_t, int> MinCostMaxFlow(MinCostMaxFlowArgs& args, const CliArgume
 
                     printf("\nFailed flow conservation for node %i with NodeType %s and Name %s after updating path:\n", node, nodeTypeName.c_str(), nodeName.c_str());
 
-                    currentNode = args.sinkNode;
-                    NodeType currentNodeType = GetNodeType(args, currentNode);
-                    std::string currentNodeTypeName = NodeTypeToString(currentNodeType);
-                    std::string currentNodeName = GetNodeName(args, currentNode);
-
                     // reverse the path
                     std::vector<int> path;
                     for (int i = (int)decision.changedNodes.size() - 1; i > 0; i--)
@@ -535,9 +862,9 @@ std::pair<int64_t, int> MinCostMaxFlow(MinCostMaxFlowArgs& args, const CliArgume
             decision.costChange += (minCost - initialCost);
             maxFlow++;
 
-            // update terminal every so often
+            // update terminal every so often, progress is left out of buffered output
             auto duration = std::chrono::system_clock::now() - start;
-            if (std::chrono::duration_cast<std::chrono::milliseconds>(duration).count() > 200)
+            if (!IsOutputBuffered() && std::chrono::duration_cast<std::chrono::milliseconds>(duration).count() > 200)
             {
                 float percentageAssigned = ((float)maxFlow / (float)args.expectedMaxFlow) * 100.f;
                 printf("\r%.2f%%", percentageAssigned);
@@ -546,394 +873,320 @@ std::pair<int64_t, int> MinCostMaxFlow(MinCostMaxFlowArgs& args, const CliArgume
         }
         else
         {
-            // TODO negative cycles,
-            int currentNode = bfOutput.second;
-            std::vector<int> seenNodes;
-            seenNodes.push_back(currentNode);
-            int currentParent = GetParent(args, currentNode);
-
-            while (!contains(seenNodes, currentParent))
-            {
-                seenNodes.push_back(currentParent);
-                currentNode = currentParent;
-                currentParent = GetParent(args, currentNode);
-            }
-            seenNodes.push_back(seenNodes[0]);
-            std::reverse(seenNodes.begin(), seenNodes.end());
+            // The flow loaded for --update can be improved by moving dancers around without changing the flow,
+            // which shows up as negative cycles in the residual graph. Cancel them and continue augmenting from there
+            minCost += CancelNegativeCycles(args);
 
-            printf("\n");
-            int currentCost = 0;
-            printf("Found Cycle: %i (%i) (%s)", seenNodes[0], currentCost, GetNodeName(args, seenNodes[0]).c_str());
-            for (int i = 1; i < seenNodes.size(); i++)
+            bfOutput = BellmanFord(args);
+            if (bfOutput.first == -INF64)
             {
-                currentCost += seenNodes[i - 1] < seenNodes[i] ? GetCost(args, seenNodes[i - 1], seenNodes[i]) : -GetCost(args, seenNodes[i], seenNodes[i - 1]);
-                printf(", %i (%i) (%s)", seenNodes[i], currentCost, GetNodeName(args, seenNodes[i]).c_str());
+                printf("\nERROR: negative cycle left after cancelling cycles\n");
+                DumpBuffer(args);
+                exit(-1);
             }
-
-            printf("\n");
-
-            DumpBuffer(args);
-            exit(-1);
+            StoreDistancesAsPotentials(args);
+            continue;
         }
 
         args.decisions.push_back(decision);
 
         bfOutput = BellmanFord(args);
+        if (bfOutput.first != -INF64)
+        {
+            StoreDistancesAsPotentials(args);
+        }
     }
 
     // final update for terminal
-    printf("\r%.2f%%", 100.0f);
+    Print("\r%.2f%%", 100.0f);
     // Create spacing for the rest of the program
-    printf("\n\n");
+    Print("\n\n");
     //printf("%llu", minCost);
     //printf("\n\n");
 
     return std::make_pair(minCost, maxFlow);
 }
 
-MinCostMaxFlowArgs AllocateMinCostMaxFlow(int numNodes)
+std::pair<int64_t, int> BellmanFordShortestPaths(MinCostMaxFlowArgs& args)
 {
-    // space computation
-    int spaceRequired = 0;
-
-    // distances space
-    int distancesOffset = spaceRequired;
-    spaceRequired += numNodes * 2; // 64 bit
-
-    // parent space
-    int parentOffset = spaceRequired;
-    spaceRequired += numNodes;
-
-    // flow space
-    int flowOffset = spaceRequired;
-    spaceRequired += numNodes * numNodes;
-
-    // cost space
-    int costOffset = spaceRequired;
-    spaceRequired += numNodes * numNodes * 2; // 64 bit
-
-    // capacity space
-    int capacityOffset = spaceRequired;
-    spaceRequired += numNodes * numNodes;
-
-    // we have a single array for all data of the network
-    int* buffer = new int[spaceRequired];
-    InitArray(buffer, 0, spaceRequired);
+    int64_t minCost = 0;
+    int maxFlow = 0;
 
-    MinCostMaxFlowArgs args = {};
-    args.sourceNode = 0;
-    args.sinkNode = numNodes - 1;
-    args.numNodes = numNodes;
-    args.adjecencyList = new std::vector<int>[numNodes];
-    args.cost = (int64_t*)&buffer[costOffset];
-    args.capacity = &buffer[capacityOffset];
-    args.distance = (int64_t*)&buffer[distancesOffset];
-    args.parent = &buffer[parentOffset];
-    args.flow = &buffer[flowOffset];
-    args.bufferDwords = spaceRequired;
-    args.buffer = buffer;
+    std::pair<int64_t, int> bfOutput = BellmanFord(args);
+    while (bfOutput.first != -INF64 && bfOutput.first < INF64)
+    {
+        minCost += AugmentAlongParents(args, nullptr);
+        maxFlow++;
+        bfOutput = BellmanFord(args);
+    }
 
-    return args;
+    return std::make_pair(minCost, maxFlow);
 }
 
-int64_t GetChoiceCostForDancer(const Studancer& dancer, const std::string& chosenClass, int choiceNumber)
+// Dijkstra on reduced costs from startNode into distance and parent, ties in distance are popped lowest node first
+// Arcs back into startNode are skipped, so an arc that was just given room back to it does not corrupt the search
+// Arcs into skipNode are skipped too. The network is only read, so searches with their own arrays can run at the same time
+void SearchReducedCosts(const MinCostMaxFlowArgs& args, int startNode, int skipNode, int64_t* distance, int* parent)
 {
-    if (chosenClass == "unenrolled")
-    {
-        choiceNumber = 3;
-    }
-    // Layout is:
-    //    [0-2]: 1st - 3rd choice
-    //    [3]  : unrolled cost
-    // If someone decides not to enroll for 3 classes, the choice to unroll them is made earlier
-    int64_t boardAndDamnCost[4] = {
-        0,
-        0,
-        300000000,
-        600000000
-    };
-
-    int64_t hbboardCost[4] = {
-        0,
-        200000000,
-        300000000,
-        600000000
-    };
+    InitArray64(distance, INF64, args.numNodes);
+    InitArray(parent, -1, args.numNodes);
 
-    // if four ExistingMembers can go from unenrolled to 1st choice to stop an advised choice it will happen
-    // calculation:
-    //      (9500 - 3000) + 4 * (9000 - 11000) < 0
-    //      (9500 - 3000) + 3 * (9000 - 11000) > 0
-    int64_t existingMemberFollowsAdviceCost = 0;
-    int64_t existingCost[4] = {
-         900000,
-         950000,
-        1000000,
-        1100000
-    };
+    typedef std::pair<int64_t, int> QueueEntry;
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
 
+    distance[startNode] = 0;
+    queue.push(std::make_pair(0, startNode));
 
-    // NonDancing and Unrolled are basically grouped in the same math equations
-    // The NonDancing have slightly higher priority than Unrolled
+    while (!queue.empty())
+    {
+        QueueEntry entry = queue.top();
+        queue.pop();
 
-    // if two NonDancing/Unrolled members can go from 3rd to first choice due to a single ExistingMember
-    // if four NonDancing/Unrolled members can go from 2nd to first choice due to a single ExistingMember
-    //   we should pick that solution
-    int64_t nonDancingLastYearCost[4] = {
-        1010000,
-        1027500,
-        1045000,
-        1090000
-    };
-    int64_t unrolledLastYearCost[4] = {
-        1020000,
-        1035000,
-        1050000,
-        1080000
-    };
+        int currentNode = entry.second;
+        const int64_t currentDistance = entry.first;
+        if (currentDistance > distance[currentNode])
+        {
+            continue;
+        }
 
-    // Female and NonFemale are basically grouped in the same math equations
-    // The NonFemale have slightly higher priority than Unrolled
-
-    //if two NonFemale/Female members can go from 3rd to first choice due to a single NonDancingMembers
-    //if four NonFemale/Female members can go from 2nd to first choice due to a single NonDancingMembers
-    //    we should pick that solution
-    int64_t nonFemaleCost[4] = {
-        1010000,
-        1027500,
-        1045000,
-        1090000
-    };
-    int64_t femaleCost[4] = {
-        1020000,
-        1035000,
-        1050000,
-        1080000
-    };
+        const int64_t currentPotential = args.potential[currentNode];
 
-    // if two HalfYear members can go from 3rd to first choice due to a single NonFemale
-    // if four HalfYear members can go from 2nd to first choice due to a single NonFemale
-    //    we should pick that solution
-    int64_t halfYearCost[4] = {
-        1062100,
-        1064050,
-        1066000,
-        1069900
-    };
+        for (int neighbour : args.adjecencyList[currentNode])
+        {
+            if (neighbour == startNode || neighbour == skipNode)
+            {
+                continue;
+            }
 
-    // if two GapYear/HalfGapYear members can go from 3rd to first choice due to a single HalfYear
-    // if four GapYear/HalfGapYear members can go from 2nd to first choice due to a single HalfYear
-    //    we should pick that solution
-    int64_t gapYearCost[4] = {
-        1066300,
-        1067000,
-        1067700,
-        1069100
-    };
-    int64_t halfGapYearCost[4] = {
-        1066600,
-        1067200,
-        1067800,
-        1069000
-    };
+            // normal graph
+            if (CanFlow(args, currentNode, neighbour))
+            {
+                const int64_t newDistance = currentDistance + GetCost(args, currentNode, neighbour) + currentPotential - args.potential[neighbour];
+                if (newDistance < distance[neighbour])
+                {
+                    distance[neighbour] = newDistance;
+                    parent[neighbour] = currentNode;
+                    queue.push(std::make_pair(newDistance, neighbour));
+                }
+            }
 
-    // if two NonStudying/HalfNonStudying members can go from 3rd to first choice due to a single GapYear
-    // if four NonStudying/HalfNonStudying can go from 2nd to first choice due to a single GapYear
-    //    we should pick that solution
-    int64_t nonStudyingCost[4] = {
-        1066300,
-        1067000,
-        1067700,
-        1069100
-    };
-    int64_t halfNonStudyingCost[4] = {
-        1066600,
-        1067200,
-        1067800,
-        1069000
-    };
+            // residual graph
+            if (neighbour != args.sourceNode && GetFlow(args, neighbour, currentNode) > 0)
+            {
+                const int64_t newDistance = currentDistance - GetCost(args, neighbour, currentNode) + currentPotential - args.potential[neighbour];
+                if (newDistance < distance[neighbour])
+                {
+                    distance[neighbour] = newDistance;
+                    parent[neighbour] = currentNode;
+                    queue.push(std::make_pair(newDistance, neighbour));
+                }
+            }
+        }
+    }
+}
 
-#if 1
-    int64_t baseCost = 300000;
-    int64_t maxCost = 300000000;
+// Dijkstra on reduced costs over the residual arcs reversed, so distance is the cheapest way from every node to targetNode
+// next is the node after it on that way. The arcs back into the source are included, the potentials must be valid for them too
+void SearchReducedCostsTo(const MinCostMaxFlowArgs& args, int targetNode, int64_t* distance, int* next)
+{
+    InitArray64(distance, INF64, args.numNodes);
+    InitArray(next, -1, args.numNodes);
 
-    int64_t start[3]
-    {
-        0,0,0
-    };
-    int64_t increment[3]
-    {
-        0,0,0
-    };
+    typedef std::pair<int64_t, int> QueueEntry;
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
 
-    increment[0] = 377923;
-    start[0] = baseCost + increment[0] * 3 + 1;
+    distance[targetNode] = 0;
+    queue.push(std::make_pair(0, targetNode));
 
-    for (int i = 0; i < 2; i++)
+    while (!queue.empty())
     {
-        increment[i + 1] = increment[i] / 3 + 1;
-        start[i + 1] = start[i] + 2 * increment[i] + 10; // added padding
-    }
+        QueueEntry entry = queue.top();
+        queue.pop();
 
-    int64_t groupCost[3][4] = {};
-
-    for (int i = 0; i < 3; i++)
-    {
-        groupCost[i][0] = start[i];
-        for (int j = 1; j < 3; j++)
+        int currentNode = entry.second;
+        const int64_t currentDistance = entry.first;
+        if (currentDistance > distance[currentNode])
         {
-            groupCost[i][j] = groupCost[i][j - 1] + increment[i];
+            continue;
         }
-    }
-
-    int64_t unenrollBase = groupCost[0][2];
-    groupCost[0][3] = unenrollBase * 1.5f;
-    groupCost[1][3] = unenrollBase * 1.4f;
-    groupCost[2][3] = groupCost[2][2] + 100;
-
-    for (int i = 0; i < 4; i++)
-    {
-        existingCost[i] = groupCost[0][i];
-    }
 
-    for (int i = 0; i < 4; i++)
-    {
-        nonDancingLastYearCost[i] = groupCost[1][i];
-    }
+        const int64_t currentPotential = args.potential[currentNode];
 
-    for (int i = 0; i < 4; i++)
-    {
-        unrolledLastYearCost[i] = groupCost[1][i] + 1;
-    }
-
-    for (int i = 0; i < 4; i++)
-    {
-        nonFemaleCost[i] = groupCost[1][i] + 2;
-    }
+        for (int neighbour : args.adjecencyList[currentNode])
+        {
+            // normal graph, neighbour -> currentNode
+            if (CanFlow(args, neighbour, currentNode))
+            {
+                const int64_t newDistance = currentDistance + GetCost(args, neighbour, currentNode) + args.potential[neighbour] - currentPotential;
+                if (newDistance < distance[neighbour])
+                {
+                    distance[neighbour] = newDistance;
+                    next[neighbour] = currentNode;
+                    queue.push(std::make_pair(newDistance, neighbour));
+                }
+            }
 
-    for (int i = 0; i < 4; i++)
-    {
-        femaleCost[i] = groupCost[1][i] + 3;
+            // residual graph, neighbour -> currentNode takes back flow of currentNode -> neighbour
+            if (GetFlow(args, currentNode, neighbour) > 0)
+            {
+                const int64_t newDistance = currentDistance - GetCost(args, currentNode, neighbour) + args.potential[neighbour] - currentPotential;
+                if (newDistance < distance[neighbour])
+                {
+                    distance[neighbour] = newDistance;
+                    next[neighbour] = currentNode;
+                    queue.push(std::make_pair(newDistance, neighbour));
+                }
+            }
+        }
     }
+}
 
-    for (int i = 0; i < 4; i++)
-    {
-        halfYearCost[i] = groupCost[2][i];
-    }
+// Searches from startNode into the distance and parent arrays of the network
+void SearchReducedCosts(MinCostMaxFlowArgs& args, int startNode)
+{
+    SearchReducedCosts(args, startNode, -1, args.distance, args.parent);
+}
 
-    for (int i = 0; i < 4; i++)
+// Shifts the potentials by the distances of the last search, so the reduced costs stay non negative after augmenting over a shortest path
+// Nodes the search did not reach are shifted by the largest distance, which keeps the arcs from them to reached nodes non negative too
+void ShiftPotentials(MinCostMaxFlowArgs& args)
+{
+    int64_t largestDistance = 0;
+    for (int node = 0; node < args.numNodes; node++)
     {
-        gapYearCost[i] = groupCost[2][i] + 1 + i;
+        if (args.distance[node] != INF64)
+        {
+            largestDistance = std::max(largestDistance, args.distance[node]);
+        }
     }
 
-    for (int i = 0; i < 4; i++)
+    for (int node = 0; node < args.numNodes; node++)
     {
-        halfGapYearCost[i] = groupCost[2][i] + 2 + i;
+        args.potential[node] += args.distance[node] != INF64 ? args.distance[node] : largestDistance;
     }
+}
 
-    for (int i = 0; i < 4; i++)
-    {
-        nonStudyingCost[i] = groupCost[2][i] + 3 + i;
-    }
+// Shortest path from the source to the sink on reduced costs
+// Returns false when the sink cannot be reached
+bool Dijkstra(MinCostMaxFlowArgs& args)
+{
+    SearchReducedCosts(args, args.sourceNode);
 
-    for (int i = 0; i < 4; i++)
+    if (GetDistance(args, args.sinkNode) == INF64)
     {
-        halfNonStudyingCost[i] = groupCost[2][i] + 4 + i;
+        return false;
     }
-#endif
 
-    // flat cost of +1 such that it is better to not unenroll someone when the choice is between
-    // moving someone to 2nd or 3rd choice or someone to unenrolled
-    int isUnrolledClass = chosenClass == "unenrolled" ? 1 : 0;
+    ShiftPotentials(args);
+    return true;
+}
 
-    if (choiceNumber > 3)
-    {
-        choiceNumber = 3;
-        printf("Warning: Dancer %i has more choices than allowed", dancer.relationNumber);
-    }
+std::pair<int64_t, int> SuccessiveShortestPaths(MinCostMaxFlowArgs& args)
+{
+    int64_t minCost = 0;
+    int maxFlow = 0;
 
-    if (dancer.priorityGroup == HBBoard)
+    while (Dijkstra(args))
     {
-        return hbboardCost[choiceNumber] + isUnrolledClass;
+        minCost += AugmentAlongParents(args, nullptr);
+        maxFlow++;
     }
 
-    // Smallest cost for board and damn
-    if (dancer.priorityGroup == KBBoard || dancer.priorityGroup == Damn)
-    {
-        return boardAndDamnCost[choiceNumber] + isUnrolledClass;
-    }
+    return std::make_pair(minCost, maxFlow);
+}
 
-    // For exising members that follow advice (First class only (choiceNumber == 0)) give next smallest cost
-    if ((dancer.priorityGroup == ExistingMember) && choiceNumber == 0 && contains(dancer.advisedClasses, chosenClass))
-    {
-        return existingMemberFollowsAdviceCost + isUnrolledClass;
-    }
+void PermuteDancerNodes(const MinCostMaxFlowArgs& base, const std::vector<int>& dancerPosition, MinCostMaxFlowArgs& target)
+{
+    const int numNodes = base.numNodes;
 
-    if (dancer.priorityGroup == ExistingMember)
+    std::vector<int> nodeMap(numNodes);
+    for (int node = 0; node < numNodes; node++)
     {
-        return existingCost[choiceNumber] + isUnrolledClass;
+        nodeMap[node] = node;
     }
-
-    if (dancer.priorityGroup == NonDancerLastYear)
+    for (int i = 0; i < dancerPosition.size(); i++)
     {
-        return nonDancingLastYearCost[choiceNumber] + isUnrolledClass;
+        nodeMap[base.dancerOffset + i] = base.dancerOffset + dancerPosition[i];
     }
 
-    if (dancer.priorityGroup == UnrolledLastYear)
-    {
-        return unrolledLastYearCost[choiceNumber] + isUnrolledClass;
-    }
+    const size_t numArcs = (size_t)numNodes * numNodes;
+    memset(target.flow, 0, numArcs * sizeof(target.flow[0]));
+    memset(target.capacity, 0, numArcs * sizeof(target.capacity[0]));
+    memset(target.cost, 0, numArcs * sizeof(target.cost[0]));
 
-    if (dancer.priorityGroup == NonFemale)
+    for (int node = 0; node < numNodes; node++)
     {
-        return nonFemaleCost[choiceNumber] + isUnrolledClass;
-    }
+        int targetNode = nodeMap[node];
 
-    if (dancer.priorityGroup == Female)
-    {
-        return femaleCost[choiceNumber] + isUnrolledClass;
-    }
+        target.adjecencyList[targetNode].clear();
+        for (int neighbour : base.adjecencyList[node])
+        {
+            int targetNeighbour = nodeMap[neighbour];
+            target.adjecencyList[targetNode].push_back(targetNeighbour);
 
-    if (dancer.priorityGroup == HalfYear)
-    {
-        return halfYearCost[choiceNumber] + isUnrolledClass;
-    }
+            SetFlow(target, targetNode, targetNeighbour, GetFlow(base, node, neighbour));
+            SetCapacity(target, targetNode, targetNeighbour, GetCapacity(base, node, neighbour));
+            SetCost(target, targetNode, targetNeighbour, GetCost(base, node, neighbour));
+        }
 
-    if (dancer.priorityGroup == GapYear)
-    {
-        return gapYearCost[choiceNumber] + isUnrolledClass;
+        target.potential[targetNode] = base.potential[node];
     }
 
-    if (dancer.priorityGroup == HalfGapYear)
+    // The encoding lists the dancers of the other nodes in dancer order, keep that for the new order
+    for (int node = 0; node < numNodes; node++)
     {
-        return halfGapYearCost[choiceNumber] + isUnrolledClass;
+        if (GetNodeType(target, node) != Dancer)
+        {
+            std::sort(target.adjecencyList[node].begin(), target.adjecencyList[node].end());
+        }
     }
 
-    if (dancer.priorityGroup == NonStudying)
-    {
-        return nonStudyingCost[choiceNumber] + isUnrolledClass;
-    }
+    target.sourceNode = base.sourceNode;
+    target.sinkNode = base.sinkNode;
+    target.dancerOffset = base.dancerOffset;
+    target.classOffset = base.classOffset;
+    target.classCostOffset = base.classCostOffset;
+    target.expectedMaxFlow = base.expectedMaxFlow;
+    target.classes = base.classes;
+    target.decisions.clear();
+}
 
-    if (dancer.priorityGroup == HalfNonStudying)
+MinCostMaxFlowArgs AllocateMinCostMaxFlow(int numNodes, std::shared_ptr<SolverArena> arena)
+{
+    if (!arena)
     {
-        return halfNonStudyingCost[choiceNumber] + isUnrolledClass;
+        arena = std::make_shared<SolverArena>();
     }
 
-    printf("Warning: Dancer %i was not categorized correctly setting half non studying cost", dancer.relationNumber);
+    // space computation, every array starts on its own cache line
+    const size_t nodes = numNodes;
+    const size_t arcs = nodes * nodes;
+    size_t spaceRequired = 0;
+    spaceRequired += AlignToCacheLine(nodes * sizeof(int64_t));     // distances
+    spaceRequired += AlignToCacheLine(nodes * sizeof(int64_t));     // potentials
+    spaceRequired += AlignToCacheLine(nodes * sizeof(int));         // parents
+    spaceRequired += AlignToCacheLine(arcs * sizeof(int));          // flow
+    spaceRequired += AlignToCacheLine(arcs * sizeof(int64_t));      // cost
+    spaceRequired += AlignToCacheLine(arcs * sizeof(int));          // capacity
 
-    return halfNonStudyingCost[choiceNumber] + isUnrolledClass;
-}
+    // we have a single mapping for all data of the network
+    arena->Reset();
+    arena->Reserve(spaceRequired);
 
-const int64_t underMinBoundsCost = 0;
-const int64_t isWithinClassBoundsCost = 125975;
-const int64_t AdditionalSpaceCost()
-{
-    Studancer tmpDancer;
-    tmpDancer.priorityGroup = NonStudying;
+    MinCostMaxFlowArgs args = {};
+    args.sourceNode = 0;
+    args.sinkNode = numNodes - 1;
+    args.numNodes = numNodes;
+    args.adjecencyList.resize(nodes);
+    args.distance = arena->AllocateArray<int64_t>(nodes);
+    args.potential = arena->AllocateArray<int64_t>(nodes);
+    args.parent = arena->AllocateArray<int>(nodes);
+    args.flow = arena->AllocateArray<int>(arcs);
+    args.cost = arena->AllocateArray<int64_t>(arcs);
+    args.capacity = arena->AllocateArray<int>(arcs);
+    args.arena = arena;
 
-    int64_t cost1 = GetChoiceCostForDancer(tmpDancer, "x", 2);
-    int64_t cost2 = GetChoiceCostForDancer(tmpDancer, "unenrolled", 3);
-    return 125975 + 41992;
+    return args;
 }
 
 const int choiceOffset = 12;
@@ -954,48 +1207,71 @@ void MakeEdge(MinCostMaxFlowArgs& args, int u, int v, int64_t c, int cap)
     args.adjecencyList[v].push_back(u);
 }
 
-void LoadExistingSolution(MinCostMaxFlowArgs& args, const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes)
+// Encodes source -> dancer and the edges from the dancer to its chosen classes
+void EncodeDancer(MinCostMaxFlowArgs& args, const Studancer& dancer, int dancerNodeIndex, std::map<std::string, int>& classMap)
 {
-    Assignment existingSolution = LoadExportAssignment("ClassAssignment_MCMF_updatable.csv", dancers, classes);
+    const CostModel& costModel = GetCostModel();
 
-    std::vector<int> dancerMap(dancers.size());
-    std::map<int, int> seenDancers;
+    // Different types of dancers have different types of cost
+    int64_t dancerCost = GetCostForDancer(dancer);
+    // Board members can assign 2 classes
+    int numDanceClassesToChoose = dancer.priorityGroup == KBBoard || dancer.priorityGroup == Damn ? 2 : 1;
+    args.expectedMaxFlow += numDanceClassesToChoose;
 
-    std::vector<std::vector<std::string>> assignedClassesForDancer(dancers.size());
+    MakeEdge(args, 0, dancerNodeIndex, dancerCost, numDanceClassesToChoose);
 
-    int dIndex = 0;
-    for (auto& classAssignment : existingSolution)
+    int choiceNumber = 0;
+    // encode choices
+    for (int j = 0; j < dancer.chosenClasses.size(); j++)
     {
-        for (auto& dancer : classAssignment.second)
+        if (dancer.chosenClasses[j] == "")
         {
-            if (!seenDancers.count(dancer.relationNumber))
-            {
-                int i = 0;
-                for (auto& sourceNeighbour : args.adjecencyList[args.sourceNode])
-                {
-                    Studancer node = GetDancerFromNode(args, sourceNeighbour);
-                    if (node.relationNumber == dancer.relationNumber)
-                    {
-                        i = sourceNeighbour;
-                        break;
-                    }
-                }
-                dancerMap[dIndex] = i;
-                assignedClassesForDancer[dIndex] = std::vector<std::string>();
-                seenDancers.emplace(std::make_pair(dancer.relationNumber, dIndex++));
+            continue;
+        }
+        const std::string& chosenClass = dancer.chosenClasses[j];
+        int classNodeIndex = classMap[chosenClass] + args.classOffset;
 
-            }
-            int dancerIndex = seenDancers[dancer.relationNumber];
-            assignedClassesForDancer[dancerIndex].push_back(classAssignment.first.name);
+        if (choiceNumber > 3 && chosenClass != "unenrolled")
+        {
+            Print("Warning: Dancer %i has more choices than allowed", dancer.relationNumber);
+        }
+        int64_t classCost = GetChoiceArcCost(costModel, dancer, j, choiceNumber);
+
+        // can only choose class once
+        MakeEdge(args, dancerNodeIndex, classNodeIndex, classCost, 1);
+
+        choiceNumber++;
+    }
+}
+
+void LoadPlacementFlow(MinCostMaxFlowArgs& args, std::vector<AssignmentPlacement> placements)
+{
+    const std::vector<Studancer>& dancers = *args.dancers;
+    const std::vector<DanceClass>& classes = *args.classes;
+
+    // Replay the dancers in the order they first appear in the placements, with all of their classes at once
+    std::vector<int> firstSeen(dancers.size(), -1);
+    for (int i = 0; i < placements.size(); i++)
+    {
+        if (firstSeen[placements[i].dancer] == -1)
+        {
+            firstSeen[placements[i].dancer] = i;
         }
     }
+    std::stable_sort(placements.begin(), placements.end(), [&](const AssignmentPlacement& a, const AssignmentPlacement& b) {
+        return firstSeen[a.dancer] < firstSeen[b.dancer];
+    });
 
-    for (int d = 0; d < dIndex; d++)
+    for (int first = 0; first < placements.size();)
     {
-        int node = dancerMap[d];
+        int last = first;
+        while (last < placements.size() && placements[last].dancer == placements[first].dancer)
+        {
+            last++;
+        }
 
-        Studancer dancer = GetDancerFromNode(args, node);
-        std::vector<std::string>& assignedClasses = assignedClassesForDancer[d];
+        int node = args.dancerOffset + placements[first].dancer;
+        const Studancer& dancer = GetDancerFromNode(args, node);
 
         for (auto& dancerNeighbour : args.adjecencyList[node])
         {
@@ -1004,8 +1280,14 @@ void LoadExistingSolution(MinCostMaxFlowArgs& args, const std::vector<Studancer>
                 continue;
             }
 
-            std::string className = GetNodeName(args, dancerNeighbour);
-            if (contains(assignedClasses, className))
+            const std::string& className = classes[dancerNeighbour - args.classOffset].name;
+            bool isAssigned = false;
+            for (int i = first; i < last; i++)
+            {
+                isAssigned |= classes[placements[i].danceClass].name == className;
+            }
+
+            if (isAssigned)
             {
                 //printf("Assigning %i to %s\n", dancer.relationNumber, className.c_str());
 
@@ -1035,14 +1317,22 @@ void LoadExistingSolution(MinCostMaxFlowArgs& args, const std::vector<Studancer>
                 }
                 else
                 {
-                    printf("Dropped %i from %s with priorityGroup %s due to update\n", dancer.relationNumber, className.c_str(), DancerPriorityGroupToString(dancer.priorityGroup).c_str());
+                    Print("Dropped %i from %s with priorityGroup %s, the class is full\n", dancer.relationNumber, className.c_str(), DancerPriorityGroupToString(dancer.priorityGroup).c_str());
                 }
             }
         }
+
+        first = last;
     }
 }
 
-MinCostMaxFlowArgs EncodeMinCostMaxFlow(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const CliArguments& cliArgs)
+void LoadExistingSolution(MinCostMaxFlowArgs& args, const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes)
+{
+    LoadPlacementFlow(args, LoadExportPlacements("ClassAssignment_MCMF_updatable.csv", dancers, classes));
+}
+
+MinCostMaxFlowArgs EncodeMinCostMaxFlow(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const CliArguments& cliArgs,
+                                        std::shared_ptr<SolverArena> arena)
 {
     // 1 for source
     int numNodes = 1;
@@ -1062,7 +1352,11 @@ MinCostMaxFlowArgs EncodeMinCostMaxFlow(const std::vector<Studancer>& dancers, c
     numNodes += 1;
 
     // Initialize network
-    MinCostMaxFlowArgs args = AllocateMinCostMaxFlow(numNodes);
+    if (!arena)
+    {
+        arena = std::make_shared<SolverArena>(cliArgs.hugePages);
+    }
+    MinCostMaxFlowArgs args = AllocateMinCostMaxFlow(numNodes, arena);
 
     // for easier finding of classes
     std::map<std::string, int> classMap;
@@ -1084,42 +1378,10 @@ MinCostMaxFlowArgs EncodeMinCostMaxFlow(const std::vector<Studancer>& dancers, c
     // Encode dancers (edges of sink to dancers, and dancers to classes)
     for (int i = 0; i < dancers.size(); i++)
     {
-        // Encode source -> dancer
-        const Studancer& dancer = dancers[i];
-
-        // node for this dancer
-        int dancerNodeIndex = args.dancerOffset + i;
-
-        // Different types of dancers have different types of cost
-        int64_t dancerCost = GetCostForDancer(dancer);
-        // Board members can assign 2 classes
-        int numDanceClassesToChoose = dancer.priorityGroup == KBBoard || dancer.priorityGroup == Damn ? 2 : 1;
-        args.expectedMaxFlow += numDanceClassesToChoose;
-
-        MakeEdge(args, 0, dancerNodeIndex, dancerCost, numDanceClassesToChoose);
-
-        int choiceNumber = 0;
-        // encode choices
-        for (int j = 0; j < dancer.chosenClasses.size(); j++)
-        {
-            if (dancer.chosenClasses[j] == "")
-            {
-                continue;
-            }
-            const std::string& chosenClass = dancer.chosenClasses[j];
-            int classNodeIndex = classMap[chosenClass] + args.classOffset;
-
-            // Note: Also handles unenrolled
-            int64_t classCost = GetChoiceCostForDancer(dancer, chosenClass, choiceNumber);
-
-            // can only choose class once
-            MakeEdge(args, dancerNodeIndex, classNodeIndex, classCost, 1);
-
-            choiceNumber++;
-        }
+        EncodeDancer(args, dancers[i], args.dancerOffset + i, classMap);
     }
 
-    int64_t additionalSpaceCost = AdditionalSpaceCost();
+    const CostModel& costModel = GetCostModel();
 
     // Encode classes (classes to different choice costs)
     for (int i = 0; i < classes.size(); i++)
@@ -1134,20 +1396,20 @@ MinCostMaxFlowArgs EncodeMinCostMaxFlow(const std::vector<Studancer>& dancers, c
         {
             if (danceClass.name == "unenrolled" && cliArgs.maxUnenroll != 0xFFFFFFFFU)
             {
-                MakeEdge(args, classNodeIndex, classNodeCostIndex, isWithinClassBoundsCost, cliArgs.maxUnenroll);
+                MakeEdge(args, classNodeIndex, classNodeCostIndex, costModel.withinClassBoundsCost, cliArgs.maxUnenroll);
             }
             else
             {
-                MakeEdge(args, classNodeIndex, classNodeCostIndex, isWithinClassBoundsCost, danceClass.maxSize);
+                MakeEdge(args, classNodeIndex, classNodeCostIndex, costModel.withinClassBoundsCost, danceClass.maxSize);
             }
 
             MakeEdge(args, classNodeCostIndex, args.sinkNode, 0, INF);
         }
         else
         {
-            MakeEdge(args, classNodeIndex, classNodeCostIndex, underMinBoundsCost, danceClass.minSize);
-            MakeEdge(args, classNodeIndex, classNodeCostIndex + 1, isWithinClassBoundsCost, danceClass.maxSize - danceClass.minSize);
-            MakeEdge(args, classNodeIndex, classNodeCostIndex + 2, additionalSpaceCost, danceClass.additionalSpace);
+            MakeEdge(args, classNodeIndex, classNodeCostIndex, costModel.underMinBoundsCost, danceClass.minSize);
+            MakeEdge(args, classNodeIndex, classNodeCostIndex + 1, costModel.withinClassBoundsCost, danceClass.maxSize - danceClass.minSize);
+            MakeEdge(args, classNodeIndex, classNodeCostIndex + 2, costModel.additionalSpaceCost, danceClass.additionalSpace);
 
             // We set cost and capacity to 0 as that was already calculated in the last edge
             MakeEdge(args, classNodeCostIndex, args.sinkNode, 0, INF);
@@ -1291,134 +1553,1662 @@ MinCostMaxFlowArgs EncodeMinCostMaxFlow(const std::vector<Studancer>& dancers, c
     return args;
 }
 
-Assignment DecodeMinCostMaxFlow(MinCostMaxFlowArgs& args)
+bool ComputeAllPotentials(MinCostMaxFlowArgs& args, bool intoSource)
 {
-    Assignment assignment;
-
-    const std::vector<Studancer>& dancers = *args.dancers;
-    const std::vector<DanceClass>& classes = *args.classes;
+    // Bellman-Ford from a virtual node with a zero cost arc to every node, so every node gets a potential
+    std::vector<ResidualArc> arcs;
+    CollectResidualArcs(args, arcs, intoSource);
+    InitArray64(args.distance, 0, args.numNodes);
 
-    int dancerOffset = 1;
-    int classOffset = dancerOffset + (int)dancers.size();
-    int classCostsOffset = classOffset + (int)classes.size();
-
-    for (int i = 0; i < classes.size(); i++)
+    for (int bfIteration = 0; bfIteration <= args.numNodes; bfIteration++)
     {
-        DanceClass danceClass = classes[i];
-        std::vector<Studancer> assignedDancers;
-
-        int classNodeIndex = i + classOffset;
-
-        for (int neighbour : args.adjecencyList[classNodeIndex])
+        bool hadUpdate = false;
+        for (const ResidualArc& arc : arcs)
         {
-            // If there is flow from a dancer to this class, this class was chosen
-            if (neighbour >= dancerOffset && neighbour < classOffset && !CanFlow(args, neighbour, classNodeIndex))
+            if (args.distance[arc.from] + arc.cost < args.distance[arc.to])
             {
-                int dancerIndex = neighbour - dancerOffset;
-                assignedDancers.push_back(dancers[dancerIndex]);
+                args.distance[arc.to] = args.distance[arc.from] + arc.cost;
+                hadUpdate = true;
             }
         }
 
-        assignment.push_back(std::make_pair(danceClass, assignedDancers));
+        if (!hadUpdate)
+        {
+            memcpy(args.potential, args.distance, args.numNodes * sizeof(args.potential[0]));
+            return true;
+        }
     }
 
-    return assignment;
+    return false;
 }
 
-void DumpDecisionLog(const MinCostMaxFlowArgs& args)
+// Gives a dancer node the lowest potential that keeps the reduced costs of the arcs to its classes non negative
+void SetDancerPotential(MinCostMaxFlowArgs& args, int dancerNode)
 {
-    auto outputPath = GetOutputFolder() / "DecisionLog_MCMF.txt";
-    std::ofstream outputFile(outputPath);
-
-    int decisionNumber = 1;
-    for (auto& decision : args.decisions)
+    int64_t potential = args.potential[args.sourceNode] + GetCost(args, args.sourceNode, dancerNode);
+    bool hasChoice = false;
+    for (int neighbour : args.adjecencyList[dancerNode])
     {
-        outputFile << "Decision ";
-        outputFile << decisionNumber;
-        outputFile << " (flow change: ";
-        outputFile << decision.flowChange;
-        outputFile << ", cost change: ";
-        outputFile << decision.costChange;
-        outputFile << ")\n";
+        if (GetCapacity(args, dancerNode, neighbour) > 0)
+        {
+            int64_t needed = args.potential[neighbour] - GetCost(args, dancerNode, neighbour);
+            potential = hasChoice ? std::max(potential, needed) : needed;
+            hasChoice = true;
+        }
+    }
+    args.potential[dancerNode] = potential;
+}
 
-        // reverse the path
-        std::vector<int> path;
-        for (int i = (int)decision.changedNodes.size() - 1; i > 0; i--)
+// Moves the network to a new arena with room for extraSlots more dancer nodes after the last one,
+// the free slots have no arcs until AddDancer() encodes a dancer into them
+void ReserveDancerSlots(MinCostMaxFlowArgs& args, int extraSlots, const CliArguments& cliArgs)
+{
+    // Every class, cost and sink node moves up by extraSlots
+    const int oldNumNodes = args.numNodes;
+    auto mapNode = [&](int node) { return node < args.classOffset ? node : node + extraSlots; };
+
+    MinCostMaxFlowArgs grown = AllocateMinCostMaxFlow(oldNumNodes + extraSlots, std::make_shared<SolverArena>(cliArgs.hugePages));
+    for (int node = 0; node < oldNumNodes; node++)
+    {
+        int grownNode = mapNode(node);
+        for (int neighbour : args.adjecencyList[node])
         {
-            path.push_back(decision.changedNodes[i]);
+            int grownNeighbour = mapNode(neighbour);
+            grown.adjecencyList[grownNode].push_back(grownNeighbour);
+
+            SetFlow(grown, grownNode, grownNeighbour, GetFlow(args, node, neighbour));
+            SetCapacity(grown, grownNode, grownNeighbour, GetCapacity(args, node, neighbour));
+            SetCost(grown, grownNode, grownNeighbour, GetCost(args, node, neighbour));
         }
+        grown.potential[grownNode] = args.potential[node];
+    }
 
-        if (decision.type == AssignDancer)
+    grown.sourceNode = args.sourceNode;
+    grown.sinkNode = mapNode(args.sinkNode);
+    grown.dancerOffset = args.dancerOffset;
+    grown.classOffset = args.classOffset + extraSlots;
+    grown.classCostOffset = args.classCostOffset + extraSlots;
+    grown.expectedMaxFlow = args.expectedMaxFlow;
+    grown.dancers = args.dancers;
+    grown.classes = args.classes;
+
+    grown.decisions = std::move(args.decisions);
+    for (Decision& decision : grown.decisions)
+    {
+        for (int& node : decision.changedNodes)
         {
-            const Studancer& dancer = GetDancerFromNode(args, path[1]);
-            std::string className = GetNodeName(args, path[2]);
+            node = mapNode(node);
+        }
+    }
 
-            int choiceIndex = FindItemInVector(dancer.chosenClasses, className);
-            std::string choice = ChoiceNumberToString(choiceIndex);
+    args = std::move(grown);
+}
 
-            outputFile << "Assigned dancer ";
-            outputFile << dancer.relationNumber;
-            outputFile << " with priority group ";
-            outputFile << DancerPriorityGroupToString(dancer.priorityGroup);
-            outputFile << " to their " << choice << " choice: ";
-            outputFile << className;
+void AddDancer(MinCostMaxFlowArgs& args, const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const CliArguments& cliArgs)
+{
+    // The new dancer goes in the first free slot after the other dancers, when there is none a quarter more slots are reserved
+    // so the whole network is only copied now and then
+    const int newDancerNode = args.dancerOffset + (int)dancers.size() - 1;
+    if (newDancerNode >= args.classOffset)
+    {
+        ReserveDancerSlots(args, std::max(16, (int)dancers.size() / 4), cliArgs);
+    }
+    args.dancers = &dancers;
+    args.classes = &classes;
 
-            // if the path is longer than 4 someone else was moved
-            if (path.size() > 4)
-            {
-                int offset = 3;
+    std::map<std::string, int> classMap;
+    for (int i = 0; i < classes.size(); i++)
+    {
+        classMap.emplace(std::make_pair(classes[i].name, i));
+    }
 
-                outputFile << " by updating the assignment:\n";
+    const Studancer& dancer = dancers.back();
+    EncodeDancer(args, dancer, newDancerNode, classMap);
 
-                for (int index = 2; index < path.size() - 2; index++)
-                {
-                    int currentNode = path[index];
-                    int nextNode = path[index + 1];
+    // Keep the dancers listed in dancer order at their classes, like a full encoding does
+    for (int neighbour : args.adjecencyList[newDancerNode])
+    {
+        std::sort(args.adjecencyList[neighbour].begin(), args.adjecencyList[neighbour].end());
+    }
 
-                    NodeType currentNodeType = GetNodeType(args, currentNode);
-                    NodeType nextNodeType = GetNodeType(args, nextNode);
+    SetDancerPotential(args, newDancerNode);
 
-                    if (currentNodeType == Dancer && nextNodeType == Class)
-                    {
-                        const Studancer& updatedDancer = GetDancerFromNode(args, currentNode);
+    // Only the new units of flow are missing, each one is a single search from the current potentials
+    int units = GetCapacity(args, args.sourceNode, newDancerNode);
+    for (int unit = 0; unit < units && Dijkstra(args); unit++)
+    {
+        Decision decision = {};
+        decision.type = AssignDancer;
+        decision.flowChange = 1;
+        decision.costChange = AugmentAlongParents(args, &decision.changedNodes);
+        args.decisions.push_back(decision);
+    }
+}
 
-                        std::string updatedClass = GetNodeName(args, nextNode);
+void WithdrawDancer(MinCostMaxFlowArgs& args, int dancerIndex)
+{
+    const int dancerNode = args.dancerOffset + dancerIndex;
 
-                        int classIndex = FindItemInVector(updatedDancer.chosenClasses, updatedClass);
-                        std::string choice = ChoiceNumberToString(classIndex);
+    // Every unit of the dancer is sent back from the sink over the cheapest way to the dancer,
+    // which moves whoever gains most from the freed seat in with the same search
+    while (GetFlow(args, args.sourceNode, dancerNode) > 0)
+    {
+        SearchReducedCosts(args, args.sinkNode);
+        if (GetDistance(args, dancerNode) == INF64)
+        {
+            printf("ERROR: cannot withdraw dancer %s, there is no way back from the sink\n", GetNodeName(args, dancerNode).c_str());
+            DumpBuffer(args);
+            exit(-1);
+        }
 
-                        outputFile << "Assigned dancer ";
-                        outputFile << updatedDancer.relationNumber;
-                        outputFile << " with priority group ";
-                        outputFile << DancerPriorityGroupToString(updatedDancer.priorityGroup);
-                        outputFile << " to their " << choice << " choice: ";
-                        outputFile << updatedClass;
-                        outputFile << "\n";
-                    }
-                    else if (currentNodeType == Class && nextNodeType == Dancer)
-                    {
-                        const Studancer& updatedDancer = GetDancerFromNode(args, nextNode);
-                        std::string updatedClass = GetNodeName(args, currentNode);
+        Decision decision = {};
+        decision.type = UnassignDancer;
+        decision.flowChange = -1;
+        decision.changedNodes.push_back(args.sourceNode);
+        decision.costChange = AugmentAlongParents(args, &decision.changedNodes, args.sinkNode, dancerNode) - GetCost(args, args.sourceNode, dancerNode);
+        AddFlow(args, args.sourceNode, dancerNode, -1);
+        args.decisions.push_back(decision);
 
-                        int classIndex = FindItemInVector(updatedDancer.chosenClasses, updatedClass);
-                        std::string choice = ChoiceNumberToString(classIndex);
+        ShiftPotentials(args);
+    }
 
-                        outputFile << "Unassigned dancer ";
-                        outputFile << updatedDancer.relationNumber;
-                        outputFile << " with priority group ";
-                        outputFile << DancerPriorityGroupToString(updatedDancer.priorityGroup);
-                        outputFile << " from their " << choice << " choice: ";
-                        outputFile << updatedClass;
-                        outputFile << "\n";
-                    }
-                    else if (currentNodeType == Dancer && nextNodeType == Source)
-                    {
-                        const Studancer& updatedDancer = GetDancerFromNode(args, currentNode);
-                        outputFile << "Dancer ";
-                        outputFile << updatedDancer.relationNumber;
-                        outputFile << " with priority group ";
-                        outputFile << DancerPriorityGroupToString(updatedDancer.priorityGroup);
-                        outputFile << " was completely unassigned";
+    args.expectedMaxFlow -= GetCapacity(args, args.sourceNode, dancerNode);
+    SetCapacity(args, args.sourceNode, dancerNode, 0);
+    SetDancerPotential(args, dancerNode);
+}
+
+// Cost of the path from startNode to endNode along the parent pointers, without pushing flow over it
+int64_t PathCostAlongParents(const MinCostMaxFlowArgs& args, int startNode, int endNode)
+{
+    int64_t pathCost = 0;
+    for (int currentNode = endNode; currentNode != startNode;)
+    {
+        int p = GetParent(args, currentNode);
+        pathCost += GetCapacity(args, p, currentNode) > 0 ? GetCost(args, p, currentNode) : -GetCost(args, currentNode, p);
+        currentNode = p;
+    }
+    return pathCost;
+}
+
+// Sets the capacity of the arc from a class to one of its cost nodes and moves the flow to keep it optimal, see ChangeClassCapacity()
+// Returns false when the dancers over a lower capacity have nowhere else to go, the capacity is then left at the flow that could not move
+bool ChangeClassArcCapacity(MinCostMaxFlowArgs& args, int classIndex, int costNode, int capacity)
+{
+    const DanceClass& danceClass = (*args.classes)[classIndex];
+    const int classNode = args.classOffset + classIndex;
+
+    SetCapacity(args, classNode, costNode, capacity);
+
+    // Less room: every unit over the new capacity is moved along the cheapest other way to the sink,
+    // the arc has no room left so the search from the class cannot use it
+    while (GetFlow(args, classNode, costNode) > capacity)
+    {
+        SearchReducedCosts(args, classNode);
+        if (GetDistance(args, costNode) == INF64)
+        {
+            SetCapacity(args, classNode, costNode, GetFlow(args, classNode, costNode));
+            return false;
+        }
+
+        Decision decision = {};
+        decision.type = CycleCancel;
+        decision.changedNodes.push_back(classNode);
+        decision.costChange = AugmentAlongParents(args, &decision.changedNodes, classNode, costNode) - GetCost(args, classNode, costNode);
+        AddFlow(args, classNode, costNode, -1);
+        args.decisions.push_back(decision);
+
+        ShiftPotentials(args);
+    }
+
+    // More room: a dancer is moved in as long as the cheapest way back from the cost node makes a negative cycle with the arc
+    // The arc has a negative reduced cost while that is possible, the searches skip it as it goes back to their start
+    while (CanFlow(args, classNode, costNode))
+    {
+        SearchReducedCosts(args, costNode);
+        if (GetDistance(args, classNode) == INF64)
+        {
+            break;
+        }
+
+        int64_t cycleCost = PathCostAlongParents(args, costNode, classNode) + GetCost(args, classNode, costNode);
+        if (cycleCost >= 0)
+        {
+            ShiftPotentials(args);
+            break;
+        }
+
+        Decision decision = {};
+        decision.type = CycleCancel;
+        decision.changedNodes.push_back(costNode);
+        AugmentAlongParents(args, &decision.changedNodes, costNode, classNode);
+        AddFlow(args, classNode, costNode, 1);
+        decision.costChange = cycleCost;
+        args.decisions.push_back(decision);
+
+        ShiftPotentials(args);
+    }
+
+    // The arc only has a negative reduced cost left when the cost node cannot reach the class anymore
+    if (CanFlow(args, classNode, costNode) && GetCost(args, classNode, costNode) + args.potential[classNode] - args.potential[costNode] < 0)
+    {
+        if (!ComputeAllPotentials(args))
+        {
+            printf("ERROR: changing the capacity of %s left a negative cycle\n", danceClass.name.c_str());
+            DumpBuffer(args);
+            exit(-1);
+        }
+    }
+
+    return true;
+}
+
+bool TryChangeClassCapacity(MinCostMaxFlowArgs& args, int classIndex, int capacity)
+{
+    const DanceClass& danceClass = (*args.classes)[classIndex];
+    const bool isSpecialClass = danceClass.name == "niet-dansend lid" || danceClass.name == "unenrolled";
+    return ChangeClassArcCapacity(args, classIndex, args.classCostOffset + classIndex * 3 + (isSpecialClass ? 0 : 1), capacity);
+}
+
+void ChangeClassCapacity(MinCostMaxFlowArgs& args, int classIndex, int capacity)
+{
+    if (!TryChangeClassCapacity(args, classIndex, capacity))
+    {
+        printf("ERROR: cannot shrink %s, its dancers have nowhere else to go\n", (*args.classes)[classIndex].name.c_str());
+        DumpBuffer(args);
+        exit(-1);
+    }
+}
+
+bool TryChangeClassAdditionalSpace(MinCostMaxFlowArgs& args, int classIndex, int additionalSpace)
+{
+    return ChangeClassArcCapacity(args, classIndex, args.classCostOffset + classIndex * 3 + 2, additionalSpace);
+}
+
+void ChangeClassAdditionalSpace(MinCostMaxFlowArgs& args, int classIndex, int additionalSpace)
+{
+    if (!TryChangeClassAdditionalSpace(args, classIndex, additionalSpace))
+    {
+        printf("ERROR: cannot shrink the additional space of %s, its dancers have nowhere else to go\n", (*args.classes)[classIndex].name.c_str());
+        DumpBuffer(args);
+        exit(-1);
+    }
+}
+
+void SetClassCapacities(MinCostMaxFlowArgs& args, const std::vector<DanceClass>& classes)
+{
+    for (int i = 0; i < classes.size(); i++)
+    {
+        const DanceClass& danceClass = classes[i];
+        if (danceClass.name == "niet-dansend lid" || danceClass.name == "unenrolled")
+        {
+            continue;
+        }
+
+        int classNode = args.classOffset + i;
+        int costNode = args.classCostOffset + i * 3;
+        SetCapacity(args, classNode, costNode + 1, danceClass.maxSize - danceClass.minSize);
+        SetCapacity(args, classNode, costNode + 2, danceClass.additionalSpace);
+    }
+}
+
+void SetArcCosts(MinCostMaxFlowArgs& args, const CostModel& costModel)
+{
+    const std::vector<Studancer>& dancers = *args.dancers;
+    const std::vector<DanceClass>& classes = *args.classes;
+
+    std::map<std::string, int> classMap;
+    for (int i = 0; i < classes.size(); i++)
+    {
+        classMap.emplace(std::make_pair(classes[i].name, i));
+    }
+
+    // The choices are walked like in EncodeDancer(), so every arc gets the rank it was encoded with
+    for (int i = 0; i < dancers.size(); i++)
+    {
+        const Studancer& dancer = dancers[i];
+        int choiceNumber = 0;
+        for (int j = 0; j < dancer.chosenClasses.size(); j++)
+        {
+            const std::string& chosenClass = dancer.chosenClasses[j];
+            if (chosenClass == "")
+            {
+                continue;
+            }
+            SetCost(args, args.dancerOffset + i, args.classOffset + classMap[chosenClass], GetChoiceArcCost(costModel, dancer, j, choiceNumber));
+            choiceNumber++;
+        }
+    }
+
+    for (int i = 0; i < classes.size(); i++)
+    {
+        int classNode = args.classOffset + classMap[classes[i].name];
+        int costNode = args.classCostOffset + i * 3;
+        if (classes[i].name == "niet-dansend lid" || classes[i].name == "unenrolled")
+        {
+            SetCost(args, classNode, costNode, costModel.withinClassBoundsCost);
+        }
+        else
+        {
+            SetCost(args, classNode, costNode, costModel.underMinBoundsCost);
+            SetCost(args, classNode, costNode + 1, costModel.withinClassBoundsCost);
+            SetCost(args, classNode, costNode + 2, costModel.additionalSpaceCost);
+        }
+    }
+}
+
+MinCostMaxFlowArgs ShareMinCostMaxFlowTopology(const MinCostMaxFlowArgs& base, std::shared_ptr<SolverArena> arena)
+{
+    const size_t nodes = base.numNodes;
+    const size_t arcs = nodes * nodes;
+    size_t spaceRequired = 0;
+    spaceRequired += AlignToCacheLine(nodes * sizeof(int64_t));     // distances
+    spaceRequired += AlignToCacheLine(nodes * sizeof(int64_t));     // potentials
+    spaceRequired += AlignToCacheLine(nodes * sizeof(int));         // parents
+    spaceRequired += AlignToCacheLine(arcs * sizeof(int));          // flow
+    spaceRequired += AlignToCacheLine(arcs * sizeof(int64_t));      // cost
+
+    arena->Reset();
+    arena->Reserve(spaceRequired);
+
+    MinCostMaxFlowArgs args = {};
+    args.sourceNode = base.sourceNode;
+    args.sinkNode = base.sinkNode;
+    args.dancerOffset = base.dancerOffset;
+    args.classOffset = base.classOffset;
+    args.classCostOffset = base.classCostOffset;
+    args.numNodes = base.numNodes;
+    args.adjecencyList = base.adjecencyList;
+    args.expectedMaxFlow = base.expectedMaxFlow;
+    args.dancers = base.dancers;
+    args.classes = base.classes;
+
+    args.distance = arena->AllocateArray<int64_t>(nodes);
+    args.potential = arena->AllocateArray<int64_t>(nodes);
+    args.parent = arena->AllocateArray<int>(nodes);
+    args.flow = arena->AllocateArray<int>(arcs);
+    args.cost = arena->AllocateArray<int64_t>(arcs);
+    args.capacity = base.capacity;
+    args.arena = arena;
+
+    memset(args.flow, 0, arcs * sizeof(args.flow[0]));
+    memcpy(args.cost, base.cost, arcs * sizeof(args.cost[0]));
+
+    return args;
+}
+
+int64_t GetFlowCost(const MinCostMaxFlowArgs& args)
+{
+    int64_t totalCost = 0;
+    for (int node = 0; node < args.numNodes; node++)
+    {
+        for (int neighbour : args.adjecencyList[node])
+        {
+            if (GetCapacity(args, node, neighbour) > 0)
+            {
+                totalCost += GetFlow(args, node, neighbour) * GetCost(args, node, neighbour);
+            }
+        }
+    }
+    return totalCost;
+}
+
+SolvedFlow SaveSolvedFlow(const MinCostMaxFlowArgs& args)
+{
+    SolvedFlow solved;
+    for (int node = 0; node < args.numNodes; node++)
+    {
+        for (int neighbour : args.adjecencyList[node])
+        {
+            if (GetCapacity(args, node, neighbour) > 0 && GetFlow(args, node, neighbour) > 0)
+            {
+                solved.arcs.push_back({ node, neighbour, GetFlow(args, node, neighbour) });
+            }
+        }
+    }
+    solved.potential.assign(args.potential, args.potential + args.numNodes);
+    return solved;
+}
+
+void RestoreSolvedFlow(MinCostMaxFlowArgs& args, const SolvedFlow& solved)
+{
+    for (const SolvedFlow::Arc& arc : solved.arcs)
+    {
+        SetFlow(args, arc.from, arc.to, arc.flow);
+    }
+    memcpy(args.potential, solved.potential.data(), args.numNodes * sizeof(args.potential[0]));
+}
+
+// Node a class gets or loses a seat on, the arc to it holds the room within the bounds of the class
+inline int SeatNode(const MinCostMaxFlowArgs& args, int classIndex)
+{
+    return args.classCostOffset + classIndex * 3 + 1;
+}
+
+// Number of dancers on the path from startNode to endNode along the parent pointers, every one of them changes class
+int CountDancersAlongParents(const MinCostMaxFlowArgs& args, const int* parent, int startNode, int endNode)
+{
+    int dancers = 0;
+    for (int currentNode = endNode; currentNode != startNode; currentNode = parent[currentNode])
+    {
+        dancers += GetNodeType(args, currentNode) == Dancer;
+    }
+    return dancers;
+}
+
+std::vector<std::vector<WaitlistEntry>> ComputeWaitlists(const MinCostMaxFlowArgs& args)
+{
+    const std::vector<DanceClass>& classes = *args.classes;
+    std::vector<std::vector<WaitlistEntry>> waitlists(classes.size());
+
+    GetTaskPool().ParallelFor((int)classes.size(), [&](int classIndex) {
+        const DanceClass& danceClass = classes[classIndex];
+        if (danceClass.name == "niet-dansend lid" || danceClass.name == "unenrolled")
+        {
+            return;
+        }
+
+        const int classNode = args.classOffset + classIndex;
+        const int seatNode = SeatNode(args, classIndex);
+
+        // The extra seat is one more unit on the arc from the class to its seat node. From there the cheapest way back
+        // to a dancer that chose the class closes the cycle, the class itself is skipped so nobody moves out to make room
+        std::vector<int64_t> distance(args.numNodes);
+        std::vector<int> parent(args.numNodes);
+        SearchReducedCosts(args, seatNode, classNode, distance.data(), parent.data());
+
+        std::vector<WaitlistEntry>& waitlist = waitlists[classIndex];
+        for (int neighbour : args.adjecencyList[classNode])
+        {
+            if (GetNodeType(args, neighbour) != Dancer || !CanFlow(args, neighbour, classNode) || distance[neighbour] == INF64)
+            {
+                continue;
+            }
+
+            int64_t pathCost = distance[neighbour] - args.potential[seatNode] + args.potential[neighbour];
+            int64_t cycleCost = GetCost(args, classNode, seatNode) + pathCost + GetCost(args, neighbour, classNode);
+            waitlist.push_back({ neighbour - args.dancerOffset, -cycleCost });
+        }
+
+        // Dancers that gain the same are kept in dancer order, like the ties of the solve
+        std::stable_sort(waitlist.begin(), waitlist.end(), [](const WaitlistEntry& a, const WaitlistEntry& b) {
+            return a.costReduction > b.costReduction;
+        });
+    });
+
+    return waitlists;
+}
+
+std::vector<ClassSensitivity> ComputeClassSensitivity(const MinCostMaxFlowArgs& args)
+{
+    const std::vector<DanceClass>& classes = *args.classes;
+    std::vector<ClassSensitivity> sensitivity(classes.size());
+
+    GetTaskPool().ParallelFor((int)classes.size(), [&](int classIndex) {
+        const DanceClass& danceClass = classes[classIndex];
+        if (danceClass.name == "niet-dansend lid" || danceClass.name == "unenrolled")
+        {
+            return;
+        }
+
+        const int classNode = args.classOffset + classIndex;
+        const int seatNode = SeatNode(args, classIndex);
+        std::vector<int64_t> distance(args.numNodes);
+        std::vector<int> parent(args.numNodes);
+
+        // One more seat: the cheapest way from the seat node back to the class, which either moves dancers in
+        // or lets the class give up a seat of its additional space
+        SeatChange& extraSeat = sensitivity[classIndex].extraSeat;
+        extraSeat = { true, 0, 0 };
+        SearchReducedCosts(args, seatNode, -1, distance.data(), parent.data());
+        if (distance[classNode] != INF64)
+        {
+            int64_t pathCost = distance[classNode] - args.potential[seatNode] + args.potential[classNode];
+            int64_t cycleCost = GetCost(args, classNode, seatNode) + pathCost;
+            if (cycleCost < 0)
+            {
+                extraSeat.costChange = cycleCost;
+                extraSeat.dancersMoved = CountDancersAlongParents(args, parent.data(), seatNode, classNode);
+            }
+        }
+
+        // One seat less only moves someone when the class is full, they go along the cheapest other way to the sink
+        SeatChange& removedSeat = sensitivity[classIndex].removedSeat;
+        removedSeat = { GetCapacity(args, classNode, seatNode) > 0, 0, 0 };
+        if (removedSeat.isPossible && !CanFlow(args, classNode, seatNode))
+        {
+            SearchReducedCosts(args, classNode, -1, distance.data(), parent.data());
+            if (distance[seatNode] == INF64)
+            {
+                removedSeat.isPossible = false;
+            }
+            else
+            {
+                int64_t pathCost = distance[seatNode] - args.potential[classNode] + args.potential[seatNode];
+                removedSeat.costChange = pathCost - GetCost(args, classNode, seatNode);
+                removedSeat.dancersMoved = CountDancersAlongParents(args, parent.data(), classNode, seatNode);
+            }
+        }
+    });
+
+    return sensitivity;
+}
+
+int VerifyClassSensitivity(const MinCostMaxFlowArgs& args, const std::vector<ClassSensitivity>& sensitivity, const CliArguments& cliArgs)
+{
+    const std::vector<DanceClass>& classes = *args.classes;
+    std::vector<int> identity(args.classOffset - args.dancerOffset);
+    for (int i = 0; i < identity.size(); i++)
+    {
+        identity[i] = i;
+    }
+
+    // Every worker changes its own copy of the network, copied again from the solved network before every change
+    TaskPool& pool = GetTaskPool();
+    int numWorkers = std::max(1, std::min(pool.GetNumThreads(), (int)classes.size()));
+    std::vector<MinCostMaxFlowArgs> copies(numWorkers);
+    for (auto& copy : copies)
+    {
+        copy = AllocateMinCostMaxFlow(args.numNodes, std::make_shared<SolverArena>(cliArgs.hugePages));
+    }
+
+    std::atomic<int> nextClass(0);
+    std::atomic<int> mismatches(0);
+    pool.ParallelFor(numWorkers, [&](int workerIndex) {
+        MinCostMaxFlowArgs& copy = copies[workerIndex];
+        for (int classIndex = nextClass++; classIndex < classes.size(); classIndex = nextClass++)
+        {
+            const DanceClass& danceClass = classes[classIndex];
+            if (danceClass.name == "niet-dansend lid" || danceClass.name == "unenrolled")
+            {
+                continue;
+            }
+
+            const int capacity = GetCapacity(args, args.classOffset + classIndex, SeatNode(args, classIndex));
+            const SeatChange* changes[2] = { &sensitivity[classIndex].extraSeat, &sensitivity[classIndex].removedSeat };
+            for (int direction = 0; direction < 2; direction++)
+            {
+                const SeatChange& change = *changes[direction];
+                if (!change.isPossible)
+                {
+                    continue;
+                }
+
+                PermuteDancerNodes(args, identity, copy);
+                copy.dancers = args.dancers;
+                ChangeClassCapacity(copy, classIndex, direction == 0 ? capacity + 1 : capacity - 1);
+
+                int64_t costChange = 0;
+                for (auto& decision : copy.decisions)
+                {
+                    costChange += decision.costChange;
+                }
+
+                if (costChange != change.costChange)
+                {
+                    Print("Sensitivity of %s for %s seat predicted a cost change of %lli, applying it changed the cost by %lli\n",
+                        danceClass.name.c_str(), direction == 0 ? "one more" : "one less", (long long)change.costChange, (long long)costChange);
+                    mismatches++;
+                }
+            }
+        }
+    });
+
+    return mismatches;
+}
+
+// Finds the root of a class in the union find of FindClassComponents()
+int FindComponentRoot(std::vector<int>& root, int classIndex)
+{
+    while (root[classIndex] != classIndex)
+    {
+        root[classIndex] = root[root[classIndex]];
+        classIndex = root[classIndex];
+    }
+    return classIndex;
+}
+
+// A special class only couples the classes of its dancers when it cannot take all of them, otherwise every seat costs the same
+bool IsCouplingClass(const DanceClass& danceClass, int demand, const CliArguments& cliArgs)
+{
+    if (danceClass.name == "unenrolled")
+    {
+        int capacity = cliArgs.maxUnenroll != 0xFFFFFFFFU ? cliArgs.maxUnenroll : danceClass.maxSize;
+        return capacity < demand;
+    }
+    if (danceClass.name == "niet-dansend lid")
+    {
+        return danceClass.maxSize < demand;
+    }
+    return true;
+}
+
+std::vector<std::vector<int>> FindClassComponents(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const CliArguments& cliArgs)
+{
+    std::map<std::string, int> classMap;
+    for (int i = 0; i < classes.size(); i++)
+    {
+        classMap.emplace(std::make_pair(classes[i].name, i));
+    }
+
+    std::vector<int> demand(classes.size(), 0);
+    for (const Studancer& dancer : dancers)
+    {
+        for (const std::string& chosenClass : dancer.chosenClasses)
+        {
+            if (chosenClass != "")
+            {
+                demand[classMap[chosenClass]]++;
+            }
+        }
+    }
+
+    std::vector<int> root(classes.size());
+    std::iota(root.begin(), root.end(), 0);
+    for (const Studancer& dancer : dancers)
+    {
+        int first = -1;
+        for (const std::string& chosenClass : dancer.chosenClasses)
+        {
+            if (chosenClass == "")
+            {
+                continue;
+            }
+            int classIndex = classMap[chosenClass];
+            if (!IsCouplingClass(classes[classIndex], demand[classIndex], cliArgs))
+            {
+                continue;
+            }
+            if (first == -1)
+            {
+                first = classIndex;
+            }
+            root[FindComponentRoot(root, classIndex)] = FindComponentRoot(root, first);
+        }
+    }
+
+    // Components in the order of their first class
+    std::vector<std::vector<int>> components;
+    std::vector<int> componentOfRoot(classes.size(), -1);
+    for (int i = 0; i < classes.size(); i++)
+    {
+        if (!IsCouplingClass(classes[i], demand[i], cliArgs))
+        {
+            continue;
+        }
+        int classRoot = FindComponentRoot(root, i);
+        if (componentOfRoot[classRoot] == -1)
+        {
+            componentOfRoot[classRoot] = (int)components.size();
+            components.emplace_back();
+        }
+        components[componentOfRoot[classRoot]].push_back(i);
+    }
+
+    return components;
+}
+
+// Like SuccessiveShortestPaths(), with every path logged for the decision log
+std::pair<int64_t, int> AssignAlongShortestPaths(MinCostMaxFlowArgs& args)
+{
+    std::pair<int64_t, int> result = std::make_pair(0, 0);
+    while (Dijkstra(args))
+    {
+        Decision decision = {};
+        decision.type = AssignDancer;
+        decision.flowChange = 1;
+        decision.costChange = AugmentAlongParents(args, &decision.changedNodes);
+        result.first += decision.costChange;
+        result.second++;
+        args.decisions.push_back(decision);
+    }
+    return result;
+}
+
+// Source, dancers, classes, cost nodes and sink of a subnetwork mapped to the same layout in args
+// dancerIndices and classIndices give the dancers and classes of args the subnetwork was encoded from
+std::vector<int> MapSubnetworkNodes(const MinCostMaxFlowArgs& args, const MinCostMaxFlowArgs& subArgs, const std::vector<int>& dancerIndices,
+                                    const std::vector<int>& classIndices)
+{
+    std::vector<int> nodeMap(subArgs.numNodes, 0);
+    nodeMap[subArgs.sourceNode] = args.sourceNode;
+    nodeMap[subArgs.sinkNode] = args.sinkNode;
+    for (int i = 0; i < dancerIndices.size(); i++)
+    {
+        nodeMap[subArgs.dancerOffset + i] = args.dancerOffset + dancerIndices[i];
+    }
+    for (int i = 0; i < classIndices.size(); i++)
+    {
+        int classIndex = classIndices[i];
+        nodeMap[subArgs.classOffset + i] = args.classOffset + classIndex;
+        for (int k = 0; k < 3; k++)
+        {
+            nodeMap[subArgs.classCostOffset + i * 3 + k] = args.classCostOffset + classIndex * 3 + k;
+        }
+    }
+    return nodeMap;
+}
+
+// Adds the flow and the decisions of a solved subnetwork to args, nodeMap gives the node of args for every node of the subnetwork
+void MergeSubnetwork(MinCostMaxFlowArgs& args, const MinCostMaxFlowArgs& subArgs, const std::vector<int>& nodeMap)
+{
+    for (int node = 0; node < subArgs.numNodes; node++)
+    {
+        for (int neighbour : subArgs.adjecencyList[node])
+        {
+            if (GetCapacity(subArgs, node, neighbour) > 0 && GetFlow(subArgs, node, neighbour) != 0)
+            {
+                AddFlow(args, nodeMap[node], nodeMap[neighbour], GetFlow(subArgs, node, neighbour));
+            }
+        }
+    }
+
+    for (Decision decision : subArgs.decisions)
+    {
+        for (int& node : decision.changedNodes)
+        {
+            node = nodeMap[node];
+        }
+        args.decisions.push_back(std::move(decision));
+    }
+}
+
+std::pair<int64_t, int> MinCostMaxFlowByComponents(MinCostMaxFlowArgs& args, const CliArguments& cliArgs)
+{
+    const std::vector<Studancer>& dancers = *args.dancers;
+    const std::vector<DanceClass>& classes = *args.classes;
+
+    std::vector<std::vector<int>> components = FindClassComponents(dancers, classes, cliArgs);
+
+    // Every component gets the special classes that couple nothing, dancers that only chose those form a component of their own
+    std::vector<int> componentOfClass(classes.size(), -1);
+    for (int component = 0; component < components.size(); component++)
+    {
+        for (int classIndex : components[component])
+        {
+            componentOfClass[classIndex] = component;
+        }
+    }
+    components.emplace_back();
+
+    struct Subnetwork
+    {
+        std::vector<int> dancerIndices;
+        std::vector<int> classIndices;
+        std::vector<Studancer> dancers;
+        std::vector<DanceClass> classes;
+        std::vector<int> nodeMap;       // node of the subnetwork -> node of args
+        MinCostMaxFlowArgs args;
+        std::pair<int64_t, int> result;
+    };
+    std::vector<Subnetwork> subnetworks(components.size());
+
+    std::map<std::string, int> classMap;
+    for (int i = 0; i < classes.size(); i++)
+    {
+        classMap.emplace(std::make_pair(classes[i].name, i));
+    }
+
+    for (int dancerIndex = 0; dancerIndex < dancers.size(); dancerIndex++)
+    {
+        int component = (int)components.size() - 1;
+        for (const std::string& chosenClass : dancers[dancerIndex].chosenClasses)
+        {
+            if (chosenClass != "" && componentOfClass[classMap[chosenClass]] != -1)
+            {
+                component = componentOfClass[classMap[chosenClass]];
+                break;
+            }
+        }
+        subnetworks[component].dancerIndices.push_back(dancerIndex);
+    }
+
+    for (int component = 0; component < components.size(); component++)
+    {
+        Subnetwork& subnetwork = subnetworks[component];
+        for (int classIndex = 0; classIndex < classes.size(); classIndex++)
+        {
+            if (componentOfClass[classIndex] == component || componentOfClass[classIndex] == -1)
+            {
+                subnetwork.classIndices.push_back(classIndex);
+            }
+        }
+        for (int dancerIndex : subnetwork.dancerIndices)
+        {
+            subnetwork.dancers.push_back(dancers[dancerIndex]);
+        }
+        for (int classIndex : subnetwork.classIndices)
+        {
+            subnetwork.classes.push_back(classes[classIndex]);
+        }
+    }
+
+    // Largest first, so the small ones fill up the threads at the end
+    std::vector<int> order(subnetworks.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return subnetworks[a].dancerIndices.size() > subnetworks[b].dancerIndices.size();
+    });
+
+    CliArguments encodeArgs = cliArgs;
+    encodeArgs.isUpdate = false;
+    std::atomic<int> nextSubnetwork(0);
+    TaskPool& pool = GetTaskPool();
+    pool.ParallelFor(std::min(pool.GetNumThreads(), (int)subnetworks.size()), [&](int) {
+        for (int position = nextSubnetwork++; position < subnetworks.size(); position = nextSubnetwork++)
+        {
+            Subnetwork& subnetwork = subnetworks[order[position]];
+            if (subnetwork.dancers.empty())
+            {
+                subnetwork.result = std::make_pair(0, 0);
+                continue;
+            }
+
+            subnetwork.args = EncodeMinCostMaxFlow(subnetwork.dancers, subnetwork.classes, encodeArgs);
+            MinCostMaxFlowArgs& subArgs = subnetwork.args;
+            if (!ComputePotentials(subArgs))
+            {
+                printf("ERROR: the network of a class component contains a negative cycle\n");
+                exit(-1);
+            }
+
+            subnetwork.result = AssignAlongShortestPaths(subArgs);
+            subnetwork.nodeMap = MapSubnetworkNodes(args, subArgs, subnetwork.dancerIndices, subnetwork.classIndices);
+        }
+    });
+
+    // Merge the flows, the special classes that couple nothing add up over the components
+    std::pair<int64_t, int> result = std::make_pair(0, 0);
+    int largestComponent = 0;
+    for (int component = 0; component < subnetworks.size(); component++)
+    {
+        Subnetwork& subnetwork = subnetworks[component];
+        if (subnetwork.dancers.empty())
+        {
+            continue;
+        }
+
+        MergeSubnetwork(args, subnetwork.args, subnetwork.nodeMap);
+
+        result.first += subnetwork.result.first;
+        result.second += subnetwork.result.second;
+        largestComponent = std::max(largestComponent, (int)subnetwork.dancerIndices.size());
+    }
+
+    Print("Solved %i class components separately, the largest has %i of the %i dancers\n\n", (int)components.size() - 1, largestComponent, (int)dancers.size());
+
+    return result;
+}
+
+std::pair<int64_t, int> MinCostMaxFlowWithPresolve(MinCostMaxFlowArgs& args, const CliArguments& cliArgs)
+{
+    const std::vector<Studancer>& dancers = *args.dancers;
+    const std::vector<DanceClass>& classes = *args.classes;
+
+    PresolveResult presolve = PresolveAssignment(dancers, classes);
+
+    CliArguments encodeArgs = cliArgs;
+    encodeArgs.isUpdate = false;
+    MinCostMaxFlowArgs reduced = EncodeMinCostMaxFlow(presolve.dancers, presolve.classes, encodeArgs);
+
+    // Board members that got one of their two classes only have one unit left, and cannot get the same class twice
+    for (int i = 0; i < presolve.dancers.size(); i++)
+    {
+        int dancerNode = reduced.dancerOffset + i;
+        for (int classIndex : presolve.fixedClasses[i])
+        {
+            SetCapacity(reduced, reduced.sourceNode, dancerNode, GetCapacity(reduced, reduced.sourceNode, dancerNode) - 1);
+            SetCapacity(reduced, dancerNode, reduced.classOffset + classIndex, 0);
+            reduced.expectedMaxFlow--;
+        }
+    }
+
+    Print("Presolve left %i of the %i nodes of the network\n", reduced.numNodes, args.numNodes);
+    PrintPresolve(presolve, classes, (int)dancers.size());
+
+    std::pair<int64_t, int> result = std::make_pair(0, 0);
+    if (!presolve.dancers.empty())
+    {
+        result = MinCostMaxFlow(reduced, encodeArgs);
+    }
+
+    // The reduced network keeps every class, only the dancers are a subset
+    std::vector<int> classIndices(classes.size());
+    std::iota(classIndices.begin(), classIndices.end(), 0);
+    std::vector<int> nodeMap = MapSubnetworkNodes(args, reduced, presolve.dancerIndices, classIndices);
+
+    // The fixed placements come first in the decision log, they were made before the network was solved
+    const CostModel& costModel = GetCostModel();
+    for (const FixedPlacement& placement : presolve.fixedPlacements)
+    {
+        int dancerNode = args.dancerOffset + placement.dancer;
+        int classNode = args.classOffset + placement.classIndex;
+        int costNode = args.classCostOffset + placement.classIndex * 3;
+        AddFlow(args, args.sourceNode, dancerNode, 1);
+        AddFlow(args, dancerNode, classNode, 1);
+        AddFlow(args, classNode, costNode, 1);
+        AddFlow(args, costNode, args.sinkNode, 1);
+
+        Decision decision = {};
+        decision.type = AssignDancer;
+        decision.flowChange = 1;
+        decision.costChange = GetCost(args, args.sourceNode, dancerNode) + GetCost(args, dancerNode, classNode) + costModel.underMinBoundsCost;
+        decision.changedNodes = { args.sinkNode, costNode, classNode, dancerNode, args.sourceNode };
+        args.decisions.push_back(decision);
+
+        result.first += decision.costChange;
+        result.second++;
+    }
+
+    MergeSubnetwork(args, reduced, nodeMap);
+
+    return result;
+}
+
+int GetPriorityTier(DancerPriorityGroup group)
+{
+    switch (group)
+    {
+    case KBBoard:
+    case HBBoard:
+    case Damn:
+        return 0;
+    case ExistingMember:
+        return 1;
+    default:
+        return 2;
+    }
+}
+
+std::pair<int64_t, int> MinCostMaxFlowByTiers(MinCostMaxFlowArgs& args, const CliArguments& cliArgs)
+{
+    const std::vector<Studancer>& dancers = *args.dancers;
+    const std::vector<DanceClass>& classes = *args.classes;
+
+    std::vector<int> classIndices(classes.size());
+    std::iota(classIndices.begin(), classIndices.end(), 0);
+
+    // The seats the tiers before it left, per class what is left below the minimum size, up to the maximum size and of the additional space
+    std::vector<DanceClass> remainingClasses = classes;
+    CliArguments encodeArgs = cliArgs;
+    encodeArgs.isUpdate = false;
+
+    std::pair<int64_t, int> result = std::make_pair(0, 0);
+    Print("Solving MCMF per priority tier:\n");
+    for (int tier = 0; tier < PriorityTierCount; tier++)
+    {
+        std::vector<int> dancerIndices;
+        std::vector<Studancer> tierDancers;
+        for (int i = 0; i < dancers.size(); i++)
+        {
+            if (GetPriorityTier(dancers[i].priorityGroup) == tier)
+            {
+                dancerIndices.push_back(i);
+                tierDancers.push_back(dancers[i]);
+            }
+        }
+        if (tierDancers.empty())
+        {
+            continue;
+        }
+
+        MinCostMaxFlowArgs subArgs = EncodeMinCostMaxFlow(tierDancers, remainingClasses, encodeArgs);
+        if (!ComputePotentials(subArgs))
+        {
+            printf("ERROR: the network of priority tier %i contains a negative cycle\n", tier);
+            exit(-1);
+        }
+        std::pair<int64_t, int> tierResult = AssignAlongShortestPaths(subArgs);
+        result.first += tierResult.first;
+        result.second += tierResult.second;
+        Print("    tier %i: %i dancers, %i of the %i nodes, %i of %i placed\n", tier, (int)tierDancers.size(), subArgs.numNodes, args.numNodes,
+            tierResult.second, subArgs.expectedMaxFlow);
+
+        // Lock the seats of this tier, the tiers after it only get what is left
+        for (int i = 0; i < classes.size(); i++)
+        {
+            DanceClass& danceClass = remainingClasses[i];
+            int classNode = subArgs.classOffset + i;
+            int costNode = subArgs.classCostOffset + i * 3;
+            int underMin = GetFlow(subArgs, classNode, costNode);
+            if (danceClass.name == "niet-dansend lid" || danceClass.name == "unenrolled")
+            {
+                danceClass.maxSize -= underMin;
+                if (danceClass.name == "unenrolled" && encodeArgs.maxUnenroll != 0xFFFFFFFFU)
+                {
+                    encodeArgs.maxUnenroll -= underMin;
+                }
+                continue;
+            }
+
+            int withinBounds = danceClass.maxSize - danceClass.minSize - GetFlow(subArgs, classNode, costNode + 1);
+            danceClass.minSize -= underMin;
+            danceClass.maxSize = danceClass.minSize + withinBounds;
+            danceClass.additionalSpace -= GetFlow(subArgs, classNode, costNode + 2);
+        }
+
+        MergeSubnetwork(args, subArgs, MapSubnetworkNodes(args, subArgs, dancerIndices, classIndices));
+    }
+
+    // Locked seats keep a tier from giving up an equally cheap class to a later tier, or can leave a later tier without room
+    // Cancelling the cycles and augmenting what is left on the whole network makes the flow a min cost max flow again
+    // When not every dancer fits, a later tier may need a seat an earlier tier took, so cycles through the source count too
+    // The few cycles the locks leave are found quicker with Bellman-Ford than with the minimum mean cycle of CancelNegativeCycles()
+    int numDecisions = (int)args.decisions.size();
+    std::vector<ResidualArc> arcs;
+    std::vector<int> cycle;
+    while (true)
+    {
+        CollectResidualArcs(args, arcs, true);
+        if (!FindNegativeCycle(args, arcs, cycle))
+        {
+            break;
+        }
+        result.first += CancelCycle(args, cycle);
+    }
+    memcpy(args.potential, args.distance, args.numNodes * sizeof(args.potential[0]));
+
+    std::pair<int64_t, int> repairResult = AssignAlongShortestPaths(args);
+    result.first += repairResult.first;
+    result.second += repairResult.second;
+
+    Print("Repairing the locked tiers took %i decisions\n\n", (int)args.decisions.size() - numDecisions);
+
+    return result;
+}
+
+// Breadth first search from the source to the sink in the residual graph, without looking at the costs
+// Returns false when the sink cannot be reached
+bool FindAugmentingPath(MinCostMaxFlowArgs& args)
+{
+    InitArray(args.parent, -1, args.numNodes);
+    args.parent[args.sourceNode] = args.sourceNode;
+
+    std::vector<int> queue = { args.sourceNode };
+    for (size_t i = 0; i < queue.size() && args.parent[args.sinkNode] == -1; i++)
+    {
+        int node = queue[i];
+        for (int neighbour : args.adjecencyList[node])
+        {
+            if (args.parent[neighbour] == -1 && (CanFlow(args, node, neighbour) || GetFlow(args, neighbour, node) > 0))
+            {
+                args.parent[neighbour] = node;
+                queue.push_back(neighbour);
+            }
+        }
+    }
+
+    return args.parent[args.sinkNode] != -1;
+}
+
+int64_t ComputeDualLowerBound(const MinCostMaxFlowArgs& args, const int64_t* potential, int flowValue)
+{
+    // Any flow of flowValue costs the sum of its reduced costs plus the potential difference between the sink and the source per unit
+    // Only arcs with a negative reduced cost can make the sum negative, and the network has no cycles, so no arc carries more than flowValue
+    int64_t lowerBound = (potential[args.sinkNode] - potential[args.sourceNode]) * flowValue;
+    for (int node = 0; node < args.numNodes; node++)
+    {
+        for (int neighbour : args.adjecencyList[node])
+        {
+            int capacity = GetCapacity(args, node, neighbour);
+            int64_t reducedCost = GetCost(args, node, neighbour) + potential[node] - potential[neighbour];
+            if (capacity > 0 && reducedCost < 0)
+            {
+                lowerBound += reducedCost * std::min(capacity, flowValue);
+            }
+        }
+    }
+    return lowerBound;
+}
+
+AnytimeResult ImproveFlowWithinBudget(MinCostMaxFlowArgs& args, std::chrono::steady_clock::time_point deadline)
+{
+    AnytimeResult result = {};
+
+    // Place whoever the seed left out first, the lower bound only holds for flows that place as many dancers
+    // Most fit in a class they chose that still has a seat, the cheapest of those is taken without moving anyone else
+    for (int dancerNode = args.dancerOffset; dancerNode < args.classOffset; dancerNode++)
+    {
+        while (CanFlow(args, args.sourceNode, dancerNode))
+        {
+            int bestClass = -1;
+            int bestSeat = -1;
+            int64_t bestCost = INF64;
+            for (int classNode : args.adjecencyList[dancerNode])
+            {
+                if (!CanFlow(args, dancerNode, classNode))
+                {
+                    continue;
+                }
+                for (int seatNode : args.adjecencyList[classNode])
+                {
+                    int64_t cost = GetCost(args, dancerNode, classNode) + GetCost(args, classNode, seatNode);
+                    if (CanFlow(args, classNode, seatNode) && cost < bestCost)
+                    {
+                        bestClass = classNode;
+                        bestSeat = seatNode;
+                        bestCost = cost;
+                    }
+                }
+            }
+            if (bestClass == -1)
+            {
+                break;
+            }
+
+            Decision decision = {};
+            decision.type = AssignDancer;
+            decision.flowChange = 1;
+            decision.costChange = GetCost(args, args.sourceNode, dancerNode) + bestCost;
+            decision.changedNodes = { args.sinkNode, bestSeat, bestClass, dancerNode, args.sourceNode };
+            AddFlow(args, args.sourceNode, dancerNode, 1);
+            AddFlow(args, dancerNode, bestClass, 1);
+            AddFlow(args, bestClass, bestSeat, 1);
+            AddFlow(args, bestSeat, args.sinkNode, 1);
+            args.decisions.push_back(decision);
+            result.pathsAugmented++;
+        }
+    }
+
+    while (FindAugmentingPath(args))
+    {
+        Decision decision = {};
+        decision.type = AssignDancer;
+        decision.flowChange = 1;
+        decision.costChange = AugmentAlongParents(args, &decision.changedNodes);
+        args.decisions.push_back(decision);
+        result.pathsAugmented++;
+    }
+
+    int flowValue = 0;
+    for (int neighbour : args.adjecencyList[args.sourceNode])
+    {
+        flowValue += GetFlow(args, args.sourceNode, neighbour);
+    }
+
+    std::vector<int64_t> zeroPotential(args.numNodes, 0);
+    result.lowerBound = ComputeDualLowerBound(args, zeroPotential.data(), flowValue);
+    result.completedCost = GetFlowCost(args);
+
+    // Every cancelled cycle keeps the flow a valid assignment, so stopping at the deadline leaves one that can be exported
+    std::vector<ResidualArc> arcs;
+    std::vector<int> cycle;
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+        CollectResidualArcs(args, arcs, true);
+        bool hasCycle = FindNegativeCycle(args, arcs, cycle);
+
+        // Also the distances of a search that stopped at a cycle are potentials, just not tight ones
+        result.lowerBound = std::max(result.lowerBound, ComputeDualLowerBound(args, args.distance, flowValue));
+
+        if (!hasCycle)
+        {
+            memcpy(args.potential, args.distance, args.numNodes * sizeof(args.potential[0]));
+            result.isOptimal = true;
+            break;
+        }
+
+        CancelCycle(args, cycle);
+        result.cyclesCancelled++;
+    }
+
+    result.cost = GetFlowCost(args);
+    return result;
+}
+
+int CheckFlow(const MinCostMaxFlowArgs& args)
+{
+    int problems = 0;
+    for (int node = 0; node < args.numNodes; node++)
+    {
+        int incomming = 0;
+        int outgoing = 0;
+        for (int neighbour : args.adjecencyList[node])
+        {
+            int capacity = GetCapacity(args, node, neighbour);
+            int flow = GetFlow(args, node, neighbour);
+            if (flow < 0 || flow > capacity)
+            {
+                Print("Problem: flow %i from %s to %s is outside of its capacity %i\n", flow, GetNodeName(args, node).c_str(), GetNodeName(args, neighbour).c_str(), capacity);
+                problems++;
+            }
+            incomming += GetFlow(args, neighbour, node);
+            outgoing += flow;
+        }
+
+        if (node != args.sourceNode && node != args.sinkNode && incomming != outgoing)
+        {
+            Print("Problem: %i flow comes into %s, but %i goes out\n", incomming, GetNodeName(args, node).c_str(), outgoing);
+            problems++;
+        }
+    }
+    return problems;
+}
+
+FlowCertificate CertifyFlow(MinCostMaxFlowArgs& args, const std::vector<int64_t>* potential)
+{
+    FlowCertificate certificate = {};
+
+    // A dancer that can still be placed makes the flow not maximal, whatever it costs
+    if (FindAugmentingPath(args))
+    {
+        for (int node = args.sinkNode; node != args.sourceNode; node = args.parent[node])
+        {
+            certificate.path.push_back(node);
+        }
+        certificate.path.push_back(args.sourceNode);
+        std::reverse(certificate.path.begin(), certificate.path.end());
+        return certificate;
+    }
+    certificate.isMaximal = true;
+
+    std::vector<ResidualArc> arcs;
+    CollectResidualArcs(args, arcs, true);
+
+    // Potentials without a negative reduced cost on any residual arc prove there is no negative cycle, in a single pass
+    if (potential && potential->size() == (size_t)args.numNodes)
+    {
+        const int64_t* p = potential->data();
+        bool isValid = std::all_of(arcs.begin(), arcs.end(), [&](const ResidualArc& arc) {
+            return arc.cost + p[arc.from] - p[arc.to] >= 0;
+        });
+        if (isValid)
+        {
+            memcpy(args.potential, p, args.numNodes * sizeof(args.potential[0]));
+            certificate.isOptimal = true;
+            certificate.usedPotentials = true;
+            return certificate;
+        }
+    }
+
+    if (!FindNegativeCycle(args, arcs, certificate.cycle))
+    {
+        memcpy(args.potential, args.distance, args.numNodes * sizeof(args.potential[0]));
+        certificate.isOptimal = true;
+        return certificate;
+    }
+
+    for (size_t i = 0; i + 1 < certificate.cycle.size(); i++)
+    {
+        int u = certificate.cycle[i];
+        int v = certificate.cycle[i + 1];
+        certificate.cycleCost += GetCapacity(args, u, v) > 0 ? GetCost(args, u, v) : -GetCost(args, v, u);
+    }
+    return certificate;
+}
+
+void PrintFlowChange(const MinCostMaxFlowArgs& args, const std::vector<int>& nodes)
+{
+    struct DancerChange
+    {
+        int dancerNode;
+        std::string leaves;
+        std::string joins;
+        int64_t costChange;
+    };
+    std::vector<DancerChange> changes;
+
+    auto findChange = [&](int dancerNode) -> DancerChange& {
+        for (DancerChange& change : changes)
+        {
+            if (change.dancerNode == dancerNode)
+            {
+                return change;
+            }
+        }
+        changes.push_back({ dancerNode, "", "", 0 });
+        return changes.back();
+    };
+
+    // Arcs from a dancer to a class put the dancer in it, arcs from a class back to a dancer take the dancer out
+    for (size_t i = 0; i + 1 < nodes.size(); i++)
+    {
+        int u = nodes[i];
+        int v = nodes[i + 1];
+        if (GetNodeType(args, u) == Dancer && GetNodeType(args, v) == Class)
+        {
+            DancerChange& change = findChange(u);
+            change.joins += (change.joins.empty() ? "" : " + ") + GetNodeName(args, v);
+            change.costChange += GetCost(args, u, v);
+        }
+        else if (GetNodeType(args, u) == Class && GetNodeType(args, v) == Dancer)
+        {
+            DancerChange& change = findChange(v);
+            change.leaves += (change.leaves.empty() ? "" : " + ") + GetNodeName(args, u);
+            change.costChange -= GetCost(args, v, u);
+        }
+    }
+
+    for (const DancerChange& change : changes)
+    {
+        const Studancer& dancer = GetDancerFromNode(args, change.dancerNode);
+        Print("    %i (%s): %s -> %s, choice cost %+lli\n", dancer.relationNumber, DancerPriorityGroupToString(dancer.priorityGroup).c_str(),
+            change.leaves.empty() ? "not placed" : change.leaves.c_str(), change.joins.empty() ? "not placed" : change.joins.c_str(),
+            (long long)change.costChange);
+    }
+}
+
+PlacementExplanation ExplainPlacement(const MinCostMaxFlowArgs& args, int dancerIndex)
+{
+    const Studancer& dancer = (*args.dancers)[dancerIndex];
+    const std::vector<DanceClass>& classes = *args.classes;
+    const int dancerNode = args.dancerOffset + dancerIndex;
+
+    PlacementExplanation explanation = {};
+    explanation.dancer = dancerIndex;
+    explanation.unitsNotPlaced = GetCapacity(args, args.sourceNode, dancerNode) - GetFlow(args, args.sourceNode, dancerNode);
+
+    auto getRank = [&](int classNode) {
+        const std::string& className = classes[classNode - args.classOffset].name;
+        return (int)(std::find(dancer.chosenClasses.begin(), dancer.chosenClasses.end(), className) - dancer.chosenClasses.begin());
+    };
+
+    // Only the choices ranked above the worst class the dancer got are explained, all of them when a unit is not placed
+    int worstRank = explanation.unitsNotPlaced > 0 ? INT_MAX : -1;
+    for (int neighbour : args.adjecencyList[dancerNode])
+    {
+        if (GetNodeType(args, neighbour) == Class && GetFlow(args, dancerNode, neighbour) > 0)
+        {
+            explanation.placedClasses.push_back(neighbour - args.classOffset);
+            worstRank = std::max(worstRank, getRank(neighbour));
+        }
+    }
+
+    // A single search gives the cheapest way back to the dancer from every class, so every choice is priced by it
+    std::vector<int64_t> distance(args.numNodes);
+    std::vector<int> next(args.numNodes);
+    SearchReducedCostsTo(args, dancerNode, distance.data(), next.data());
+
+    for (int neighbour : args.adjecencyList[dancerNode])
+    {
+        if (GetNodeType(args, neighbour) != Class || !CanFlow(args, dancerNode, neighbour) || getRank(neighbour) >= worstRank)
+        {
+            continue;
+        }
+
+        ChoiceExplanation choice = {};
+        choice.classIndex = neighbour - args.classOffset;
+        choice.choiceNumber = getRank(neighbour);
+        choice.isFull = true;
+        for (int seatNode : args.adjecencyList[neighbour])
+        {
+            if (GetNodeType(args, seatNode) == ClassCost && CanFlow(args, neighbour, seatNode))
+            {
+                choice.isFull = false;
+            }
+        }
+
+        // The dancer takes the class and the cheapest way from the class back to the dancer makes room for it
+        choice.isPossible = distance[neighbour] != INF64;
+        if (choice.isPossible)
+        {
+            int64_t pathCost = distance[neighbour] - args.potential[neighbour] + args.potential[dancerNode];
+            choice.costDifference = GetCost(args, dancerNode, neighbour) + pathCost;
+
+            choice.cycle.push_back(dancerNode);
+            for (int node = neighbour; node != dancerNode; node = next[node])
+            {
+                choice.cycle.push_back(node);
+            }
+            choice.cycle.push_back(dancerNode);
+        }
+        explanation.choices.push_back(choice);
+    }
+
+    std::sort(explanation.choices.begin(), explanation.choices.end(), [](const ChoiceExplanation& a, const ChoiceExplanation& b) {
+        return a.choiceNumber < b.choiceNumber;
+    });
+
+    return explanation;
+}
+
+void PrintPlacementExplanation(const MinCostMaxFlowArgs& args, const PlacementExplanation& explanation)
+{
+    const Studancer& dancer = (*args.dancers)[explanation.dancer];
+    const std::vector<DanceClass>& classes = *args.classes;
+
+    auto describeChoice = [&](int classIndex) {
+        const std::string& className = classes[classIndex].name;
+        int choiceNumber = (int)(std::find(dancer.chosenClasses.begin(), dancer.chosenClasses.end(), className) - dancer.chosenClasses.begin());
+        return choiceNumber < 3 ? ChoiceNumberToString(choiceNumber) + " choice " + className : className;
+    };
+
+    std::string placedIn;
+    for (int classIndex : explanation.placedClasses)
+    {
+        placedIn += (placedIn.empty() ? "" : " and ") + describeChoice(classIndex);
+    }
+    Print("%i (%s) is placed in %s", dancer.relationNumber, DancerPriorityGroupToString(dancer.priorityGroup).c_str(),
+        placedIn.empty() ? "no class" : placedIn.c_str());
+    if (explanation.unitsNotPlaced > 0 && !explanation.placedClasses.empty())
+    {
+        Print(" and has no second class");
+    }
+    Print("\n");
+
+    if (explanation.choices.empty())
+    {
+        Print("No choice ranked above it is left open\n\n");
+        return;
+    }
+
+    for (const ChoiceExplanation& choice : explanation.choices)
+    {
+        std::string description = describeChoice(choice.classIndex) + (choice.isFull ? " is full" : " has room");
+        if (!choice.isPossible)
+        {
+            Print("%s, but no moves make room for it without leaving out a dancer\n", description.c_str());
+            continue;
+        }
+
+        if (choice.costDifference == 0)
+        {
+            Print("%s, taking it costs the same, the dancer order decided the tie against it with these moves:\n", description.c_str());
+        }
+        else
+        {
+            Print("%s, taking it raises the cost by %lli with these moves:\n", description.c_str(), (long long)choice.costDifference);
+        }
+        PrintFlowChange(args, choice.cycle);
+    }
+    Print("\n");
+}
+
+Assignment DecodeMinCostMaxFlow(MinCostMaxFlowArgs& args)
+{
+    Assignment assignment;
+
+    const std::vector<Studancer>& dancers = *args.dancers;
+    const std::vector<DanceClass>& classes = *args.classes;
+
+    // Use the offsets of the network, AddDancer() can leave free slots after the last dancer
+    int dancerOffset = args.dancerOffset;
+    int classOffset = args.classOffset;
+
+    for (int i = 0; i < classes.size(); i++)
+    {
+        DanceClass danceClass = classes[i];
+        std::vector<Studancer> assignedDancers;
+
+        int classNodeIndex = i + classOffset;
+
+        for (int neighbour : args.adjecencyList[classNodeIndex])
+        {
+            // If there is flow from a dancer to this class, this class was chosen
+            if (neighbour >= dancerOffset && neighbour < classOffset && !CanFlow(args, neighbour, classNodeIndex))
+            {
+                int dancerIndex = neighbour - dancerOffset;
+                assignedDancers.push_back(dancers[dancerIndex]);
+            }
+        }
+
+        assignment.push_back(std::make_pair(danceClass, assignedDancers));
+    }
+
+    return assignment;
+}
+
+void DumpDecisionLog(const MinCostMaxFlowArgs& args)
+{
+    auto outputPath = GetOutputFolder() / "DecisionLog_MCMF.txt";
+    std::ofstream outputFile(outputPath);
+
+    int decisionNumber = 1;
+    for (auto& decision : args.decisions)
+    {
+        outputFile << "Decision ";
+        outputFile << decisionNumber;
+        outputFile << " (flow change: ";
+        outputFile << decision.flowChange;
+        outputFile << ", cost change: ";
+        outputFile << decision.costChange;
+        outputFile << ")\n";
+
+        // reverse the path
+        std::vector<int> path;
+        for (int i = (int)decision.changedNodes.size() - 1; i > 0; i--)
+        {
+            path.push_back(decision.changedNodes[i]);
+        }
+
+        if (decision.type == AssignDancer)
+        {
+            const Studancer& dancer = GetDancerFromNode(args, path[1]);
+            std::string className = GetNodeName(args, path[2]);
+
+            int choiceIndex = FindItemInVector(dancer.chosenClasses, className);
+            std::string choice = ChoiceNumberToString(choiceIndex);
+
+            outputFile << "Assigned dancer ";
+            outputFile << dancer.relationNumber;
+            outputFile << " with priority group ";
+            outputFile << DancerPriorityGroupToString(dancer.priorityGroup);
+            outputFile << " to their " << choice << " choice: ";
+            outputFile << className;
+
+            // if the path is longer than 4 someone else was moved
+            if (path.size() > 4)
+            {
+                int offset = 3;
+
+                outputFile << " by updating the assignment:\n";
+
+                for (int index = 2; index < path.size() - 2; index++)
+                {
+                    int currentNode = path[index];
+                    int nextNode = path[index + 1];
+
+                    NodeType currentNodeType = GetNodeType(args, currentNode);
+                    NodeType nextNodeType = GetNodeType(args, nextNode);
+
+                    if (currentNodeType == Dancer && nextNodeType == Class)
+                    {
+                        const Studancer& updatedDancer = GetDancerFromNode(args, currentNode);
+
+                        std::string updatedClass = GetNodeName(args, nextNode);
+
+                        int classIndex = FindItemInVector(updatedDancer.chosenClasses, updatedClass);
+                        std::string choice = ChoiceNumberToString(classIndex);
+
+                        outputFile << "Assigned dancer ";
+                        outputFile << updatedDancer.relationNumber;
+                        outputFile << " with priority group ";
+                        outputFile << DancerPriorityGroupToString(updatedDancer.priorityGroup);
+                        outputFile << " to their " << choice << " choice: ";
+                        outputFile << updatedClass;
+                        outputFile << "\n";
+                    }
+                    else if (currentNodeType == Class && nextNodeType == Dancer)
+                    {
+                        const Studancer& updatedDancer = GetDancerFromNode(args, nextNode);
+                        std::string updatedClass = GetNodeName(args, currentNode);
+
+                        int classIndex = FindItemInVector(updatedDancer.chosenClasses, updatedClass);
+                        std::string choice = ChoiceNumberToString(classIndex);
+
+                        outputFile << "Unassigned dancer ";
+                        outputFile << updatedDancer.relationNumber;
+                        outputFile << " with priority group ";
+                        outputFile << DancerPriorityGroupToString(updatedDancer.priorityGroup);
+                        outputFile << " from their " << choice << " choice: ";
+                        outputFile << updatedClass;
+                        outputFile << "\n";
+                    }
+                    else if (currentNodeType == Dancer && nextNodeType == Source)
+                    {
+                        const Studancer& updatedDancer = GetDancerFromNode(args, currentNode);
+                        outputFile << "Dancer ";
+                        outputFile << updatedDancer.relationNumber;
+                        outputFile << " with priority group ";
+                        outputFile << DancerPriorityGroupToString(updatedDancer.priorityGroup);
+                        outputFile << " was completely unassigned";
+                        outputFile << "\n";
+                    }
+                }
+
+                outputFile << "\n";
+            }
+            else
+            {
+                outputFile << "\n\n";
+            }
+        }
+        else if (decision.type == UnassignDancer)
+        {
+            // The path runs from the sink back to the withdrawn dancer
+            const Studancer& dancer = GetDancerFromNode(args, path[path.size() - 1]);
+            std::string className = GetNodeName(args, path[path.size() - 2]);
+
+            int choiceIndex = FindItemInVector(dancer.chosenClasses, className);
+            std::string choice = ChoiceNumberToString(choiceIndex);
+
+            outputFile << "Withdrew dancer ";
+            outputFile << dancer.relationNumber;
+            outputFile << " with priority group ";
+            outputFile << DancerPriorityGroupToString(dancer.priorityGroup);
+            outputFile << " from their " << choice << " choice: ";
+            outputFile << className;
+
+            // if the path is longer than 4 someone else was moved into the seat
+            if (path.size() > 4)
+            {
+                outputFile << " by updating the assignment:\n";
+
+                for (int index = 1; index < path.size() - 2; index++)
+                {
+                    int currentNode = path[index];
+                    int nextNode = path[index + 1];
+
+                    NodeType currentNodeType = GetNodeType(args, currentNode);
+                    NodeType nextNodeType = GetNodeType(args, nextNode);
+
+                    if (currentNodeType == Dancer && nextNodeType == Class)
+                    {
+                        const Studancer& updatedDancer = GetDancerFromNode(args, currentNode);
+                        std::string updatedClass = GetNodeName(args, nextNode);
+
+                        int classIndex = FindItemInVector(updatedDancer.chosenClasses, updatedClass);
+
+                        outputFile << "Assigned dancer ";
+                        outputFile << updatedDancer.relationNumber;
+                        outputFile << " with priority group ";
+                        outputFile << DancerPriorityGroupToString(updatedDancer.priorityGroup);
+                        outputFile << " to their " << ChoiceNumberToString(classIndex) << " choice: ";
+                        outputFile << updatedClass;
+                        outputFile << "\n";
+                    }
+                    else if (currentNodeType == Class && nextNodeType == Dancer)
+                    {
+                        const Studancer& updatedDancer = GetDancerFromNode(args, nextNode);
+                        std::string updatedClass = GetNodeName(args, currentNode);
+
+                        int classIndex = FindItemInVector(updatedDancer.chosenClasses, updatedClass);
+
+                        outputFile << "Unassigned dancer ";
+                        outputFile << updatedDancer.relationNumber;
+                        outputFile << " with priority group ";
+                        outputFile << DancerPriorityGroupToString(updatedDancer.priorityGroup);
+                        outputFile << " from their " << ChoiceNumberToString(classIndex) << " choice: ";
+                        outputFile << updatedClass;
                         outputFile << "\n";
                     }
                 }
@@ -1,14 +1,20 @@
 #pragma once
 #include <vector>
+#include <memory>
+#include <chrono>
 #include "Studancer.h"
 #include "DanceClass.h"
 #include "Assignment.h"
 #include "CliArgs.h"
+#include "SolverArena.h"
+#include "CostModel.h"
+#include "Snapshot.h"
 
 enum DecisionType
 {
     AssignDancer,
-    CycleCancel
+    CycleCancel,
+    UnassignDancer
 };
 
 struct Decision
@@ -29,21 +35,21 @@ struct MinCostMaxFlowArgs
     int classCostOffset;
 
     int numNodes;                   // number of nodes
-    std::vector<int>* adjecencyList; // Array of vectors containing the adjecency list, size = numNodes
+    std::vector<std::vector<int>> adjecencyList; // adjecency list per node, size = numNodes
     int64_t* cost;                       // Array of costs, size = numNodes * numNodes
     int* capacity;                   // Array of capacities, size = numNodes * numNodes
 
     // Shortest path calculation data
     int64_t* distance;                   // distances for each node, size = numNodes
+    int64_t* potential;                  // node potentials (duals) valid for the current residual graph, size = numNodes
     int* parent;                     // for reconstructing the path, size = numNodes
 
     // mcmf
     int* flow; // final flow, size = numNodes * numNodes
     int expectedMaxFlow;
 
-    // total allocated space
-    int* buffer;
-    int bufferDwords;
+    // Owns the memory of the arrays above, callers can share it to reuse the memory for the next solve
+    std::shared_ptr<SolverArena> arena;
 
     // Data of dancers
     const std::vector<Studancer>* dancers;
@@ -53,7 +59,222 @@ struct MinCostMaxFlowArgs
 
 std::pair<int64_t, int> MinCostMaxFlow(MinCostMaxFlowArgs& args, const CliArguments& cliArgs);
 
-MinCostMaxFlowArgs EncodeMinCostMaxFlow(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const CliArguments& cliArgs);
+// Per component of the class graph the indices of its classes, two classes are in the same component when a dancer chose both
+// Special classes with room for every dancer that chose them do not couple classes and are in no component
+std::vector<std::vector<int>> FindClassComponents(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const CliArguments& cliArgs);
+
+// Solves every component of the class graph as its own network on the task pool and merges the flows into args, which has no flow yet
+// The components do not share any capacity, so the cost is the same as that of MinCostMaxFlow(), equal cost ties may be broken differently
+std::pair<int64_t, int> MinCostMaxFlowByComponents(MinCostMaxFlowArgs& args, const CliArguments& cliArgs);
+
+// Fixes the dancers PresolveAssignment() can place without the network, solves what is left and merges both into args, which has no flow yet
+// The cost is the same as that of MinCostMaxFlow(), equal cost ties may be broken differently
+std::pair<int64_t, int> MinCostMaxFlowWithPresolve(MinCostMaxFlowArgs& args, const CliArguments& cliArgs);
+
+// KBBoard, HBBoard and Damn are tier 0, ExistingMember tier 1 and every other group tier 2
+const int PriorityTierCount = 3;
+int GetPriorityTier(DancerPriorityGroup group);
+
+// Solves the priority tiers in order on networks of their own dancers, every tier only gets the seats the tiers before it left
+// The seats are not kept locked afterwards, an earlier tier can have to give up an equally cheap seat or one a later tier needs,
+// the cost is the same as that of MinCostMaxFlow() only because the merged flow is repaired on the whole network, see tests/SolverModesTest.cpp
+std::pair<int64_t, int> MinCostMaxFlowByTiers(MinCostMaxFlowArgs& args, const CliArguments& cliArgs);
+
+// Lower bound on the cost of every flow of flowValue from any potentials, equal to the cost of the flow when the potentials prove it optimal
+int64_t ComputeDualLowerBound(const MinCostMaxFlowArgs& args, const int64_t* potential, int flowValue);
+
+struct AnytimeResult
+{
+    int64_t cost;
+    int64_t lowerBound;     // no assignment that places as many dancers costs less
+    bool isOptimal;
+    int pathsAugmented;     // units the seed could not place
+    int64_t completedCost;  // cost after placing those units, before cancelling any cycle
+    int cyclesCancelled;
+};
+
+// Improves a feasible flow, like one loaded with LoadPlacementFlow(), until the deadline or until it is optimal
+// First places the dancers the flow left out, then cancels negative cycles, also through the source
+// The flow is a valid assignment after every step, the lower bound comes from the potentials of the last search
+AnytimeResult ImproveFlowWithinBudget(MinCostMaxFlowArgs& args, std::chrono::steady_clock::time_point deadline);
+
+// Computes potentials for the current residual graph with a single Bellman-Ford search
+// Returns false when the residual graph contains a negative cycle
+bool ComputePotentials(MinCostMaxFlowArgs& args);
+
+// Cancels minimum mean cycles (Karp) in the residual graph until no cycle with a negative cost is left
+// Every cancelled cycle is logged as a CycleCancel decision, returns the change in cost of the flow
+// With intoSource cycles may also send flow back into the source, which swaps a placed dancer for one that is not placed
+int64_t CancelNegativeCycles(MinCostMaxFlowArgs& args, bool intoSource = false);
+
+// Successive shortest paths with Dijkstra on reduced costs, starting from the current flow and potentials
+// The potentials must be valid for the residual graph (no negative reduced cost on a residual edge)
+// Equal cost paths are broken towards the lowest node index, so the dancer order decides ties
+std::pair<int64_t, int> SuccessiveShortestPaths(MinCostMaxFlowArgs& args);
+
+// The path search of MinCostMaxFlow() without its decision log, progress and checks, so the same dancer order gives the same placements
+// Every path is a Bellman-Ford search from the source on the plain costs, the network must not contain a negative cycle
+std::pair<int64_t, int> BellmanFordShortestPaths(MinCostMaxFlowArgs& args);
+
+// Copies the network of base into target with dancer node i of base moved to the node of dancer dancerPosition[i]
+// Flow, costs, capacities and potentials are moved along, target must be allocated with the same number of nodes
+void PermuteDancerNodes(const MinCostMaxFlowArgs& base, const std::vector<int>& dancerPosition, MinCostMaxFlowArgs& target);
+
+// Lays out the arrays of the network in the arena, a new arena is created when none is given
+// The arena is reset first, so it must not be used by another network anymore
+MinCostMaxFlowArgs AllocateMinCostMaxFlow(int numNodes, std::shared_ptr<SolverArena> arena = nullptr);
+
+// Puts the placements on a network without flow, in the cheapest seats of their classes
+// Placements that do not fit anymore, for example in a class that became smaller, are dropped
+void LoadPlacementFlow(MinCostMaxFlowArgs& args, std::vector<AssignmentPlacement> placements);
+
+MinCostMaxFlowArgs EncodeMinCostMaxFlow(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const CliArguments& cliArgs,
+                                        std::shared_ptr<SolverArena> arena = nullptr);
+
+// Computes potentials that are valid for every arc of the residual graph, also between nodes the source cannot reach
+// Needed once before changing a solved network with AddDancer() or WithdrawDancer(), returns false when the residual graph contains a negative cycle
+// With intoSource the arcs back into the source count too, like for CancelNegativeCycles()
+bool ComputeAllPotentials(MinCostMaxFlowArgs& args, bool intoSource = false);
+
+// Adds dancers.back() to a solved network and assigns it with a single search per unit of flow from the current potentials
+// dancers is the vector the network was encoded from with the new dancer appended, it takes a free dancer slot
+// When there is none the network is moved to a new arena with a quarter more slots, so most adds are only the searches
+void AddDancer(MinCostMaxFlowArgs& args, const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const CliArguments& cliArgs);
+
+// Takes the flow of a dancer out of a solved network, with a single search per unit that also gives the freed seat to whoever gains most
+// The dancer stays in the network without any flow
+void WithdrawDancer(MinCostMaxFlowArgs& args, int dancerIndex);
+
+// Sets the room a class has within its bounds (the whole capacity for the special classes) on a solved network
+// Dancers over a lower capacity are moved elsewhere and dancers that gain from a higher one are moved in, one search per unit
+// The potentials must be valid for every arc, like after ComputeAllPotentials(), and stay valid
+void ChangeClassCapacity(MinCostMaxFlowArgs& args, int classIndex, int capacity);
+
+// Like ChangeClassCapacity(), but returns false instead of stopping when the dancers over a lower capacity have nowhere else to go
+// The capacity is then left at the lowest value the flow could be moved to
+bool TryChangeClassCapacity(MinCostMaxFlowArgs& args, int classIndex, int capacity);
+
+// Sets the additional space of a regular class on a solved network, like ChangeClassCapacity()
+void ChangeClassAdditionalSpace(MinCostMaxFlowArgs& args, int classIndex, int additionalSpace);
+
+// Like ChangeClassAdditionalSpace(), but returns false instead of stopping, like TryChangeClassCapacity()
+bool TryChangeClassAdditionalSpace(MinCostMaxFlowArgs& args, int classIndex, int additionalSpace);
+
+// Sets the capacities of the arcs of the regular classes to the sizes in classes, only for a network without flow
+void SetClassCapacities(MinCostMaxFlowArgs& args, const std::vector<DanceClass>& classes);
+
+// Sets the costs of the arcs from the dancers to their chosen classes and from the classes to their cost nodes to the weights of costModel
+// Meant for a network without flow, the flow of a solved network is not optimal for the new costs anymore
+void SetArcCosts(MinCostMaxFlowArgs& args, const CostModel& costModel);
+
+// A network without flow on the topology and capacities of base, with its own costs, flow and search arrays in the arena
+// The capacities stay shared with base, so base must outlive it and its capacities must not change
+MinCostMaxFlowArgs ShareMinCostMaxFlowTopology(const MinCostMaxFlowArgs& base, std::shared_ptr<SolverArena> arena);
+
+// Total cost of the current flow
+int64_t GetFlowCost(const MinCostMaxFlowArgs& args);
+
+// The flow and potentials of a solved network, small enough to keep many of them around
+struct SolvedFlow
+{
+    struct Arc
+    {
+        int from;
+        int to;
+        int flow;
+    };
+
+    std::vector<Arc> arcs;          // every arc with flow
+    std::vector<int64_t> potential; // size = numNodes
+};
+
+SolvedFlow SaveSolvedFlow(const MinCostMaxFlowArgs& args);
+
+// Puts a saved flow back on a network without flow that has the same topology and capacities
+void RestoreSolvedFlow(MinCostMaxFlowArgs& args, const SolvedFlow& solved);
+
+struct WaitlistEntry
+{
+    int dancer;                 // index in the dancers vector
+    int64_t costReduction;      // drop in the cost of the assignment when the dancer takes the extra seat, negative when the cost rises
+};
+
+// Per class the dancers that chose it but are not placed in it, ordered on how much the cost drops when the class gets one
+// more seat and they take it, with a single search per class. The special classes get no list
+// The potentials must be valid for every arc, like after ComputeAllPotentials()
+std::vector<std::vector<WaitlistEntry>> ComputeWaitlists(const MinCostMaxFlowArgs& args);
+
+struct SeatChange
+{
+    bool isPossible;            // false when the class cannot lose the seat, or its dancers have nowhere else to go
+    int64_t costChange;         // change in the cost of the assignment
+    int dancersMoved;           // dancers that change class
+};
+
+struct ClassSensitivity
+{
+    SeatChange extraSeat;       // maxSize + 1
+    SeatChange removedSeat;     // maxSize - 1
+};
+
+// Per class what one seat more or less does to the optimal assignment, with a single search from the potentials per change
+// The special classes are left empty. The potentials must be valid for every arc, like after ComputeAllPotentials()
+std::vector<ClassSensitivity> ComputeClassSensitivity(const MinCostMaxFlowArgs& args);
+
+// Applies every change of the report to a copy of the network with ChangeClassCapacity() and reports where the cost changed differently
+// Returns the number of changes that did not match
+int VerifyClassSensitivity(const MinCostMaxFlowArgs& args, const std::vector<ClassSensitivity>& sensitivity, const CliArguments& cliArgs);
+
+// Source, Sink, the relation number of a dancer, the name of a class or the name of a class with its seat cost
+std::string GetNodeName(const MinCostMaxFlowArgs& args, int node);
+
+// Checks that the flow on every arc is within its capacity and that every node but the source and sink passes on all of its flow
+// Every problem is printed, returns the number of problems
+int CheckFlow(const MinCostMaxFlowArgs& args);
+
+struct FlowCertificate
+{
+    bool isMaximal;             // no dancer can be placed without taking the seat of another
+    bool isOptimal;             // maximal and no cycle in the residual graph lowers the cost
+    bool usedPotentials;        // proven with the given potentials instead of a search
+    std::vector<int> path;      // augmenting path from the source to the sink when the flow is not maximal
+    std::vector<int> cycle;     // cycle that lowers the cost, with the first node repeated at the end
+    int64_t cycleCost;          // change in cost per unit sent around the cycle
+};
+
+// Proves whether the flow is a min cost max flow, checking the potentials in a single pass over the residual arcs when they are given
+// Otherwise, or when they do not prove it, a single Bellman-Ford search finds a cycle that lowers the cost or valid potentials
+// The potentials that proved it are left in args
+FlowCertificate CertifyFlow(MinCostMaxFlowArgs& args, const std::vector<int64_t>* potential = nullptr);
+
+// Prints per dancer on a path or cycle which class it leaves and which it joins
+void PrintFlowChange(const MinCostMaxFlowArgs& args, const std::vector<int>& nodes);
+
+struct ChoiceExplanation
+{
+    int classIndex;
+    int choiceNumber;           // index in the chosen classes of the dancer, 0 is the first choice
+    bool isFull;                // no seat of the class is free
+    bool isPossible;            // false when no moves make room for the dancer without leaving out another
+    int64_t costDifference;     // rise in the cost of the assignment when the dancer takes the class, 0 when it lost a tie
+    std::vector<int> cycle;     // the moves that make room, from the dancer node back to it
+};
+
+struct PlacementExplanation
+{
+    int dancer;                             // index in the dancers vector
+    int unitsNotPlaced;                     // classes the dancer may take but did not get, not even unenrolled
+    std::vector<int> placedClasses;
+    std::vector<ChoiceExplanation> choices; // every open choice ranked above a class it got, all of them when a unit is not placed
+};
+
+// Explains why a dancer did not get its higher choices from the solved network, without the decision log
+// Per choice the cheapest moves that would give it the dancer, which shows who blocks it and what it would cost
+// A single search from the dancer over the reversed residual graph prices every choice at once
+// The potentials must be valid for every arc, also the arcs back into the source, like after ComputeAllPotentials(args, true)
+PlacementExplanation ExplainPlacement(const MinCostMaxFlowArgs& args, int dancerIndex);
+
+void PrintPlacementExplanation(const MinCostMaxFlowArgs& args, const PlacementExplanation& explanation);
 
 Assignment DecodeMinCostMaxFlow(MinCostMaxFlowArgs& args);
 
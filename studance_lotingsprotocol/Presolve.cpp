@@ -0,0 +1,145 @@
+#include "Presolve.h"
+#include "CostModel.h"
+#include "Utils.h"
+#include <map>
+
+PresolveResult PresolveAssignment(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes)
+{
+    const CostModel& costModel = GetCostModel();
+
+    PresolveResult presolve = {};
+    presolve.classes = classes;
+
+    std::map<std::string, int> classMap;
+    for (int i = 0; i < classes.size(); i++)
+    {
+        classMap.emplace(std::make_pair(classes[i].name, i));
+    }
+
+    struct ChoiceArc
+    {
+        int classIndex;
+        int64_t cost;
+        bool isAlive;
+    };
+
+    // The arcs and units every dancer still has, and how many dancers can still come to every class
+    std::vector<std::vector<ChoiceArc>> arcs(dancers.size());
+    std::vector<int> units(dancers.size());
+    std::vector<int> demand(classes.size(), 0);
+    std::vector<std::vector<int>> fixedClasses(dancers.size());
+    for (int i = 0; i < dancers.size(); i++)
+    {
+        const Studancer& dancer = dancers[i];
+        units[i] = dancer.priorityGroup == KBBoard || dancer.priorityGroup == Damn ? 2 : 1;
+
+        int choiceNumber = 0;
+        for (int j = 0; j < dancer.chosenClasses.size(); j++)
+        {
+            const std::string& chosenClass = dancer.chosenClasses[j];
+            if (chosenClass == "")
+            {
+                continue;
+            }
+            int classIndex = classMap[chosenClass];
+            arcs[i].push_back({ classIndex, GetChoiceArcCost(costModel, dancer, j, choiceNumber), true });
+            demand[classIndex]++;
+            choiceNumber++;
+        }
+    }
+
+    // A dancer moved into an uncontended class pays a seat below its minimum size and frees a seat that is at least as expensive
+    bool isCheapestSeat = costModel.underMinBoundsCost <= costModel.withinClassBoundsCost && costModel.underMinBoundsCost <= costModel.additionalSpaceCost;
+
+    bool isChanged = isCheapestSeat;
+    while (isChanged)
+    {
+        isChanged = false;
+        for (int i = 0; i < dancers.size(); i++)
+        {
+            if (units[i] == 0)
+            {
+                continue;
+            }
+
+            int64_t cheapestCost = INT64_MAX;
+            for (const ChoiceArc& arc : arcs[i])
+            {
+                if (arc.isAlive)
+                {
+                    cheapestCost = std::min(cheapestCost, arc.cost);
+                }
+            }
+
+            for (ChoiceArc& arc : arcs[i])
+            {
+                const DanceClass& danceClass = presolve.classes[arc.classIndex];
+                bool isSpecialClass = danceClass.name == "niet-dansend lid" || danceClass.name == "unenrolled";
+                if (!arc.isAlive || arc.cost != cheapestCost || isSpecialClass || demand[arc.classIndex] > danceClass.minSize)
+                {
+                    continue;
+                }
+
+                presolve.fixedPlacements.push_back({ i, arc.classIndex });
+                fixedClasses[i].push_back(arc.classIndex);
+                presolve.classes[arc.classIndex].minSize--;
+                presolve.classes[arc.classIndex].maxSize--;
+                demand[arc.classIndex]--;
+                arc.isAlive = false;
+                units[i]--;
+                isChanged = true;
+                break;
+            }
+
+            // Without units left the other choices of the dancer do not compete for their classes anymore
+            if (units[i] == 0)
+            {
+                for (ChoiceArc& arc : arcs[i])
+                {
+                    if (arc.isAlive)
+                    {
+                        demand[arc.classIndex]--;
+                        arc.isAlive = false;
+                    }
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < dancers.size(); i++)
+    {
+        for (const ChoiceArc& arc : arcs[i])
+        {
+            presolve.removedArcs += !arc.isAlive;
+        }
+
+        if (units[i] > 0)
+        {
+            presolve.dancerIndices.push_back(i);
+            presolve.fixedClasses.push_back(fixedClasses[i]);
+            presolve.dancers.push_back(dancers[i]);
+        }
+    }
+
+    return presolve;
+}
+
+void PrintPresolve(const PresolveResult& presolve, const std::vector<DanceClass>& classes, int numDancers)
+{
+    std::vector<int> fixedPerClass(classes.size(), 0);
+    for (const FixedPlacement& placement : presolve.fixedPlacements)
+    {
+        fixedPerClass[placement.classIndex]++;
+    }
+
+    Print("Presolve fixed %i placements, %i of the %i dancers are left and %i arcs to classes were removed\n",
+        (int)presolve.fixedPlacements.size(), (int)presolve.dancers.size(), numDancers, presolve.removedArcs);
+    for (int i = 0; i < classes.size(); i++)
+    {
+        if (fixedPerClass[i] > 0)
+        {
+            Print("    %s: %i fixed, %i of the minimum size left\n", classes[i].name.c_str(), fixedPerClass[i], presolve.classes[i].minSize);
+        }
+    }
+    Print("\n");
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <vector>
+#include "Studancer.h"
+#include "DanceClass.h"
+
+struct FixedPlacement
+{
+    int dancer;     // index in the dancers vector
+    int classIndex;
+};
+
+// What is left of the assignment after the presolve, classes keep their order, dancers are the ones with a class left to get
+struct PresolveResult
+{
+    std::vector<FixedPlacement> fixedPlacements;
+    std::vector<int> dancerIndices;                 // per dancer of the reduced problem the index in the dancers vector
+    std::vector<std::vector<int>> fixedClasses;     // per dancer of the reduced problem the classes it already got, only board members
+    std::vector<Studancer> dancers;
+    std::vector<DanceClass> classes;                // sizes without the fixed seats
+    int removedArcs;                                // arcs from dancers to classes that are not needed anymore
+};
+
+// Fixes a dancer in a class when it is the cheapest class it chose and no more dancers chose the class than fit below its minimum size
+// Moving such a dancer anywhere else cannot make the cost lower, so the dancer is placed there before the network is built
+// Fixed dancers free up the other classes they chose, which can make those uncontended too, so this is repeated until nothing changes
+// Only when a seat below the minimum size is the cheapest seat of the cost model, otherwise nothing is fixed
+PresolveResult PresolveAssignment(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes);
+
+void PrintPresolve(const PresolveResult& presolve, const std::vector<DanceClass>& classes, int numDancers);
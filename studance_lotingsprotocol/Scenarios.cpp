@@ -0,0 +1,659 @@
+#include "Scenarios.h"
+#include "MinCostMaxFlow.h"
+#include "TaskPool.h"
+#include "Utils.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+
+inline bool IsSpecialClass(const DanceClass& danceClass)
+{
+    return danceClass.name == "niet-dansend lid" || danceClass.name == "unenrolled";
+}
+
+// Parses a size of the scenarios file, an empty field keeps the current size
+void ParseScenarioSize(std::string field, int& size, const std::string& scenarioName)
+{
+    trim(field);
+    if (field.empty())
+    {
+        return;
+    }
+
+    if (!std::all_of(field.begin(), field.end(), ::isdigit))
+    {
+        printf("ERROR: scenario %s has size %s, which is not a number\n", scenarioName.c_str(), field.c_str());
+        exit(-1);
+    }
+    size = stoi(field);
+}
+
+// Splits a line of the scenarios file on commas, an empty field at the end is kept
+std::vector<std::string> SplitScenarioLine(const std::string& line)
+{
+    std::vector<std::string> fields;
+    std::stringstream stream(line);
+    std::string field;
+    while (std::getline(stream, field, ','))
+    {
+        rtrim(field);
+        fields.push_back(field);
+    }
+    if (!line.empty() && line.back() == ',')
+    {
+        fields.push_back("");
+    }
+    return fields;
+}
+
+std::vector<CapacityScenario> LoadScenarios(const std::string& fileName, const std::vector<DanceClass>& classes)
+{
+    fs::path scenariosFilePath = fileName;
+    if (!fs::exists(scenariosFilePath))
+    {
+        scenariosFilePath = GetInputFolder() / fileName;
+    }
+    if (!fs::exists(scenariosFilePath))
+    {
+        printf("ERROR: could not find scenarios file %s\n", fileName.c_str());
+        exit(-1);
+    }
+
+    std::map<std::string, int> headerMap;
+    headerMap.insert({
+        {"scenario", -1},
+        {"naam", -1},
+        {"maximale ruimte", -1},
+        {"extra speel ruimte", -1},
+    });
+
+    std::ifstream scenariosFile(scenariosFilePath);
+
+    // Index the header
+    std::string line;
+    std::getline(scenariosFile, line);
+    std::vector<std::string> header = SplitScenarioLine(line);
+    const int numIndices = (int)header.size();
+    for (int i = 0; i < numIndices; i++)
+    {
+        std::string currentHeader = header[i];
+        tolower(currentHeader);
+        currentHeader.erase(currentHeader.find_last_not_of(" \n\r\t:?") + 1);
+
+        if (headerMap.count(currentHeader))
+        {
+            headerMap[currentHeader] = i;
+        }
+    }
+
+    if (headerMap["scenario"] == -1 || headerMap["naam"] == -1)
+    {
+        printf("ERROR: the scenarios file needs at least the headers scenario and naam\n");
+        exit(-1);
+    }
+
+    std::vector<CapacityScenario> scenarios;
+    scenarios.push_back({ "danceclasses.csv", classes });
+
+    while (std::getline(scenariosFile, line))
+    {
+        if (line.find_first_not_of(" ,\r\n\t") == std::string::npos)
+        {
+            continue;
+        }
+
+        // Fields that are missing at the end of the line are empty
+        std::vector<std::string> indices = SplitScenarioLine(line);
+        indices.resize(std::max((int)indices.size(), numIndices));
+
+        std::string scenarioName = indices[headerMap["scenario"]];
+        trim(scenarioName);
+
+        auto scenario = std::find_if(scenarios.begin() + 1, scenarios.end(), [&](const CapacityScenario& s) { return s.name == scenarioName; });
+        if (scenario == scenarios.end())
+        {
+            scenarios.push_back({ scenarioName, classes });
+            scenario = scenarios.end() - 1;
+        }
+
+        std::string className = indices[headerMap["naam"]];
+        trim(className);
+        tolower(className);
+
+        auto danceClass = std::find_if(scenario->classes.begin(), scenario->classes.end(), [&](const DanceClass& c) { return c.name == className; });
+        if (danceClass == scenario->classes.end() || IsSpecialClass(*danceClass))
+        {
+            printf("ERROR: scenario %s changes class %s, which is not in danceclasses.csv\n", scenarioName.c_str(), className.c_str());
+            exit(-1);
+        }
+
+        if (headerMap["maximale ruimte"] != -1)
+        {
+            ParseScenarioSize(indices[headerMap["maximale ruimte"]], danceClass->maxSize, scenarioName);
+        }
+        if (headerMap["extra speel ruimte"] != -1)
+        {
+            ParseScenarioSize(indices[headerMap["extra speel ruimte"]], danceClass->additionalSpace, scenarioName);
+        }
+
+        if (danceClass->maxSize < danceClass->minSize)
+        {
+            printf("ERROR: scenario %s makes class %s smaller than its minimum of %i\n", scenarioName.c_str(), className.c_str(), danceClass->minSize);
+            exit(-1);
+        }
+    }
+
+    return scenarios;
+}
+
+// Number of seats two scenarios differ in
+int SeatDifference(const std::vector<DanceClass>& a, const std::vector<DanceClass>& b)
+{
+    int difference = 0;
+    for (int i = 0; i < a.size(); i++)
+    {
+        if (!IsSpecialClass(a[i]))
+        {
+            difference += std::abs(a[i].maxSize - b[i].maxSize) + std::abs(a[i].additionalSpace - b[i].additionalSpace);
+        }
+    }
+    return difference;
+}
+
+// Counts the placements of a solved network as one run
+void CountFlowOutcome(AssignmentStatistics& statistics, const MinCostMaxFlowArgs& args, const std::vector<Studancer>& dancers, const StatisticsInput& statisticsInput)
+{
+    const int numClasses = (int)statisticsInput.classNames.size();
+    ClearAssignmentStatistics(statistics, numClasses);
+
+    for (int dancerIndex = 0; dancerIndex < dancers.size(); dancerIndex++)
+    {
+        int dancerNode = args.dancerOffset + dancerIndex;
+        for (int neighbour : args.adjecencyList[dancerNode])
+        {
+            // Flow from the dancer to a class node means the dancer was assigned to it
+            bool isClass = neighbour >= args.classOffset && neighbour < args.classCostOffset;
+            if (isClass && args.flow[(size_t)dancerNode * args.numNodes + neighbour] > 0)
+            {
+                CountPlacement(statistics, statisticsInput, dancerIndex, neighbour - args.classOffset);
+            }
+        }
+    }
+
+    statistics.runs = 1;
+}
+
+std::vector<ScenarioResult> SolveScenarios(const std::vector<Studancer>& dancers, const StatisticsInput& statisticsInput, const std::vector<CapacityScenario>& scenarios, const CliArguments& cliArgs)
+{
+    const int numScenarios = (int)scenarios.size();
+    const std::vector<DanceClass>& classes = scenarios[0].classes;
+
+    // Every scenario is solved from scratch, an existing solution only belongs to the classes as loaded
+    CliArguments encodeArgs = cliArgs;
+    encodeArgs.isUpdate = false;
+    MinCostMaxFlowArgs base = EncodeMinCostMaxFlow(dancers, classes, encodeArgs);
+
+    // Scenarios close to the classes as loaded go first, so the ones further away find a close solved scenario to start from
+    std::vector<int> order(numScenarios);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin() + 1, order.end(), [&](int a, int b) {
+        return SeatDifference(scenarios[a].classes, classes) < SeatDifference(scenarios[b].classes, classes);
+    });
+
+    // Every changed seat costs at most one search, starting over costs one search per unit of flow
+    std::vector<ScenarioResult> results(numScenarios);
+    for (int position = 0; position < numScenarios; position++)
+    {
+        int scenario = order[position];
+        results[scenario].warmStartFrom = -1;
+
+        int closestDifference = base.expectedMaxFlow;
+        for (int earlier = 0; earlier < position; earlier++)
+        {
+            int difference = SeatDifference(scenarios[scenario].classes, scenarios[order[earlier]].classes);
+            if (difference < closestDifference)
+            {
+                closestDifference = difference;
+                results[scenario].warmStartFrom = order[earlier];
+            }
+        }
+    }
+
+    std::vector<int> identity(dancers.size());
+    std::iota(identity.begin(), identity.end(), 0);
+
+    // Solved scenarios are kept as their flow, a thread waits when the scenario it starts from is still being solved
+    std::vector<SolvedFlow> solved(numScenarios);
+    std::vector<char> isSolved(numScenarios, 0);
+    std::mutex solvedMutex;
+    std::condition_variable solvedCondition;
+
+    TaskPool& pool = GetTaskPool();
+    int numThreads = std::min(pool.GetNumThreads(), numScenarios);
+    std::vector<MinCostMaxFlowArgs> workers(numThreads);
+    for (auto& worker : workers)
+    {
+        worker = AllocateMinCostMaxFlow(base.numNodes, std::make_shared<SolverArena>(cliArgs.hugePages));
+    }
+
+    // Scenarios are taken in order, so the scenario a thread waits for was already taken by a thread that is solving it
+    std::atomic<int> nextPosition(0);
+    pool.ParallelFor(numThreads, [&](int workerIndex) {
+        MinCostMaxFlowArgs& args = workers[workerIndex];
+        for (int position = nextPosition++; position < numScenarios; position = nextPosition++)
+        {
+            const int scenario = order[position];
+            const std::vector<DanceClass>& scenarioClasses = scenarios[scenario].classes;
+            const int from = results[scenario].warmStartFrom;
+
+            PermuteDancerNodes(base, identity, args);
+            args.dancers = &dancers;
+            args.classes = &scenarioClasses;
+
+            bool isWarmStarted = from != -1;
+            if (isWarmStarted)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(solvedMutex);
+                    solvedCondition.wait(lock, [&]() { return isSolved[from] != 0; });
+                }
+
+                SetClassCapacities(args, scenarios[from].classes);
+                RestoreSolvedFlow(args, solved[from]);
+
+                for (int i = 0; i < scenarioClasses.size() && isWarmStarted; i++)
+                {
+                    const DanceClass& danceClass = scenarioClasses[i];
+                    const DanceClass& fromClass = scenarios[from].classes[i];
+                    if (danceClass.maxSize != fromClass.maxSize)
+                    {
+                        isWarmStarted = TryChangeClassCapacity(args, i, danceClass.maxSize - danceClass.minSize);
+                    }
+                    if (isWarmStarted && danceClass.additionalSpace != fromClass.additionalSpace)
+                    {
+                        isWarmStarted = TryChangeClassAdditionalSpace(args, i, danceClass.additionalSpace);
+                    }
+                }
+
+                // A scenario started from one that could not place every unit can have room for more of them
+                if (isWarmStarted)
+                {
+                    SuccessiveShortestPaths(args);
+                }
+            }
+
+            // When the dancers of a smaller class have nowhere else to go from the flow it started from, the scenario is solved from scratch
+            if (!isWarmStarted)
+            {
+                results[scenario].warmStartFrom = -1;
+
+                PermuteDancerNodes(base, identity, args);
+                args.classes = &scenarioClasses;
+                SetClassCapacities(args, scenarioClasses);
+                if (!ComputePotentials(args))
+                {
+                    printf("ERROR: the network of scenario %s contains a negative cycle\n", scenarios[scenario].name.c_str());
+                    exit(-1);
+                }
+                SuccessiveShortestPaths(args);
+
+                // Scenarios that start from this one search from class nodes too
+                ComputeAllPotentials(args);
+            }
+
+            CountFlowOutcome(results[scenario].statistics, args, dancers, statisticsInput);
+            results[scenario].cost = GetFlowCost(args);
+
+            SolvedFlow scenarioFlow = SaveSolvedFlow(args);
+            {
+                std::lock_guard<std::mutex> lock(solvedMutex);
+                solved[scenario] = std::move(scenarioFlow);
+                isSolved[scenario] = 1;
+            }
+            solvedCondition.notify_all();
+        }
+    });
+
+    return results;
+}
+
+// Placements per rank over all priority groups
+inline int64_t CountRank(const AssignmentStatistics& statistics, int rank)
+{
+    int64_t count = 0;
+    for (int group = 0; group < DancerPriorityGroup::Count; group++)
+    {
+        count += statistics.groupChoices[group][rank];
+    }
+    return count;
+}
+
+void PrintScenarios(const std::vector<CapacityScenario>& scenarios, const std::vector<ScenarioResult>& results)
+{
+    Print("Scenario comparison (%i scenarios):\n\n", (int)scenarios.size());
+    for (int i = 0; i < scenarios.size(); i++)
+    {
+        const ScenarioResult& result = results[i];
+        Print("%s: cost %lli, 1st choice %lli, 2nd choice %lli, 3rd choice %lli, unenrolled %lli", scenarios[i].name.c_str(), (long long)result.cost,
+            (long long)CountRank(result.statistics, 0), (long long)CountRank(result.statistics, 1),
+            (long long)CountRank(result.statistics, 2), (long long)CountRank(result.statistics, 3));
+        if (result.warmStartFrom != -1)
+        {
+            Print(" (started from %s)", scenarios[result.warmStartFrom].name.c_str());
+        }
+        Print("\n");
+    }
+    Print("\n");
+}
+
+void ExportScenarios(const std::vector<CapacityScenario>& scenarios, const std::vector<ScenarioResult>& results, const std::string& outputName)
+{
+    auto outputPath = GetOutputFolder() / (outputName + ".csv");
+    std::ofstream outputFile(outputPath);
+
+    outputFile << "Scenario,Started from,Cost,1st choice,2nd choice,3rd choice,unenrolled";
+    for (int group = 0; group < DancerPriorityGroup::Count; group++)
+    {
+        outputFile << ",Unenrolled " << DancerPriorityGroupToString((DancerPriorityGroup)group);
+    }
+    outputFile << "\n";
+
+    for (int i = 0; i < scenarios.size(); i++)
+    {
+        const ScenarioResult& result = results[i];
+        outputFile << scenarios[i].name << "," << (result.warmStartFrom == -1 ? "" : scenarios[result.warmStartFrom].name) << "," << result.cost;
+        for (int rank = 0; rank < 4; rank++)
+        {
+            outputFile << "," << CountRank(result.statistics, rank);
+        }
+        for (int group = 0; group < DancerPriorityGroup::Count; group++)
+        {
+            outputFile << "," << result.statistics.groupChoices[group][3];
+        }
+        outputFile << "\n";
+    }
+
+    outputFile.close();
+
+    Print("Exported to: %s\n\n", outputPath.string().c_str());
+}
+
+std::vector<UnenrollSweepStep> SweepMaxUnenroll(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const StatisticsInput& statisticsInput, const CliArguments& cliArgs)
+{
+    int unenrolledIndex = -1;
+    for (int i = 0; i < classes.size(); i++)
+    {
+        if (classes[i].name == "unenrolled")
+        {
+            unenrolledIndex = i;
+        }
+    }
+    if (unenrolledIndex == -1)
+    {
+        printf("ERROR: there is no unenrolled class to sweep the capacity of\n");
+        exit(-1);
+    }
+
+    // The sweep starts unbounded, --max-unenroll is where it stops
+    CliArguments encodeArgs = cliArgs;
+    encodeArgs.isUpdate = false;
+    encodeArgs.maxUnenroll = 0xFFFFFFFFU;
+    MinCostMaxFlowArgs args = EncodeMinCostMaxFlow(dancers, classes, encodeArgs);
+    MinCostMaxFlow(args, encodeArgs);
+
+    // Lowering the capacity searches from the unenrolled class node
+    if (!ComputeAllPotentials(args))
+    {
+        printf("ERROR: the solved network contains a negative cycle\n");
+        exit(-1);
+    }
+
+    const int lowestCapacity = cliArgs.maxUnenroll != 0xFFFFFFFFU ? std::max(cliArgs.maxUnenroll, 0) : 0;
+    const int unenrolledNode = args.classOffset + unenrolledIndex;
+    // Any capacity of at least the unenrolled dancers of the unbounded solve gives that solve
+    std::vector<UnenrollSweepStep> steps;
+    int capacity = (int)args.flow[(size_t)unenrolledNode * args.numNodes + args.classCostOffset + unenrolledIndex * 3];
+    while (true)
+    {
+        UnenrollSweepStep step;
+        step.maxUnenroll = capacity;
+        step.cost = GetFlowCost(args);
+        CountFlowOutcome(step.statistics, args, dancers, statisticsInput);
+        steps.push_back(step);
+
+        // Every step moves a single dancer out of unenrolled along the cheapest way that is left, a single search
+        if (capacity <= lowestCapacity || !TryChangeClassCapacity(args, unenrolledIndex, capacity - 1))
+        {
+            break;
+        }
+        capacity--;
+    }
+
+    return steps;
+}
+
+void PrintUnenrollSweep(const std::vector<UnenrollSweepStep>& steps, const CliArguments& cliArgs)
+{
+    Print("Sweep over --max-unenroll (%i values):\n\n", (int)steps.size());
+    for (const UnenrollSweepStep& step : steps)
+    {
+        Print("--max-unenroll %i: cost %lli, 1st choice %lli, 2nd choice %lli, 3rd choice %lli, unenrolled", step.maxUnenroll, (long long)step.cost,
+            (long long)CountRank(step.statistics, 0), (long long)CountRank(step.statistics, 1), (long long)CountRank(step.statistics, 2));
+        for (int group = 0; group < DancerPriorityGroup::Count; group++)
+        {
+            Print(" %s %lli", DancerPriorityGroupToString((DancerPriorityGroup)group).c_str(), (long long)step.statistics.groupChoices[group][3]);
+        }
+        Print("\n");
+    }
+
+    // The sweep only stops before --max-unenroll, or 0, when nobody else could be placed
+    const int lowestCapacity = cliArgs.maxUnenroll != 0xFFFFFFFFU ? std::max(cliArgs.maxUnenroll, 0) : 0;
+    if (steps.back().maxUnenroll > lowestCapacity)
+    {
+        Print("\nSmallest --max-unenroll that places every dancer: %i\n", steps.back().maxUnenroll);
+    }
+    Print("\n");
+}
+
+void ExportUnenrollSweep(const std::vector<UnenrollSweepStep>& steps, const std::string& outputName)
+{
+    auto outputPath = GetOutputFolder() / (outputName + ".csv");
+    std::ofstream outputFile(outputPath);
+
+    outputFile << "Max unenroll,Cost,1st choice,2nd choice,3rd choice,unenrolled";
+    for (int group = 0; group < DancerPriorityGroup::Count; group++)
+    {
+        outputFile << ",Unenrolled " << DancerPriorityGroupToString((DancerPriorityGroup)group);
+    }
+    outputFile << "\n";
+
+    for (const UnenrollSweepStep& step : steps)
+    {
+        outputFile << step.maxUnenroll << "," << step.cost;
+        for (int rank = 0; rank < 4; rank++)
+        {
+            outputFile << "," << CountRank(step.statistics, rank);
+        }
+        for (int group = 0; group < DancerPriorityGroup::Count; group++)
+        {
+            outputFile << "," << step.statistics.groupChoices[group][3];
+        }
+        outputFile << "\n";
+    }
+
+    outputFile.close();
+
+    Print("Exported to: %s\n\n", outputPath.string().c_str());
+}
+
+std::vector<CostSweepResult> SolveCostSweep(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const StatisticsInput& statisticsInput, const std::vector<NamedCostModel>& costModels, const CliArguments& cliArgs)
+{
+    const int numCostModels = (int)costModels.size();
+
+    CliArguments encodeArgs = cliArgs;
+    encodeArgs.isUpdate = false;
+    MinCostMaxFlowArgs base = EncodeMinCostMaxFlow(dancers, classes, encodeArgs);
+
+    TaskPool& pool = GetTaskPool();
+    int numThreads = std::min(pool.GetNumThreads(), numCostModels);
+    std::vector<MinCostMaxFlowArgs> workers(numThreads);
+    for (auto& worker : workers)
+    {
+        worker = ShareMinCostMaxFlowTopology(base, std::make_shared<SolverArena>(cliArgs.hugePages));
+    }
+
+    std::vector<CostSweepResult> results(numCostModels);
+    std::atomic<int> nextCostModel(0);
+    pool.ParallelFor(numThreads, [&](int workerIndex) {
+        MinCostMaxFlowArgs& args = workers[workerIndex];
+        for (int index = nextCostModel++; index < numCostModels; index = nextCostModel++)
+        {
+            memset(args.flow, 0, (size_t)args.numNodes * args.numNodes * sizeof(args.flow[0]));
+            args.decisions.clear();
+
+            SetArcCosts(args, CompileCostModel(costModels[index].parameters));
+            if (!ComputePotentials(args))
+            {
+                printf("ERROR: the network of cost model %s contains a negative cycle\n", costModels[index].name.c_str());
+                exit(-1);
+            }
+            SuccessiveShortestPaths(args);
+
+            CostSweepResult& result = results[index];
+            result.cost = GetFlowCost(args);
+            CountFlowOutcome(result.statistics, args, dancers, statisticsInput);
+
+            result.placements.assign(dancers.size(), {});
+            for (int dancerIndex = 0; dancerIndex < dancers.size(); dancerIndex++)
+            {
+                int dancerNode = args.dancerOffset + dancerIndex;
+                for (int neighbour : args.adjecencyList[dancerNode])
+                {
+                    bool isClass = neighbour >= args.classOffset && neighbour < args.classCostOffset;
+                    if (isClass && args.flow[(size_t)dancerNode * args.numNodes + neighbour] > 0)
+                    {
+                        result.placements[dancerIndex].push_back(neighbour - args.classOffset);
+                    }
+                }
+                std::sort(result.placements[dancerIndex].begin(), result.placements[dancerIndex].end());
+            }
+        }
+    });
+
+    for (CostSweepResult& result : results)
+    {
+        result.changedDancers = 0;
+        for (int dancerIndex = 0; dancerIndex < dancers.size(); dancerIndex++)
+        {
+            result.changedDancers += result.placements[dancerIndex] != results[0].placements[dancerIndex];
+        }
+    }
+
+    return results;
+}
+
+void PrintCostSweep(const std::vector<NamedCostModel>& costModels, const std::vector<CostSweepResult>& results)
+{
+    Print("Cost model comparison (%i cost models):\n\n", (int)costModels.size());
+    for (int i = 0; i < costModels.size(); i++)
+    {
+        const CostSweepResult& result = results[i];
+        Print("%s: cost %lli, 1st choice %lli, 2nd choice %lli, 3rd choice %lli, unenrolled %lli", costModels[i].name.c_str(), (long long)result.cost,
+            (long long)CountRank(result.statistics, 0), (long long)CountRank(result.statistics, 1),
+            (long long)CountRank(result.statistics, 2), (long long)CountRank(result.statistics, 3));
+        if (i > 0)
+        {
+            Print(", %i dancers placed differently than %s", result.changedDancers, costModels[0].name.c_str());
+        }
+        Print("\n");
+    }
+    Print("\n");
+}
+
+// Names of the classes a dancer is placed in
+std::string PlacementToString(const std::vector<int>& placement, const std::vector<DanceClass>& classes)
+{
+    std::string text;
+    for (int classIndex : placement)
+    {
+        text += (text.empty() ? "" : " + ") + classes[classIndex].name;
+    }
+    return text.empty() ? "unassigned" : text;
+}
+
+void ExportCostSweep(const std::vector<NamedCostModel>& costModels, const std::vector<CostSweepResult>& results,
+                     const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const std::string& outputName)
+{
+    auto outputPath = GetOutputFolder() / (outputName + ".csv");
+    std::ofstream outputFile(outputPath);
+
+    // The names of grid sets hold the commas of their weights
+    outputFile << "Cost model,Cost,Changed dancers,1st choice,2nd choice,3rd choice,unenrolled";
+    for (int group = 0; group < DancerPriorityGroup::Count; group++)
+    {
+        outputFile << ",Unenrolled " << DancerPriorityGroupToString((DancerPriorityGroup)group);
+    }
+    outputFile << "\n";
+
+    for (int i = 0; i < costModels.size(); i++)
+    {
+        const CostSweepResult& result = results[i];
+        outputFile << "\"" << costModels[i].name << "\"," << result.cost << "," << result.changedDancers;
+        for (int rank = 0; rank < 4; rank++)
+        {
+            outputFile << "," << CountRank(result.statistics, rank);
+        }
+        for (int group = 0; group < DancerPriorityGroup::Count; group++)
+        {
+            outputFile << "," << result.statistics.groupChoices[group][3];
+        }
+        outputFile << "\n";
+    }
+
+    outputFile.close();
+
+    Print("Exported to: %s\n", outputPath.string().c_str());
+
+    auto changesPath = GetOutputFolder() / (outputName + "_Changes.csv");
+    std::ofstream changesFile(changesPath);
+
+    changesFile << "Relation number,Priority group";
+    for (const NamedCostModel& costModel : costModels)
+    {
+        changesFile << ",\"" << costModel.name << "\"";
+    }
+    changesFile << "\n";
+
+    for (int dancerIndex = 0; dancerIndex < dancers.size(); dancerIndex++)
+    {
+        bool isChanged = false;
+        for (const CostSweepResult& result : results)
+        {
+            isChanged = isChanged || result.placements[dancerIndex] != results[0].placements[dancerIndex];
+        }
+        if (!isChanged)
+        {
+            continue;
+        }
+
+        const Studancer& dancer = dancers[dancerIndex];
+        changesFile << dancer.relationNumber << "," << DancerPriorityGroupToString(dancer.priorityGroup);
+        for (const CostSweepResult& result : results)
+        {
+            changesFile << "," << PlacementToString(result.placements[dancerIndex], classes);
+        }
+        changesFile << "\n";
+    }
+
+    changesFile.close();
+
+    Print("Exported to: %s\n\n", changesPath.string().c_str());
+}
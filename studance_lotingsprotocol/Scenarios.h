@@ -0,0 +1,73 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Studancer.h"
+#include "DanceClass.h"
+#include "CliArgs.h"
+#include "Statistics.h"
+#include "CostModel.h"
+
+// The classes of one what-if scenario, with its capacity overrides applied
+struct CapacityScenario
+{
+    std::string name;
+    std::vector<DanceClass> classes;
+};
+
+struct ScenarioResult
+{
+    int warmStartFrom;                  // scenario the solve started from, -1 when it was solved from the encoded network
+    int64_t cost;
+    AssignmentStatistics statistics;
+};
+
+// Loads capacity overrides from a csv with the columns Scenario, Naam, Maximale Ruimte and Extra Speel Ruimte
+// Rows with the same scenario name form one scenario, an empty size keeps the size of danceclasses.csv
+// The classes as loaded are always the first scenario
+std::vector<CapacityScenario> LoadScenarios(const std::string& fileName, const std::vector<DanceClass>& classes);
+
+// Solves every scenario on the task pool, the dancer side of the network is encoded once and every thread has its own copy
+// A scenario starts from the solved scenario closest to it in seats when that is fewer seats than there are units to place,
+// otherwise from the encoded network
+std::vector<ScenarioResult> SolveScenarios(const std::vector<Studancer>& dancers, const StatisticsInput& statisticsInput, const std::vector<CapacityScenario>& scenarios, const CliArguments& cliArgs);
+
+void PrintScenarios(const std::vector<CapacityScenario>& scenarios, const std::vector<ScenarioResult>& results);
+
+// Writes the comparison of the scenarios to <outputName>.csv in the output folder
+void ExportScenarios(const std::vector<CapacityScenario>& scenarios, const std::vector<ScenarioResult>& results, const std::string& outputName);
+
+struct UnenrollSweepStep
+{
+    int maxUnenroll;
+    int64_t cost;
+    AssignmentStatistics statistics;
+};
+
+// Solves once without a limit on the unenrolled class and then lowers its capacity one dancer at a time,
+// every step only moves the dancer taken out of unenrolled, see TryChangeClassCapacity()
+// Stops at --max-unenroll (0 when not given) or at the smallest capacity that still places every dancer
+std::vector<UnenrollSweepStep> SweepMaxUnenroll(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const StatisticsInput& statisticsInput, const CliArguments& cliArgs);
+
+void PrintUnenrollSweep(const std::vector<UnenrollSweepStep>& steps, const CliArguments& cliArgs);
+
+// Writes the outcome of every capacity of the sweep to <outputName>.csv in the output folder
+void ExportUnenrollSweep(const std::vector<UnenrollSweepStep>& steps, const std::string& outputName);
+
+struct CostSweepResult
+{
+    int64_t cost;                               // cost of the assignment in the cost model it was solved with
+    AssignmentStatistics statistics;
+    std::vector<std::vector<int>> placements;   // per dancer the indices of the classes it is placed in
+    int changedDancers;                         // dancers placed differently than with the first cost model
+};
+
+// Solves with every cost model on the task pool, the network is encoded once and every thread shares its topology and capacities
+// Only the costs and the flow are per thread, SetArcCosts() puts the weights of the next cost model in place
+std::vector<CostSweepResult> SolveCostSweep(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const StatisticsInput& statisticsInput, const std::vector<NamedCostModel>& costModels, const CliArguments& cliArgs);
+
+void PrintCostSweep(const std::vector<NamedCostModel>& costModels, const std::vector<CostSweepResult>& results);
+
+// Writes the comparison of the cost models to <outputName>.csv in the output folder
+// and every dancer that is not placed the same with all of them to <outputName>_Changes.csv
+void ExportCostSweep(const std::vector<NamedCostModel>& costModels, const std::vector<CostSweepResult>& results,
+                     const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const std::string& outputName);
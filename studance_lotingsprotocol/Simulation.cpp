@@ -0,0 +1,258 @@
+#include "Simulation.h"
+#include "Lottery.h"
+#include "Utils.h"
+#include "TaskPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+
+// Number of runs a worker takes from the shared counter at once
+const int simulationChunkSize = 64;
+
+void ClearSimulationResult(SimulationResult& result, int numDancers, int numClasses)
+{
+    result.runs = 0;
+    result.dancerOutcomes.assign(numDancers, { 0, 0, 0, 0 });
+    ClearAssignmentStatistics(result.statistics, numClasses);
+    result.classOutcomes.assign(numClasses, { 0, 0, 0, 0 });
+    result.classFull.assign(numClasses, 0);
+}
+
+void MergeSimulationResult(SimulationResult& result, const SimulationResult& other)
+{
+    result.runs += other.runs;
+    for (int i = 0; i < result.dancerOutcomes.size(); i++)
+    {
+        for (int rank = 0; rank < 4; rank++)
+        {
+            result.dancerOutcomes[i][rank] += other.dancerOutcomes[i][rank];
+        }
+    }
+    MergeAssignmentStatistics(result.statistics, other.statistics);
+    for (int i = 0; i < result.classOutcomes.size(); i++)
+    {
+        for (int rank = 0; rank < 4; rank++)
+        {
+            result.classOutcomes[i][rank] += other.classOutcomes[i][rank];
+        }
+        result.classFull[i] += other.classFull[i];
+    }
+}
+
+// State of a single simulation thread, kept alive over all of its runs so the buffers are reused
+struct SimulationWorker
+{
+    std::vector<int> order;             // shuffled position -> index in the dancers vector
+    std::vector<int> classSizes;        // assigned dancers per class id in the current run
+    LotteryState state;
+    SimulationResult result;
+};
+
+void RunSimulation(SimulationWorker& worker, const LotteryInput& input, const StatisticsInput& statisticsInput,
+                   const std::vector<int>& canonicalOrder, unsigned int seed, int run)
+{
+    // Every run gets its own generator so the outcome does not depend on which thread runs it
+    std::seed_seq seedSequence = { seed, (unsigned int)run };
+    std::mt19937 rng(seedSequence);
+
+    // Shuffle a fixed starting order like LoadDancers() does
+    worker.order = canonicalOrder;
+    std::shuffle(worker.order.begin(), worker.order.end(), rng);
+
+    DrawLottery(input, worker.order, rng, worker.state);
+
+    std::fill(worker.classSizes.begin(), worker.classSizes.end(), 0);
+    for (int dancer : worker.state.placements)
+    {
+        int classId = worker.state.assignedClass[dancer];
+        int rank = GetLotteryChoiceRank(input, dancer, classId);
+
+        worker.result.dancerOutcomes[dancer][rank]++;
+        worker.result.classOutcomes[classId][rank]++;
+        CountPlacement(worker.result.statistics, statisticsInput, dancer, classId);
+        worker.classSizes[classId]++;
+    }
+
+    for (int classIndex = 0; classIndex < input.numClasses; classIndex++)
+    {
+        int classId = input.classId[classIndex];
+        if (worker.classSizes[classId] >= input.classCapacity[classId])
+        {
+            worker.result.classFull[classIndex]++;
+        }
+    }
+
+    worker.result.runs++;
+    worker.result.statistics.runs++;
+}
+
+SimulationResult SimulateLottery(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const StatisticsInput& statisticsInput, int runs, unsigned int seed)
+{
+    // The loaded dancers are already shuffled, start every run from the relation number order instead
+    // so the same seed always gives the same result
+    std::vector<int> canonicalOrder(dancers.size());
+    std::iota(canonicalOrder.begin(), canonicalOrder.end(), 0);
+    std::sort(canonicalOrder.begin(), canonicalOrder.end(), [&](int a, int b) {
+        return dancers[a].relationNumber < dancers[b].relationNumber;
+    });
+
+    LotteryInput input = PrepareLottery(dancers, classes);
+
+    TaskPool& pool = GetTaskPool();
+    int numThreads = std::min(pool.GetNumThreads(), std::max(1, runs / simulationChunkSize));
+
+    std::vector<SimulationWorker> workers(numThreads);
+    for (auto& worker : workers)
+    {
+        worker.order.resize(dancers.size());
+        worker.classSizes.resize(classes.size());
+        ClearSimulationResult(worker.result, (int)dancers.size(), (int)classes.size());
+    }
+
+    std::atomic<int> nextRun(0);
+    pool.ParallelFor(numThreads, [&](int workerIndex) {
+        SimulationWorker& worker = workers[workerIndex];
+        while (true)
+        {
+            int firstRun = nextRun.fetch_add(simulationChunkSize);
+            if (firstRun >= runs)
+            {
+                break;
+            }
+
+            int lastRun = std::min(firstRun + simulationChunkSize, runs);
+            for (int run = firstRun; run < lastRun; run++)
+            {
+                RunSimulation(worker, input, statisticsInput, canonicalOrder, seed, run);
+            }
+        }
+    });
+
+    SimulationResult result;
+    ClearSimulationResult(result, (int)dancers.size(), (int)classes.size());
+    for (auto& worker : workers)
+    {
+        MergeSimulationResult(result, worker.result);
+    }
+
+    // Classes sharing a name were counted on the first of them, give the others the same outcomes
+    for (int classIndex = 0; classIndex < classes.size(); classIndex++)
+    {
+        result.classOutcomes[classIndex] = result.classOutcomes[input.classId[classIndex]];
+        result.statistics.classChoices[classIndex] = result.statistics.classChoices[input.classId[classIndex]];
+    }
+
+    return result;
+}
+
+void PrintSimulationStats(const SimulationResult& result, const std::vector<Studancer>& dancers)
+{
+    int groupSizes[DancerPriorityGroup::Count] = {};
+    for (auto& dancer : dancers)
+    {
+        groupSizes[dancer.priorityGroup]++;
+    }
+
+    const int longestPriorityGroupName = (int)strlen("NonDancerLastYear") + 1;
+    std::string groupName = "| Group Name";
+    for (int i = 0; i < longestPriorityGroupName - (int)strlen("| Group Name") + 2; i++)
+    {
+        groupName += " ";
+    }
+    groupName += "|";
+    std::string headerRow = "";
+    for (int i = 0; i < groupName.length(); i++)
+    {
+        headerRow += "=";
+    }
+
+    Print("Simulation Statistics (%i runs):\n\n", result.runs);
+    Print("%s===================================================================\n", headerRow.c_str());
+    Print("%s| Dancers ||  1st choice ||  2nd choice ||  3rd choice ||  unenrolled |\n", groupName.c_str());
+    Print("%s===================================================================\n", headerRow.c_str());
+
+    for (int i = 0; i < (int)DancerPriorityGroup::Count; i++)
+    {
+        std::string priorityGroupName = DancerPriorityGroupToString((DancerPriorityGroup)i);
+        Print("| %s", priorityGroupName.c_str());
+        for (int space = 0; space < longestPriorityGroupName - priorityGroupName.length(); space++)
+        {
+            Print(" ");
+        }
+        Print("|| %7i |", groupSizes[i]);
+
+        const int64_t* outcomes = result.statistics.groupChoices[i];
+        int64_t total = outcomes[0] + outcomes[1] + outcomes[2] + outcomes[3];
+        for (int rank = 0; rank < 4; rank++)
+        {
+            double p = total == 0 ? 0.0 : ((double)outcomes[rank] / (double)total) * 100.0;
+            Print("|    %6.2f%% |", p);
+        }
+        Print("\n");
+    }
+    Print("%s===================================================================\n\n", headerRow.c_str());
+}
+
+void ExportSimulation(const SimulationResult& result, const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const std::string& outputName)
+{
+    std::string outputFileName = outputName + ".csv";
+    auto outputPath = GetOutputFolder() / outputFileName;
+    std::ofstream outputFile(outputPath);
+
+    const double runs = std::max(1, result.runs);
+    char line[512];
+
+    // Per priority group
+    outputFile << "Priority group,Dancers,1st choice,2nd choice,3rd choice,unenrolled\n";
+    int groupSizes[DancerPriorityGroup::Count] = {};
+    for (auto& dancer : dancers)
+    {
+        groupSizes[dancer.priorityGroup]++;
+    }
+    for (int i = 0; i < (int)DancerPriorityGroup::Count; i++)
+    {
+        const int64_t* outcomes = result.statistics.groupChoices[i];
+        double total = std::max<int64_t>(1, outcomes[0] + outcomes[1] + outcomes[2] + outcomes[3]);
+        snprintf(line, sizeof(line), "%s,%i,%.6f,%.6f,%.6f,%.6f\n", DancerPriorityGroupToString((DancerPriorityGroup)i).c_str(), groupSizes[i],
+            outcomes[0] / total, outcomes[1] / total, outcomes[2] / total, outcomes[3] / total);
+        outputFile << line;
+    }
+    outputFile << "\n\n";
+
+    // Per class, averaged over the runs
+    outputFile << "Class,Max size,Mean assigned,Mean 1st choice,Mean 2nd choice,Mean 3rd choice,Full\n";
+    for (int i = 0; i < classes.size(); i++)
+    {
+        const std::array<int64_t, 4>& outcomes = result.classOutcomes[i];
+        int64_t assigned = outcomes[0] + outcomes[1] + outcomes[2] + outcomes[3];
+        snprintf(line, sizeof(line), "%s,%i,%.4f,%.4f,%.4f,%.4f,%.6f\n", classes[i].name.c_str(), classes[i].maxSize,
+            assigned / runs, outcomes[0] / runs, outcomes[1] / runs, outcomes[2] / runs, result.classFull[i] / runs);
+        outputFile << line;
+    }
+    outputFile << "\n\n";
+
+    // Per dancer, ordered on relation number
+    std::vector<int> order(dancers.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return dancers[a].relationNumber < dancers[b].relationNumber;
+    });
+
+    outputFile << "Relatienummer,Priority group,1e keuze,2e keuze,3e keuze,1st choice,2nd choice,3rd choice,unenrolled\n";
+    for (int i : order)
+    {
+        const Studancer& dancer = dancers[i];
+        const std::array<int64_t, 4>& outcomes = result.dancerOutcomes[i];
+        snprintf(line, sizeof(line), "%i,%s,%s,%s,%s,%.6f,%.6f,%.6f,%.6f\n", dancer.relationNumber,
+            DancerPriorityGroupToString(dancer.priorityGroup).c_str(),
+            dancer.chosenClasses[0].c_str(), dancer.chosenClasses[1].c_str(), dancer.chosenClasses[2].c_str(),
+            outcomes[0] / runs, outcomes[1] / runs, outcomes[2] / runs, outcomes[3] / runs);
+        outputFile << line;
+    }
+
+    outputFile.close();
+
+    Print("Exported to: %s\n\n", outputPath.string().c_str());
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <vector>
+#include <array>
+#include <string>
+#include "Studancer.h"
+#include "DanceClass.h"
+#include "Statistics.h"
+
+// Outcome counts over many lottery runs
+// Ranks 0-2 are the 1st-3rd choice, rank 3 is unenrolled
+struct SimulationResult
+{
+    int runs;
+    std::vector<std::array<int64_t, 4>> dancerOutcomes;     // per dancer, same order as the dancers vector
+    AssignmentStatistics statistics;                        // histograms of all runs, also gives the outcomes per priority group
+    std::vector<std::array<int64_t, 4>> classOutcomes;      // per class, same order as the classes vector
+    std::vector<int64_t> classFull;                          // number of runs in which the class was full
+};
+
+void ClearSimulationResult(SimulationResult& result, int numDancers, int numClasses);
+
+// Adds the counts of other to result, both must have been cleared for the same dancers and classes
+void MergeSimulationResult(SimulationResult& result, const SimulationResult& other);
+
+// Runs the lottery for a number of seeded shuffles spread over all cores
+// Run i always uses the same shuffle for the same seed, independent of the number of threads
+SimulationResult SimulateLottery(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const StatisticsInput& statisticsInput, int runs, unsigned int seed);
+
+void PrintSimulationStats(const SimulationResult& result, const std::vector<Studancer>& dancers);
+
+void ExportSimulation(const SimulationResult& result, const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const std::string& outputName);
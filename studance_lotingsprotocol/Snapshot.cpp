@@ -0,0 +1,298 @@
+#include "Snapshot.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+
+// Layout of a snapshot:
+//   SnapshotHeader
+//   numClasses times: uint32 name length, name bytes
+//   numPlacements times: int32 relation number, int32 index in the class table
+const char snapshotMagic[8] = { 'S', 'T', 'D', 'S', 'N', 'A', 'P', '\0' };
+const uint32_t snapshotVersion = 2;
+
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t numClasses;
+    uint64_t numPlacements;
+    uint64_t exportHash;    // HashExportContent() of the export written together with the snapshot
+    uint64_t inputHash;     // HashInputFiles() when the snapshot was written
+};
+
+uint64_t HashExportContent(const char* data, size_t size)
+{
+    // 64 bit FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < size; i++)
+    {
+        if (data[i] == '\r')
+        {
+            continue;
+        }
+        hash ^= (unsigned char)data[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+fs::path GetSnapshotPath(const fs::path& exportPath)
+{
+    fs::path snapshotPath = exportPath;
+    snapshotPath.replace_extension(".snapshot");
+    return snapshotPath;
+}
+
+// Reads a whole file at once, returns false when it cannot be opened
+bool ReadWholeFile(const fs::path& path, std::string& content)
+{
+    std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    std::streamsize size = file.tellg();
+    file.seekg(0);
+    content.resize((size_t)size);
+    return (bool)file.read(&content[0], size);
+}
+
+uint64_t HashInputFiles()
+{
+    std::vector<std::vector<std::string>> inputFileNames = {
+        { "danceclasses.csv" },
+        DancerFileNames(),
+        { "Board.txt" }
+    };
+
+    // Every export and reload hashes the input, a file is only read again when its size or write time changed
+    struct HashedFile
+    {
+        fs::path path;
+        uintmax_t size;
+        fs::file_time_type writeTime;
+        uint64_t hash;
+    };
+    static std::mutex hashedFilesMutex;
+    static std::vector<HashedFile> hashedFiles;
+
+    uint64_t hash = 0;
+    for (const std::vector<std::string>& fileNames : inputFileNames)
+    {
+        fs::path inputPath;
+        FindInputFile(fileNames, inputPath);
+        uintmax_t size = fs::file_size(inputPath);
+        fs::file_time_type writeTime = fs::last_write_time(inputPath);
+
+        std::lock_guard<std::mutex> lock(hashedFilesMutex);
+        auto hashed = std::find_if(hashedFiles.begin(), hashedFiles.end(), [&](const HashedFile& file) { return file.path == inputPath; });
+        if (hashed == hashedFiles.end() || hashed->size != size || hashed->writeTime != writeTime)
+        {
+            std::string content;
+            ReadWholeFile(inputPath, content);
+            HashedFile file = { inputPath, size, writeTime, HashExportContent(content.data(), content.size()) };
+            if (hashed == hashedFiles.end())
+            {
+                hashedFiles.push_back(file);
+                hashed = hashedFiles.end() - 1;
+            }
+            else
+            {
+                *hashed = file;
+            }
+        }
+        hash = hash * 0x100000001b3ULL ^ hashed->hash;
+    }
+    return hash;
+}
+
+void WriteAssignmentSnapshot(const Assignment& assignment, const fs::path& exportPath, uint64_t exportHash)
+{
+    SnapshotHeader header = {};
+    memcpy(header.magic, snapshotMagic, sizeof(snapshotMagic));
+    header.version = snapshotVersion;
+    header.numClasses = (uint32_t)assignment.size();
+    header.exportHash = exportHash;
+    header.inputHash = HashInputFiles();
+
+    size_t size = sizeof(SnapshotHeader);
+    for (auto& classAssignment : assignment)
+    {
+        size += sizeof(uint32_t) + classAssignment.first.name.size();
+        header.numPlacements += classAssignment.second.size();
+    }
+    size += header.numPlacements * 2 * sizeof(int32_t);
+
+    std::string buffer(size, '\0');
+    char* cursor = &buffer[0];
+    memcpy(cursor, &header, sizeof(header));
+    cursor += sizeof(header);
+
+    for (auto& classAssignment : assignment)
+    {
+        uint32_t length = (uint32_t)classAssignment.first.name.size();
+        memcpy(cursor, &length, sizeof(length));
+        cursor += sizeof(length);
+        memcpy(cursor, classAssignment.first.name.data(), length);
+        cursor += length;
+    }
+
+    int32_t classId = 0;
+    for (auto& classAssignment : assignment)
+    {
+        for (auto& dancer : classAssignment.second)
+        {
+            int32_t placement[2] = { dancer.relationNumber, classId };
+            memcpy(cursor, placement, sizeof(placement));
+            cursor += sizeof(placement);
+        }
+        classId++;
+    }
+
+    std::ofstream snapshotFile(GetSnapshotPath(exportPath), std::ios::out | std::ios::binary);
+    snapshotFile.write(buffer.data(), (std::streamsize)buffer.size());
+}
+
+bool LoadAssignmentSnapshot(const fs::path& exportPath, const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes,
+                            std::vector<AssignmentPlacement>& placements)
+{
+    // --update reads a copy of the MCMF export, the export hash below tells whether it is still the same content
+    fs::path snapshotPath = GetSnapshotPath(exportPath);
+    const std::string updatableSuffix = "_updatable";
+    std::string stem = exportPath.stem().string();
+    if (!fs::exists(snapshotPath) && stem.size() > updatableSuffix.size() && stem.compare(stem.size() - updatableSuffix.size(), updatableSuffix.size(), updatableSuffix) == 0)
+    {
+        snapshotPath = GetSnapshotPath(exportPath.parent_path() / (stem.substr(0, stem.size() - updatableSuffix.size()) + exportPath.extension().string()));
+    }
+
+    std::string snapshot;
+    if (!ReadWholeFile(snapshotPath, snapshot))
+    {
+        return false;
+    }
+
+    SnapshotHeader header;
+    if (snapshot.size() < sizeof(header))
+    {
+        Print("Snapshot %s is damaged, loading the export instead\n", snapshotPath.string().c_str());
+        return false;
+    }
+    memcpy(&header, snapshot.data(), sizeof(header));
+
+    if (memcmp(header.magic, snapshotMagic, sizeof(snapshotMagic)) != 0 || header.version != snapshotVersion)
+    {
+        Print("Snapshot %s has an unknown format, loading the export instead\n", snapshotPath.string().c_str());
+        return false;
+    }
+
+    // The export may have been edited by hand after it was written
+    std::string exportContent;
+    if (!ReadWholeFile(exportPath, exportContent) || HashExportContent(exportContent.data(), exportContent.size()) != header.exportHash)
+    {
+        Print("Snapshot %s does not match %s anymore, loading the export instead\n", snapshotPath.string().c_str(), exportPath.string().c_str());
+        return false;
+    }
+
+    if (header.inputHash != HashInputFiles())
+    {
+        Print("Snapshot %s was made from other input files, loading the export instead\n", snapshotPath.string().c_str());
+        return false;
+    }
+
+    // Class table, mapped on the loaded classes by name
+    const char* cursor = snapshot.data() + sizeof(header);
+    const char* end = snapshot.data() + snapshot.size();
+    std::vector<int> classIndices(header.numClasses);
+    for (uint32_t i = 0; i < header.numClasses; i++)
+    {
+        uint32_t length;
+        if (end - cursor < (ptrdiff_t)sizeof(length))
+        {
+            Print("Snapshot %s is damaged, loading the export instead\n", snapshotPath.string().c_str());
+            return false;
+        }
+        memcpy(&length, cursor, sizeof(length));
+        cursor += sizeof(length);
+        if ((size_t)(end - cursor) < length)
+        {
+            Print("Snapshot %s is damaged, loading the export instead\n", snapshotPath.string().c_str());
+            return false;
+        }
+
+        std::string name(cursor, length);
+        cursor += length;
+
+        classIndices[i] = -1;
+        for (int classIndex = 0; classIndex < classes.size(); classIndex++)
+        {
+            if (classes[classIndex].name == name)
+            {
+                classIndices[i] = classIndex;
+                break;
+            }
+        }
+
+        if (classIndices[i] == -1)
+        {
+            Print("Class %s of snapshot %s is not in the input anymore, loading the export instead\n", name.c_str(), snapshotPath.string().c_str());
+            return false;
+        }
+    }
+
+    if ((size_t)(end - cursor) != header.numPlacements * 2 * sizeof(int32_t))
+    {
+        Print("Snapshot %s is damaged, loading the export instead\n", snapshotPath.string().c_str());
+        return false;
+    }
+
+    std::vector<int32_t> entries(header.numPlacements * 2);
+    memcpy(entries.data(), cursor, entries.size() * sizeof(int32_t));
+
+    std::vector<int> relationNumbers(header.numPlacements);
+    for (size_t i = 0; i < header.numPlacements; i++)
+    {
+        relationNumbers[i] = entries[2 * i];
+        if (entries[2 * i + 1] < 0 || entries[2 * i + 1] >= (int32_t)header.numClasses)
+        {
+            Print("Snapshot %s is damaged, loading the export instead\n", snapshotPath.string().c_str());
+            return false;
+        }
+    }
+
+    std::vector<int> dancerIndices = FindDancersByRelationNumber(dancers, relationNumbers);
+
+    placements.clear();
+    placements.reserve(header.numPlacements);
+    for (size_t i = 0; i < header.numPlacements; i++)
+    {
+        if (dancerIndices[i] == -1)
+        {
+            Print("Dancer %i from the existing solution is not in the input anymore\n", relationNumbers[i]);
+            continue;
+        }
+        placements.push_back({ dancerIndices[i], classIndices[entries[2 * i + 1]] });
+    }
+
+    Print("Loaded existing solution from: %s\n", snapshotPath.string().c_str());
+    return true;
+}
+
+std::vector<int> FindDancersByRelationNumber(const std::vector<Studancer>& dancers, const std::vector<int>& relationNumbers)
+{
+    std::vector<std::pair<int, int>> sortedDancers(dancers.size());
+    for (int i = 0; i < dancers.size(); i++)
+    {
+        sortedDancers[i] = { dancers[i].relationNumber, i };
+    }
+    std::sort(sortedDancers.begin(), sortedDancers.end());
+
+    std::vector<int> indices(relationNumbers.size());
+    for (int i = 0; i < relationNumbers.size(); i++)
+    {
+        auto it = std::lower_bound(sortedDancers.begin(), sortedDancers.end(), std::make_pair(relationNumbers[i], -1));
+        indices[i] = it != sortedDancers.end() && it->first == relationNumbers[i] ? it->second : -1;
+    }
+    return indices;
+}
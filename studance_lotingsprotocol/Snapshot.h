@@ -0,0 +1,31 @@
+#pragma once
+#include "Assignment.h"
+#include "Utils.h"
+#include <cstdint>
+
+// A single dancer placed in a class, as indices into the loaded dancers and classes
+struct AssignmentPlacement
+{
+    int dancer;
+    int danceClass;
+};
+
+// Content hash of an exported file, carriage returns are skipped so line endings written in text mode do not matter
+uint64_t HashExportContent(const char* data, size_t size);
+
+// Hash of the classes, dancers and board files in the input folder, a snapshot made from other input is not used
+uint64_t HashInputFiles();
+
+// Path of the snapshot that belongs to an exported file
+fs::path GetSnapshotPath(const fs::path& exportPath);
+
+// Writes the class names and the class of every placed dancer next to an export, together with the hash of that export and of the input
+void WriteAssignmentSnapshot(const Assignment& assignment, const fs::path& exportPath, uint64_t exportHash);
+
+// Loads the placements from the snapshot of an export, a copy named <export>_updatable uses the snapshot of <export>
+// Returns false when there is no snapshot, or when it does not match the export, the input files or the classes anymore
+bool LoadAssignmentSnapshot(const fs::path& exportPath, const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes,
+                            std::vector<AssignmentPlacement>& placements);
+
+// Finds the index of every relation number in dancers, -1 when the dancer is not in the input anymore
+std::vector<int> FindDancersByRelationNumber(const std::vector<Studancer>& dancers, const std::vector<int>& relationNumbers);
@@ -0,0 +1,167 @@
+#include "SolverArena.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+// Transparent huge pages are only used for mappings aligned to their size
+const size_t hugePageSize = 2 * 1024 * 1024;
+
+size_t AlignToCacheLine(size_t numBytes)
+{
+    return (numBytes + cacheLineSize - 1) & ~(cacheLineSize - 1);
+}
+
+inline size_t AlignTo(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+SolverArena::SolverArena(bool hugePages)
+    : data(nullptr), capacity(0), used(0), touched(0), hugePages(hugePages)
+{
+}
+
+SolverArena::~SolverArena()
+{
+    Release();
+}
+
+void SolverArena::Reserve(size_t numBytes)
+{
+    if (numBytes <= capacity)
+    {
+        return;
+    }
+
+    if (used != 0)
+    {
+        printf("ERROR: solver arena grown while %zu bytes are still in use\n", used);
+        exit(-1);
+    }
+
+    Release();
+
+    size_t mappingSize = AlignTo(numBytes, hugePages ? hugePageSize : 4096);
+
+#ifdef _WIN32
+    // Large pages need the lock pages privilege on Windows, so hugePages is ignored there
+    // Committed pages are zero, like an anonymous mapping
+    data = (char*)VirtualAlloc(nullptr, mappingSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (data == nullptr)
+    {
+        printf("ERROR: could not allocate %zu bytes for the solver\n", mappingSize);
+        exit(-1);
+    }
+#else
+    // Map an extra huge page so the start can be moved to a huge page boundary
+    size_t paddedSize = hugePages ? mappingSize + hugePageSize : mappingSize;
+    void* mapping = mmap(nullptr, paddedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED)
+    {
+        printf("ERROR: could not map %zu bytes for the solver\n", paddedSize);
+        exit(-1);
+    }
+
+    data = (char*)mapping;
+    if (hugePages)
+    {
+        data = (char*)AlignTo((size_t)(uintptr_t)mapping, hugePageSize);
+        size_t head = data - (char*)mapping;
+        size_t tail = paddedSize - head - mappingSize;
+        if (head > 0)
+        {
+            munmap(mapping, head);
+        }
+        if (tail > 0)
+        {
+            munmap(data + mappingSize, tail);
+        }
+
+#ifdef MADV_HUGEPAGE
+        // Only a hint, the kernel falls back to normal pages when huge pages are disabled
+        madvise(data, mappingSize, MADV_HUGEPAGE);
+#endif
+    }
+#endif
+
+    capacity = mappingSize;
+    used = 0;
+    touched = 0;
+}
+
+void* SolverArena::Allocate(size_t numBytes)
+{
+    size_t size = AlignToCacheLine(numBytes);
+    if (size > capacity - used)
+    {
+        printf("ERROR: solver arena of %zu bytes cannot fit another %zu bytes\n", capacity, size);
+        exit(-1);
+    }
+
+    char* memory = data + used;
+    used += size;
+    touched = std::max(touched, used);
+    return memory;
+}
+
+void* SolverArena::AllocateZeroed(size_t numBytes)
+{
+    size_t start = used;
+    size_t previouslyTouched = touched;
+    char* memory = (char*)Allocate(numBytes);
+
+    // Only clear what an earlier solve wrote to, the rest of the mapping is still zero
+    if (start < previouslyTouched)
+    {
+        memset(memory, 0, std::min(previouslyTouched, used) - start);
+    }
+    return memory;
+}
+
+void SolverArena::Reset()
+{
+    used = 0;
+}
+
+char* SolverArena::GetData() const
+{
+    return data;
+}
+
+size_t SolverArena::GetUsed() const
+{
+    return used;
+}
+
+size_t SolverArena::GetCapacity() const
+{
+    return capacity;
+}
+
+void SolverArena::Release()
+{
+    if (data == nullptr)
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    VirtualFree(data, 0, MEM_RELEASE);
+#else
+    munmap(data, capacity);
+#endif
+
+    data = nullptr;
+    capacity = 0;
+    used = 0;
+    touched = 0;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+
+// Size of a cache line, every array handed out by the arena starts on its own line
+const size_t cacheLineSize = 64;
+
+// Rounds numBytes up to a whole number of cache lines
+size_t AlignToCacheLine(size_t numBytes);
+
+// One memory mapping the arrays of a solver are carved out of
+// Reset() keeps the mapping, so the next solve reuses pages that were already faulted in
+class SolverArena
+{
+public:
+    // hugePages asks the OS to back the mapping with transparent huge pages where it supports them
+    explicit SolverArena(bool hugePages = false);
+    ~SolverArena();
+
+    SolverArena(const SolverArena&) = delete;
+    SolverArena& operator=(const SolverArena&) = delete;
+
+    // Makes sure the mapping holds at least numBytes
+    // A mapping that is too small is replaced, which is only allowed while nothing is handed out
+    void Reserve(size_t numBytes);
+
+    // Hands out numBytes starting on a cache line, the contents are undefined
+    void* Allocate(size_t numBytes);
+
+    // Hands out numBytes starting on a cache line set to zero
+    // Memory that was never handed out since it was mapped is already zero and is not touched
+    void* AllocateZeroed(size_t numBytes);
+
+    template<typename T>
+    T* AllocateArray(size_t numElements, bool zeroed = true)
+    {
+        return (T*)(zeroed ? AllocateZeroed(numElements * sizeof(T)) : Allocate(numElements * sizeof(T)));
+    }
+
+    // Gives back everything that was handed out, the memory stays mapped
+    void Reset();
+
+    // Start of the mapping, number of bytes handed out and size of the mapping
+    char* GetData() const;
+    size_t GetUsed() const;
+    size_t GetCapacity() const;
+
+private:
+    void Release();
+
+    char* data;
+    size_t capacity;
+    size_t used;
+    size_t touched;     // bytes from the start that were handed out since mapping, everything after is still zero
+    bool hugePages;
+};
@@ -1,38 +1,170 @@
 #include "Statistics.h"
 #include "Utils.h"
+#include <algorithm>
 #include <fstream>
-#include <map>
+#include <cstring>
+#include <numeric>
 
-void PrintChoiceStats(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes)
+StatisticsInput PrepareStatistics(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes)
 {
-    // Create a table for all assignment groups, how many were first second and third choices
+    StatisticsInput input = {};
+
+    // Class indices sorted on name to find classes with a binary search, equal names keep the first class in front
+    std::vector<int> sortedClasses(classes.size());
+    std::iota(sortedClasses.begin(), sortedClasses.end(), 0);
+    std::sort(sortedClasses.begin(), sortedClasses.end(), [&](int a, int b) {
+        int compare = classes[a].name.compare(classes[b].name);
+        return compare < 0 || (compare == 0 && a < b);
+    });
+
+    auto findClass = [&](const std::string& name) {
+        auto found = std::lower_bound(sortedClasses.begin(), sortedClasses.end(), name, [&](int i, const std::string& value) {
+            return classes[i].name < value;
+        });
+        return found != sortedClasses.end() && classes[*found].name == name ? *found : -2;
+    };
+
+    input.unenrolledClass = std::max(-1, findClass("unenrolled"));
+    input.classNames.resize(classes.size());
+    input.classId.resize(classes.size());
+    for (int i = 0; i < classes.size(); i++)
+    {
+        input.classNames[i] = classes[i].name;
+        input.classId[i] = findClass(classes[i].name);
+    }
 
-    const int numClasses = (int)classes.size();
-    const int numClassBuckets = (int)classes.size() * 3;
-    int* classBuckets = new int[numClassBuckets];
-    std::map<std::string, int> classMap;
+    input.choices.resize(dancers.size());
+    input.priorityGroup.resize(dancers.size());
+    input.firstAdvice.resize(dancers.size());
+    input.firstChoiceAdvised.resize(dancers.size());
+    for (int d = 0; d < dancers.size(); d++)
+    {
+        const Studancer& dancer = dancers[d];
+        for (int i = 0; i < 4; i++)
+        {
+            if (i >= dancer.chosenClasses.size())
+            {
+                input.choices[d][i] = -2;
+            }
+            else
+            {
+                // empty and unknown choices never match a class
+                input.choices[d][i] = dancer.chosenClasses[i] == "" ? -1 : std::max(-1, findClass(dancer.chosenClasses[i]));
+            }
+        }
 
-    for (int i = 0; i < classes.size(); i++)
+        input.priorityGroup[d] = dancer.priorityGroup;
+
+        bool hasAdvice = dancer.advisedClasses.size() > 0 && dancer.advisedClasses[0] != "";
+        input.firstAdvice[d] = hasAdvice ? findClass(dancer.advisedClasses[0]) : -1;
+        input.firstChoiceAdvised[d] = dancer.chosenClasses.size() > 0 &&
+            std::find(dancer.advisedClasses.begin(), dancer.advisedClasses.end(), dancer.chosenClasses[0]) != dancer.advisedClasses.end();
+    }
+
+    return input;
+}
+
+void ClearAssignmentStatistics(AssignmentStatistics& statistics, int numClasses)
+{
+    statistics.runs = 0;
+    memset(statistics.groupChoices, 0, sizeof(statistics.groupChoices));
+    statistics.classChoices.assign(numClasses, { 0, 0, 0, 0 });
+    statistics.advised = 0;
+    statistics.totalAdvised = 0;
+    statistics.unenrolled = 0;
+}
+
+void CountPlacement(AssignmentStatistics& statistics, const StatisticsInput& input, int dancer, int classIndex)
+{
+    const int classId = input.classId[classIndex];
+    const std::array<int, 4>& choices = input.choices[dancer];
+    const int priorityGroup = input.priorityGroup[dancer];
+    const bool existingMember = priorityGroup == ExistingMember;
+
+    for (int i = 0; i < 4 && choices[i] != -2; i++)
+    {
+        if (choices[i] == classId)
+        {
+            if (existingMember && i == 0 && input.firstAdvice[dancer] == classId)
+            {
+                statistics.advised++;
+                statistics.totalAdvised++;
+            }
+
+            statistics.groupChoices[priorityGroup][i]++;
+
+            if (classId != input.unenrolledClass)
+            {
+                statistics.classChoices[classIndex][i]++;
+                if (i == 0 && input.firstChoiceAdvised[dancer])
+                {
+                    statistics.classChoices[classIndex][3]++;
+                }
+            }
+            else
+            {
+                statistics.unenrolled++;
+            }
+        }
+        else if (existingMember && i == 0 && input.firstAdvice[dancer] != -1)
+        {
+            statistics.totalAdvised++;
+        }
+    }
+}
+
+void CountAssignment(AssignmentStatistics& statistics, const StatisticsInput& input, const Assignment& assignment)
+{
+    for (int classIndex = 0; classIndex < assignment.size(); classIndex++)
     {
-        classMap.insert({ classes[i].name, i });
+        for (auto& dancer : assignment[classIndex].second)
+        {
+            if (dancer.index < 0 || dancer.index >= input.choices.size())
+            {
+                printf("ERROR: dancer %i in the assignment is not one of the loaded dancers\n", dancer.relationNumber);
+                exit(-1);
+            }
+            CountPlacement(statistics, input, dancer.index, classIndex);
+        }
     }
+    statistics.runs++;
+}
 
-    for (int i = 0; i < numClassBuckets; i++)
+void MergeAssignmentStatistics(AssignmentStatistics& statistics, const AssignmentStatistics& other)
+{
+    statistics.runs += other.runs;
+    for (int group = 0; group < DancerPriorityGroup::Count; group++)
     {
-        classBuckets[i] = 0;
+        for (int rank = 0; rank < 4; rank++)
+        {
+            statistics.groupChoices[group][rank] += other.groupChoices[group][rank];
+        }
     }
-    int classIndex;
-    for (auto& dancer : dancers)
+    for (int i = 0; i < statistics.classChoices.size(); i++)
     {
-        int choiceIndex = 0;
-        for (auto& choice : dancer.chosenClasses)
+        for (int rank = 0; rank < 4; rank++)
         {
-            if (classMap.find(choice) != classMap.end())
+            statistics.classChoices[i][rank] += other.classChoices[i][rank];
+        }
+    }
+    statistics.advised += other.advised;
+    statistics.totalAdvised += other.totalAdvised;
+    statistics.unenrolled += other.unenrolled;
+}
+
+void PrintChoiceStats(const StatisticsInput& input, const std::vector<DanceClass>& classes)
+{
+    // Create a table for all assignment groups, how many were first second and third choices
+
+    std::vector<std::array<int, 3>> classBuckets(classes.size(), { 0, 0, 0 });
+    for (auto& choices : input.choices)
+    {
+        for (int choiceIndex = 0; choiceIndex < 3; choiceIndex++)
+        {
+            if (choices[choiceIndex] >= 0)
             {
-                classIndex = classMap[choice];
-                classBuckets[classIndex * 3 + choiceIndex]++;
+                classBuckets[choices[choiceIndex]][choiceIndex]++;
             }
-            choiceIndex++;
         }
     }
 
@@ -58,12 +190,12 @@ void PrintChoiceStats(const std::vector<Studancer>& dancers, const std::vector<D
         headerRow += "=";
     }
 
-    printf("Choice Statistics:\n\n");
-    printf("%s============================================================\n", headerRow.c_str());
-    printf("%s| Total ||    1st choice ||    2nd choice ||    3rd choice |\n", classNameColumn.c_str());
-    printf("%s============================================================\n", headerRow.c_str());
+    Print("Choice Statistics:\n\n");
+    Print("%s============================================================\n", headerRow.c_str());
+    Print("%s| Total ||    1st choice ||    2nd choice ||    3rd choice |\n", classNameColumn.c_str());
+    Print("%s============================================================\n", headerRow.c_str());
 
-    classIndex = 0;
+    int classIndex = 0;
     for (auto& danceClass : classes)
     {
         std::string className = danceClass.name;
@@ -73,102 +205,39 @@ void PrintChoiceStats(const std::vector<Studancer>& dancers, const std::vector<D
             continue;
         }
 
-        printf("| %s", className.c_str());
+        Print("| %s", className.c_str());
 
         for (int space = 0; space < longestClassName - className.length(); space++)
         {
-            printf(" ");
+            Print(" ");
         }
-        printf("|");
+        Print("|");
 
-        int total = classBuckets[classIndex * 3 + 0] + classBuckets[classIndex * 3 + 1] + classBuckets[classIndex * 3 + 2];
+        int total = classBuckets[classIndex][0] + classBuckets[classIndex][1] + classBuckets[classIndex][2];
         if (total == 0)
         {
-            printf("|     0 ||             0 ||             0 ||             0 |\n");
+            Print("|     0 ||             0 ||             0 ||             0 |\n");
         }
         else
         {
             std::string totalSpacing = total >= 100 ? "  " : total >= 10 ? "   " : "    ";
-            printf("| %s%i |", totalSpacing.c_str(), total);
-
-            float percentages[3] = {
-                ((float)classBuckets[classIndex * 3 + 0] / (float)total) * 100.f,
-                ((float)classBuckets[classIndex * 3 + 1] / (float)total) * 100.f,
-                ((float)classBuckets[classIndex * 3 + 2] / (float)total) * 100.f
-            };
+            Print("| %s%i |", totalSpacing.c_str(), total);
 
-            int bucketIndex = 0;
             for (int bucket = 0; bucket < 3; bucket++)
             {
-                int v = classBuckets[classIndex * 3 + bucket];
+                int v = classBuckets[classIndex][bucket];
                 std::string numberSpacing = v >= 100 ? "" : v >= 10 ? " " : "  ";
-                printf("|           %s%i |", numberSpacing.c_str(), v);
-                bucketIndex++;
+                Print("|           %s%i |", numberSpacing.c_str(), v);
             }
-            printf("\n");
+            Print("\n");
         }
         classIndex++;
     }
-    printf("%s============================================================\n\n", headerRow.c_str());
+    Print("%s============================================================\n\n", headerRow.c_str());
 }
 
-void PrintAssignmentStats(const Assignment& assignment)
+void PrintAssignmentStats(const AssignmentStatistics& statistics, const StatisticsInput& input)
 {
-    // count of number of first, second and third choices for dancer prio groups
-    // and classes
-    int buckets[DancerPriorityGroup::Count][4] = {};
-
-    const int numClasses = (int)assignment.size();
-    const int numClassBuckets = (int)assignment.size() * 5;
-    int* classBuckets = new int[numClassBuckets];
-    for (int i = 0; i < numClassBuckets; i++)
-    {
-        classBuckets[i] = 0;
-    }
-    int advisedBucket = 0;
-    int totalAdvises = 0;
-    int classIndex = 0;
-    int unenrolled = 0;
-    for (auto& classAssignment : assignment)
-    {
-        for (auto& dancer : classAssignment.second)
-        {
-            for (int i = 0; i < 4 && i < dancer.chosenClasses.size(); i++)
-            {
-                std::string dancerAdvise = dancer.advisedClasses.size() > 0 ? dancer.advisedClasses[0] : "";
-                if (dancer.chosenClasses[i] == classAssignment.first.name)
-                {
-                    if (dancer.priorityGroup == ExistingMember && i == 0 && dancerAdvise == classAssignment.first.name)
-                    {
-                        advisedBucket++;
-                        totalAdvises++;
-                    }
-
-                    buckets[(int)dancer.priorityGroup][i]++;
-
-
-                    if (classAssignment.first.name != "unenrolled")
-                    {
-                        classBuckets[classIndex * 4 + i]++;
-                        if (i == 0 && contains(dancer.advisedClasses, classAssignment.first.name))
-                        {
-                            classBuckets[classIndex * 4 + 3]++;
-                        }
-                    }
-                    else
-                    {
-                        unenrolled++;
-                    }
-                }
-                else if (dancer.priorityGroup == ExistingMember && i == 0 && dancerAdvise != "")
-                {
-                    totalAdvises++;
-                }
-            }
-        }
-        classIndex++;
-    }
-
     {
         // Create a table for all assignment groups, how many were first second and third choices
         const int longestPriorityGroupName = (int)strlen("NonDancerLastYear") + 1;
@@ -183,67 +252,59 @@ void PrintAssignmentStats(const Assignment& assignment)
         {
             headerRow += "=";
         }
-        printf("Assignment Statistics:\n\n");
-        printf("%s====================================================================\n", headerRow.c_str());
-        printf("%s|    1st choice ||    2nd choice ||    3rd choice ||    unenrolled |\n", groupName.c_str());
-        printf("%s====================================================================\n", headerRow.c_str());
+        Print("Assignment Statistics:\n\n");
+        Print("%s====================================================================\n", headerRow.c_str());
+        Print("%s|    1st choice ||    2nd choice ||    3rd choice ||    unenrolled |\n", groupName.c_str());
+        Print("%s====================================================================\n", headerRow.c_str());
 
         for (int i = 0; i < (int)DancerPriorityGroup::Count - 1; i++)
         {
             DancerPriorityGroup group = (DancerPriorityGroup)i;
             std::string priorityGroupName = DancerPriorityGroupToString(group);
-            printf("| %s", priorityGroupName.c_str());
+            Print("| %s", priorityGroupName.c_str());
 
             for (int space = 0; space < longestPriorityGroupName - priorityGroupName.length(); space++)
             {
-                printf(" ");
+                Print(" ");
             }
-            printf("|");
+            Print("|");
 
-            int total = buckets[i][0] + buckets[i][1] + buckets[i][2] + buckets[i][3];
+            const int64_t* buckets = statistics.groupChoices[i];
+            int64_t total = buckets[0] + buckets[1] + buckets[2] + buckets[3];
             if (total == 0)
             {
-                printf("|   0 (  0.00%%) ||   0 (  0.00%%) ||   0 (  0.00%%) ||   0 (  0.00%%) |");
+                Print("|   0 (  0.00%%) ||   0 (  0.00%%) ||   0 (  0.00%%) ||   0 (  0.00%%) |");
             }
             else
             {
-                float percentages[4] = {
-                    ((float)buckets[i][0] / (float)total) * 100.f,
-                    ((float)buckets[i][1] / (float)total) * 100.f,
-                    ((float)buckets[i][2] / (float)total) * 100.f,
-                    ((float)buckets[i][3] / (float)total) * 100.f,
-                };
-
-                int bucketIndex = 0;
                 for (int bucket = 0; bucket < 4; bucket++)
                 {
-                    float p = percentages[bucket];
-                    int v = buckets[i][bucket];
+                    float p = ((float)buckets[bucket] / (float)total) * 100.f;
+                    int64_t v = buckets[bucket];
                     std::string percentageSpacing = p == 100.0f ? "" : p >= 10.0f ? " " : "  ";
                     std::string numberSpacing = v >= 100 ? "" : v >= 10 ? " " : "  ";
-                    printf("| %s%i (%s%.2f%%) |", numberSpacing.c_str(), v, percentageSpacing.c_str(), p);
-                    bucketIndex++;
+                    Print("| %s%lli (%s%.2f%%) |", numberSpacing.c_str(), (long long)v, percentageSpacing.c_str(), p);
                 }
             }
 
             if (group == ExistingMember)
             {
-                float advisedPercent = ((float)advisedBucket / (float)totalAdvises) * 100.0f;
-                printf(" Advised: %i/%i (%.2f%%)", advisedBucket, totalAdvises, advisedPercent);
+                float advisedPercent = ((float)statistics.advised / (float)statistics.totalAdvised) * 100.0f;
+                Print(" Advised: %lli/%lli (%.2f%%)", (long long)statistics.advised, (long long)statistics.totalAdvised, advisedPercent);
             }
 
-            printf("\n");
+            Print("\n");
         }
-        printf("%s====================================================================\n\n\n", headerRow.c_str());
+        Print("%s====================================================================\n\n\n", headerRow.c_str());
     }
 
     {
         int longestClassName = 0;
-        for (auto& classAssignment : assignment)
+        for (auto& className : input.classNames)
         {
-            if (classAssignment.first.name.length() > longestClassName)
+            if (className.length() > longestClassName)
             {
-                longestClassName = (int)classAssignment.first.name.length();
+                longestClassName = (int)className.length();
             }
         }
         longestClassName++;
@@ -260,64 +321,156 @@ void PrintAssignmentStats(const Assignment& assignment)
             headerRow += "=";
         }
 
-        printf("Class Statistics:\n\n");
-        printf("%s============================================================\n", headerRow.c_str());
-        printf("%s| Total ||    1st choice ||    2nd choice ||    3rd choice |\n", classNameColumn.c_str());
-        printf("%s============================================================\n", headerRow.c_str());
-        classIndex = 0;
-        for (auto& classAssignment : assignment)
+        Print("Class Statistics:\n\n");
+        Print("%s============================================================\n", headerRow.c_str());
+        Print("%s| Total ||    1st choice ||    2nd choice ||    3rd choice |\n", classNameColumn.c_str());
+        Print("%s============================================================\n", headerRow.c_str());
+        for (int classIndex = 0; classIndex < input.classNames.size(); classIndex++)
         {
-            std::string className = classAssignment.first.name;
+            const std::string& className = input.classNames[classIndex];
             if (className == "unenrolled")
             {
-                classIndex++;
                 continue;
             }
 
-            printf("| %s", className.c_str());
+            Print("| %s", className.c_str());
 
             for (int space = 0; space < longestClassName - className.length(); space++)
             {
-                printf(" ");
+                Print(" ");
             }
-            printf("|");
+            Print("|");
 
-            int total = classBuckets[classIndex * 4 + 0] + classBuckets[classIndex * 4 + 1] + classBuckets[classIndex * 4 + 2];
+            const std::array<int64_t, 4>& buckets = statistics.classChoices[classIndex];
+            int64_t total = buckets[0] + buckets[1] + buckets[2];
             if (total == 0)
             {
-                printf("|     0 ||   0 (  0.00%%) ||   0 (  0.00%%) ||   0 (  0.00%%) |\n");
+                Print("|     0 ||   0 (  0.00%%) ||   0 (  0.00%%) ||   0 (  0.00%%) |\n");
             }
             else
             {
                 std::string totalSpacing = total >= 100 ? "  " : total >= 10 ? "   " : "    ";
-                printf("| %s%i |", totalSpacing.c_str(), total);
+                Print("| %s%lli |", totalSpacing.c_str(), (long long)total);
 
-                float percentages[3] = {
-                    ((float)classBuckets[classIndex * 4 + 0] / (float)total) * 100.f,
-                    ((float)classBuckets[classIndex * 4 + 1] / (float)total) * 100.f,
-                    ((float)classBuckets[classIndex * 4 + 2] / (float)total) * 100.f
-                };
-
-                int bucketIndex = 0;
                 for (int bucket = 0; bucket < 3; bucket++)
                 {
-                    float p = percentages[bucket];
-                    int v = classBuckets[classIndex * 4 + bucket];
+                    float p = ((float)buckets[bucket] / (float)total) * 100.f;
+                    int64_t v = buckets[bucket];
                     std::string percentageSpacing = p == 100.0f ? "" : p >= 10.0f ? " " : "  ";
                     std::string numberSpacing = v >= 100 ? "" : v >= 10 ? " " : "  ";
-                    printf("| %s%i (%s%.2f%%) |", numberSpacing.c_str(), v, percentageSpacing.c_str(), p);
-                    bucketIndex++;
+                    Print("| %s%lli (%s%.2f%%) |", numberSpacing.c_str(), (long long)v, percentageSpacing.c_str(), p);
                 }
 
-                printf(" Advised: %i", classBuckets[classIndex * 4 + 3]);
-                printf("\n");
+                Print(" Advised: %lli", (long long)buckets[3]);
+                Print("\n");
             }
-            classIndex++;
         }
-        printf("%s============================================================\n\n", headerRow.c_str());
+        Print("%s============================================================\n\n", headerRow.c_str());
 
-        printf("unenrolled members: %i\n\n", unenrolled);
+        Print("unenrolled members: %lli\n\n", (long long)statistics.unenrolled);
     }
+}
 
-    delete[] classBuckets;
-}
\ No newline at end of file
+void PrintAssignmentStats(const Assignment& assignment, const StatisticsInput& input)
+{
+    AssignmentStatistics statistics;
+    ClearAssignmentStatistics(statistics, (int)input.classNames.size());
+    CountAssignment(statistics, input, assignment);
+
+    PrintAssignmentStats(statistics, input);
+}
+
+// Writes a string as a quoted JSON string
+std::string ToJsonString(const std::string& value)
+{
+    std::string output = "\"";
+    for (char c : value)
+    {
+        if (c == '"' || c == '\\')
+        {
+            output += '\\';
+        }
+        output += c;
+    }
+    output += "\"";
+    return output;
+}
+
+void ExportAssignmentStats(const AssignmentStatistics& statistics, const StatisticsInput& input, const std::string& outputName)
+{
+    char line[512];
+
+    // JSON
+    {
+        auto outputPath = GetOutputFolder() / (outputName + ".json");
+        std::ofstream outputFile(outputPath);
+
+        outputFile << "{\n";
+        outputFile << "  \"runs\": " << statistics.runs << ",\n";
+        outputFile << "  \"advised\": " << statistics.advised << ",\n";
+        outputFile << "  \"total_advised\": " << statistics.totalAdvised << ",\n";
+        outputFile << "  \"unenrolled\": " << statistics.unenrolled << ",\n";
+
+        outputFile << "  \"groups\": [\n";
+        for (int i = 0; i < (int)DancerPriorityGroup::Count; i++)
+        {
+            const int64_t* buckets = statistics.groupChoices[i];
+            snprintf(line, sizeof(line), "    { \"name\": %s, \"choices\": [%lli, %lli, %lli, %lli] }%s\n",
+                ToJsonString(DancerPriorityGroupToString((DancerPriorityGroup)i)).c_str(),
+                (long long)buckets[0], (long long)buckets[1], (long long)buckets[2], (long long)buckets[3],
+                i + 1 < (int)DancerPriorityGroup::Count ? "," : "");
+            outputFile << line;
+        }
+        outputFile << "  ],\n";
+
+        outputFile << "  \"classes\": [\n";
+        for (int i = 0; i < input.classNames.size(); i++)
+        {
+            const std::array<int64_t, 4>& buckets = statistics.classChoices[i];
+            outputFile << "    { \"name\": " << ToJsonString(input.classNames[i]);
+            snprintf(line, sizeof(line), ", \"choices\": [%lli, %lli, %lli], \"advised\": %lli }%s\n",
+                (long long)buckets[0], (long long)buckets[1], (long long)buckets[2], (long long)buckets[3],
+                i + 1 < input.classNames.size() ? "," : "");
+            outputFile << line;
+        }
+        outputFile << "  ]\n";
+        outputFile << "}\n";
+
+        outputFile.close();
+        Print("Exported to: %s\n", outputPath.string().c_str());
+    }
+
+    // CSV
+    {
+        auto outputPath = GetOutputFolder() / (outputName + ".csv");
+        std::ofstream outputFile(outputPath);
+
+        outputFile << "Priority group,1st choice,2nd choice,3rd choice,unenrolled\n";
+        for (int i = 0; i < (int)DancerPriorityGroup::Count; i++)
+        {
+            const int64_t* buckets = statistics.groupChoices[i];
+            snprintf(line, sizeof(line), "%s,%lli,%lli,%lli,%lli\n", DancerPriorityGroupToString((DancerPriorityGroup)i).c_str(),
+                (long long)buckets[0], (long long)buckets[1], (long long)buckets[2], (long long)buckets[3]);
+            outputFile << line;
+        }
+        outputFile << "\n\n";
+
+        outputFile << "Class,1st choice,2nd choice,3rd choice,Advised\n";
+        for (int i = 0; i < input.classNames.size(); i++)
+        {
+            const std::array<int64_t, 4>& buckets = statistics.classChoices[i];
+            snprintf(line, sizeof(line), ",%lli,%lli,%lli,%lli\n",
+                (long long)buckets[0], (long long)buckets[1], (long long)buckets[2], (long long)buckets[3]);
+            outputFile << input.classNames[i] << line;
+        }
+        outputFile << "\n\n";
+
+        outputFile << "Runs,Advised,Total advised,Unenrolled\n";
+        snprintf(line, sizeof(line), "%lli,%lli,%lli,%lli\n", (long long)statistics.runs, (long long)statistics.advised,
+            (long long)statistics.totalAdvised, (long long)statistics.unenrolled);
+        outputFile << line;
+
+        outputFile.close();
+        Print("Exported to: %s\n\n", outputPath.string().c_str());
+    }
+}
@@ -1,6 +1,57 @@
 #pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
 #include "Assignment.h"
 
-void PrintAssignmentStats(const Assignment& assignment);
+// The dancers and classes translated to integer ids once, so assignments can be counted without comparing names
+struct StatisticsInput
+{
+    std::vector<std::string> classNames;        // per class index
+    std::vector<int> classId;                   // class index -> id, classes with the same name share the id of the first one
+    int unenrolledClass;                        // id of the unenrolled class, -1 when there is none
+    std::vector<std::array<int, 4>> choices;    // per dancer the class id of every choice, -1 for an empty choice, -2 when there is no choice
+    std::vector<int> priorityGroup;             // per dancer
+    std::vector<int> firstAdvice;               // per dancer the class id of the first advised class, -1 when there is none, -2 when it is no class
+    std::vector<char> firstChoiceAdvised;       // per dancer, the first choice is one of the advised classes
+};
 
-void PrintChoiceStats(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes);
\ No newline at end of file
+// Histograms of one or more assignments, merge them to aggregate over many runs
+// Ranks 0-2 are the 1st-3rd choice, rank 3 is the 4th (unenrolled) choice
+struct AssignmentStatistics
+{
+    int64_t runs;
+    int64_t groupChoices[DancerPriorityGroup::Count][4];    // placements per priority group and rank
+    std::vector<std::array<int64_t, 4>> classChoices;       // per class index placements on rank 0-2, followed by the advised placements
+    int64_t advised;                                        // ExistingMembers placed in their first advised class
+    int64_t totalAdvised;                                   // placements of ExistingMembers that got an advice
+    int64_t unenrolled;                                     // placements in the unenrolled class
+};
+
+// Translates the dancers and classes, once per run, every stage and thread shares the result
+StatisticsInput PrepareStatistics(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes);
+
+void ClearAssignmentStatistics(AssignmentStatistics& statistics, int numClasses);
+
+// Counts a single dancer (index in the dancers vector) placed in a class (index in the classes vector)
+void CountPlacement(AssignmentStatistics& statistics, const StatisticsInput& input, int dancer, int classIndex);
+
+// Counts every placement of the assignment as one run, the dancers are found through their index
+void CountAssignment(AssignmentStatistics& statistics, const StatisticsInput& input, const Assignment& assignment);
+
+// Adds the counts of other to statistics, both must have been cleared for the same classes
+void MergeAssignmentStatistics(AssignmentStatistics& statistics, const AssignmentStatistics& other);
+
+void PrintAssignmentStats(const AssignmentStatistics& statistics, const StatisticsInput& input);
+
+// Counts and prints the statistics of a single assignment
+void PrintAssignmentStats(const Assignment& assignment, const StatisticsInput& input);
+
+// Writes the histograms to <outputName>.json and <outputName>.csv in the output folder
+void ExportAssignmentStats(const AssignmentStatistics& statistics, const StatisticsInput& input, const std::string& outputName);
+
+// Writes a string as a quoted JSON string
+std::string ToJsonString(const std::string& value);
+
+void PrintChoiceStats(const StatisticsInput& input, const std::vector<DanceClass>& classes);
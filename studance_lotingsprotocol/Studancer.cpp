@@ -5,6 +5,7 @@
 #include <sstream>
 #include <map>
 #include <random>
+#include <algorithm>
 
 std::vector<std::string> DancerFileNames()
 {
@@ -44,6 +45,22 @@ std::string GetDancersInputHeader()
     return inputHeader;
 }
 
+int inputHeaderSplit = 0;
+int GetDancersInputHeaderSplit()
+{
+    return inputHeaderSplit;
+}
+
+int inputHeaderColumns = 0;
+int GetDancersInputHeaderColumns()
+{
+    return inputHeaderColumns;
+}
+
+// Relation numbers of the board members in Board.txt
+std::vector<int> kbBoardMembers;
+std::vector<int> hbBoardMembers;
+
 // If we want to be able to parse the indices at a different location
 std::map<std::string, int> inputHeaderMap;
 std::map<std::string, int> GetDancersInputHeaderMap()
@@ -51,6 +68,240 @@ std::map<std::string, int> GetDancersInputHeaderMap()
     return inputHeaderMap;
 }
 
+// Reports a row that cannot be parsed, aborts when the caller does not want the error back
+bool DancerRowError(std::string* error, const std::string& message)
+{
+    if (error == nullptr)
+    {
+        printf("ERROR: %s\n", message.c_str());
+        printf("Aborting...\n");
+        exit(-1);
+    }
+
+    *error = message;
+    return false;
+}
+
+// Parses a single row of the dancers file with the header and board members of the last LoadDancers()
+bool ParseDancerRow(const std::string& line, const std::vector<std::string>& classNames, Studancer& dancer, std::string* error)
+{
+    const int numIndices = inputHeaderColumns;
+    std::vector<std::string> indices(numIndices);
+
+    dancer = {};
+
+    int offset = 0;
+    for (int i = 0; i < numIndices; i++)
+    {
+        indices[i] = ParseTillNextComma(line, offset);
+        if (i == 0)
+        {
+            dancer.tableRowSplit = std::min(offset, (int)line.length());
+        }
+    }
+
+    // Store the input row for export
+    dancer.tableRow = line;
+
+    std::string relationNumber = indices[inputHeaderMap["relatienummer"]];
+    trim(relationNumber);
+    if (relationNumber.empty() || relationNumber.find_first_not_of("0123456789") != std::string::npos)
+    {
+        return DancerRowError(error, "Relation number " + relationNumber + " is not a number");
+    }
+    dancer.relationNumber = std::stoi(relationNumber);
+
+    std::string studentStatus = indices[inputHeaderMap["studentstatus"]];
+    trim(studentStatus);
+    tolower(studentStatus);
+    bool isStudent = studentStatus == "student";
+    bool hasGapYear = studentStatus == "tussenjaar";
+
+    std::string wasAMember = indices[inputHeaderMap["ben je al lid van studance"]];
+    trim(wasAMember);
+    tolower(wasAMember);
+    bool isNewMember = wasAMember == "nee";
+    bool wasUnenrolledLastYear = wasAMember == "nee, ik stond eind vorig dansseizoen nog op de wachtlijst" ||
+                                 wasAMember == "nee, ik ben vorig seizoen uitgeloot";
+    bool wasNonDancingMember = wasAMember == "ja, ik ben niet-dansend lid";
+
+    std::string gender = indices[inputHeaderMap["gender"]];
+    trim(gender);
+    tolower(gender);
+    bool isNonFemale = gender != "vrouw";
+
+    // Choices need to be cleaned
+    std::stringstream firstChoiceUnparsed(indices[inputHeaderMap["1e keuze"]]);
+    std::string firstChoice;
+    std::getline(firstChoiceUnparsed, firstChoice, '(');
+    trim(firstChoice);
+    tolower(firstChoice);
+
+    std::stringstream secondChoiceUnparsed(indices[inputHeaderMap["2e keuze"]]);
+    std::string secondChoice;
+    std::getline(secondChoiceUnparsed, secondChoice, '(');
+    trim(secondChoice);
+    tolower(secondChoice);
+
+    std::stringstream thirdChoiceUnparsed(indices[inputHeaderMap["3e keuze"]]);
+    std::string thirdChoice;
+    std::getline(thirdChoiceUnparsed, thirdChoice, '(');
+    trim(thirdChoice);
+    tolower(thirdChoice);
+
+    dancer.chosenClasses.push_back(firstChoice);
+
+    dancer.chosenClasses.push_back(secondChoice);
+
+    dancer.chosenClasses.push_back(thirdChoice);
+
+    dancer.chosenClasses.push_back("unenrolled");
+
+    // check and sanitize choices
+    for (int i = 0; i < dancer.chosenClasses.size(); i++)
+    {
+        // sanitize empty choices
+        if (dancer.chosenClasses[i] == "maak een keuze")
+        {
+            dancer.chosenClasses[i] = "";
+        }
+
+        // If we have the same choice as before, set it to empty
+        for (int j = 0; j < i; j++)
+        {
+            if (dancer.chosenClasses[i] == dancer.chosenClasses[j])
+            {
+                dancer.chosenClasses[i] = "";
+            }
+        }
+
+        // We do not need to check emtpy choices
+        if (dancer.chosenClasses[i] == "")
+        {
+            continue;
+        }
+
+        // Check if we have the chosen class in the list. Otherwise we have an input issue
+        if (!contains(classNames, dancer.chosenClasses[i]))
+        {
+            return DancerRowError(error, "Chosen class " + dancer.chosenClasses[i] + " for dancer " + relationNumber + " does not exist in the input classes file");
+        }
+    }
+
+    std::string advice = indices[inputHeaderMap["advies"]];
+    trim(advice);
+    tolower(advice);
+    if (advice != "ik was vorig jaar geen lid" && advice != "maak een keuze" && advice != "nee")
+    {
+        if (advice == "ja" && dancer.chosenClasses.size() > 0)
+        {
+            // binary advice
+            dancer.advisedClasses.push_back(dancer.chosenClasses[0]);
+        }
+        else
+        {
+            // advice list is separated by commas
+            std::stringstream advices(advice);
+            std::string currentAdvice;
+            while (std::getline(advices, currentAdvice, ','))
+            {
+                dancer.advisedClasses.push_back(currentAdvice);
+            }
+        }
+    }
+
+    // The flags only depend on the dancer, so the arc costs do not have to look through the advice again
+    for (const std::string& chosenClass : dancer.chosenClasses)
+    {
+        bool isAdvised = contains(dancer.advisedClasses, chosenClass);
+        dancer.choiceFlags.push_back((chosenClass == "unenrolled" ? UnenrolledClass : 0) | (isAdvised ? FollowsAdvice : 0));
+    }
+
+    std::string requestedMembership = indices[inputHeaderMap["lidmaatschap"]];
+    trim(requestedMembership);
+    tolower(requestedMembership);
+    bool halfYearMemberShip = requestedMembership == "halfjaarlijkslidmaatschap";
+
+    bool isKBBoard = contains(kbBoardMembers, dancer.relationNumber);
+    bool isHBBoard = contains(hbBoardMembers, dancer.relationNumber);
+
+    // Damn members pick damn as first choice
+    bool isDamn = firstChoice == "d.a.m.n.";
+
+    if (isKBBoard)
+    {
+        dancer.priorityGroup = KBBoard;
+    }
+    else if (isHBBoard)
+    {
+        dancer.priorityGroup = HBBoard;
+    }
+    else if (isDamn)
+    {
+        dancer.priorityGroup = Damn;
+    }
+    else if (hasGapYear)
+    {
+        if (halfYearMemberShip)
+        {
+            dancer.priorityGroup = HalfGapYear;
+        }
+        else
+        {
+            dancer.priorityGroup = GapYear;
+        }
+    }
+    else if (!isStudent)
+    {
+        if (halfYearMemberShip)
+        {
+            dancer.priorityGroup = HalfNonStudying;
+        }
+        else
+        {
+            dancer.priorityGroup = NonStudying;
+        }
+    }
+    else if (halfYearMemberShip)
+    {
+        dancer.priorityGroup = HalfYear;
+    }
+    else if (wasUnenrolledLastYear)
+    {
+        dancer.priorityGroup = UnrolledLastYear;
+    }
+    else if (wasNonDancingMember)
+    {
+        dancer.priorityGroup = NonDancerLastYear;
+    }
+    else if (!isNewMember)
+    {
+        dancer.priorityGroup = ExistingMember;
+    }
+    else if (isNonFemale)
+    {
+        dancer.priorityGroup = NonFemale;
+    }
+    else
+    {
+        dancer.priorityGroup = Female;
+    }
+
+    return true;
+}
+
+bool ParseDancer(const std::string& line, const std::vector<DanceClass>& classes, Studancer& dancer, std::string& error)
+{
+    std::vector<std::string> classNames;
+    classNames.reserve(classes.size());
+    for (auto& danceClass : classes)
+    {
+        classNames.push_back(danceClass.name);
+    }
+
+    return ParseDancerRow(line, classNames, dancer, &error);
+}
+
 // Load all dancers from an input file
 std::vector<Studancer> LoadDancers(const std::vector<DanceClass>& classes)
 {
@@ -82,8 +333,8 @@ std::vector<Studancer> LoadDancers(const std::vector<DanceClass>& classes)
     std::string line;
     std::ifstream boardFile(boardFilePath);
 
-    std::vector<int> kbBoardMembers;
-    std::vector<int> hbBoardMembers;
+    kbBoardMembers.clear();
+    hbBoardMembers.clear();
 
     // Load numbersx that correspond to board members
     while (std::getline(boardFile, line))
@@ -125,6 +376,9 @@ std::vector<Studancer> LoadDancers(const std::vector<DanceClass>& classes)
     // Get the header
     std::getline(dancersFile, inputHeader);
 
+    // The header may be indexed again when the dancers are reloaded
+    inputHeaderMap.clear();
+
     // Index the header
     int offset = 0;
     int index = 0;
@@ -137,6 +391,11 @@ std::vector<Studancer> LoadDancers(const std::vector<DanceClass>& classes)
         // remove symbols
         currentHeader.erase(currentHeader.find_last_not_of(" \n\r\t:?") + 1);
 
+        if (index == 0)
+        {
+            inputHeaderSplit = std::min(offset, (int)inputHeader.length());
+        }
+
         if (inputHeaderMap.count(currentHeader))
         {
             printf("Found duplicate header in input file: %s", currentHeader.c_str());
@@ -178,208 +437,15 @@ std::vector<Studancer> LoadDancers(const std::vector<DanceClass>& classes)
         exit(-1);
     }
 
-    // Create indices array
-    const int numIndices = index;
-    std::vector<std::string> indices;
-    for (int i = 0; i < numIndices; i++)
-    {
-        indices.emplace_back("");
-    }
+    // Every row is split into as many fields as the header has
+    inputHeaderColumns = index;
 
     // Parse the dancers
-    int tableIndex = 0;
     while (std::getline(dancersFile, line))
     {
-        Studancer dancer = {};
-
-        offset = 0;
-        for (int i = 0; i < numIndices; i++)
-        {
-            indices[i] = ParseTillNextComma(line, offset);
-        }
-
-        // Store the input row for export
-        dancer.tableRow = line;
-
-        std::string relationNumber = indices[inputHeaderMap["relatienummer"]];
-        trim(relationNumber);
-        dancer.relationNumber = std::stoi(relationNumber);
-
-        std::string studentStatus = indices[inputHeaderMap["studentstatus"]];
-        trim(studentStatus);
-        tolower(studentStatus);
-        bool isStudent = studentStatus == "student";
-        bool hasGapYear = studentStatus == "tussenjaar";
-
-        std::string wasAMember = indices[inputHeaderMap["ben je al lid van studance"]];
-        trim(wasAMember);
-        tolower(wasAMember);
-        bool isNewMember = wasAMember == "nee";
-        bool wasUnenrolledLastYear = wasAMember == "nee, ik stond eind vorig dansseizoen nog op de wachtlijst" ||
-                                     wasAMember == "nee, ik ben vorig seizoen uitgeloot";
-        bool wasNonDancingMember = wasAMember == "ja, ik ben niet-dansend lid";
-
-        std::string gender = indices[inputHeaderMap["gender"]];
-        trim(gender);
-        tolower(gender);
-        bool isNonFemale = gender != "vrouw";
-
-        // Choices need to be cleaned
-        std::stringstream firstChoiceUnparsed(indices[inputHeaderMap["1e keuze"]]);
-        std::string firstChoice;
-        std::getline(firstChoiceUnparsed, firstChoice, '(');
-        trim(firstChoice);
-        tolower(firstChoice);
-
-        std::stringstream secondChoiceUnparsed(indices[inputHeaderMap["2e keuze"]]);
-        std::string secondChoice;
-        std::getline(secondChoiceUnparsed, secondChoice, '(');
-        trim(secondChoice);
-        tolower(secondChoice);
-
-        std::stringstream thirdChoiceUnparsed(indices[inputHeaderMap["3e keuze"]]);
-        std::string thirdChoice;
-        std::getline(thirdChoiceUnparsed, thirdChoice, '(');
-        trim(thirdChoice);
-        tolower(thirdChoice);
-
-        dancer.chosenClasses.push_back(firstChoice);
-
-        dancer.chosenClasses.push_back(secondChoice);
-
-        dancer.chosenClasses.push_back(thirdChoice);
-
-        dancer.chosenClasses.push_back("unenrolled");
-
-        // check and sanitize choices
-        for (int i = 0; i < dancer.chosenClasses.size(); i++)
-        {
-            // sanitize empty choices
-            if (dancer.chosenClasses[i] == "maak een keuze")
-            {
-                dancer.chosenClasses[i] = "";
-            }
-
-            // If we have the same choice as before, set it to empty
-            for (int j = 0; j < i; j++)
-            {
-                if (dancer.chosenClasses[i] == dancer.chosenClasses[j])
-                {
-                    dancer.chosenClasses[i] = "";
-                }
-            }
-
-            // We do not need to check emtpy choices
-            if (dancer.chosenClasses[i] == "")
-            {
-                continue;
-            }
-
-            // Check if we have the chosen class in the list. Otherwise we have an input issue
-            if (!contains(classNames, dancer.chosenClasses[i]))
-            {
-                printf("ERROR: Chosen class %s for dancer %s does not exist in the input classes file\n", dancer.chosenClasses[i].c_str(), relationNumber.c_str());
-                printf("Aborting...\n");
-                exit(-1);
-            }
-        }
-
-        std::string advice = indices[inputHeaderMap["advies"]];
-        trim(advice);
-        tolower(advice);
-        if (advice != "ik was vorig jaar geen lid" && advice != "maak een keuze" && advice != "nee")
-        {
-            if (advice == "ja" && dancer.chosenClasses.size() > 0)
-            {
-                // binary advice
-                dancer.advisedClasses.push_back(dancer.chosenClasses[0]);
-            }
-            else
-            {
-                // advice list is separated by commas
-                std::stringstream advices(advice);
-                std::string currentAdvice;
-                while (std::getline(advices, currentAdvice, ','))
-                {
-                    dancer.advisedClasses.push_back(currentAdvice);
-                }
-            }
-        }
-
-        std::string requestedMembership = indices[inputHeaderMap["lidmaatschap"]];
-        trim(requestedMembership);
-        tolower(requestedMembership);
-        bool halfYearMemberShip = requestedMembership == "halfjaarlijkslidmaatschap";
-
-        bool isKBBoard = contains(kbBoardMembers, dancer.relationNumber);
-        bool isHBBoard = contains(hbBoardMembers, dancer.relationNumber);
-
-        // Damn members pick damn as first choice
-        bool isDamn = firstChoice == "d.a.m.n.";
-
-        if (isKBBoard)
-        {
-            dancer.priorityGroup = KBBoard;
-        }
-        else if (isHBBoard)
-        {
-            dancer.priorityGroup = HBBoard;
-        }
-        else if (isDamn)
-        {
-            dancer.priorityGroup = Damn;
-        }
-        else if (hasGapYear)
-        {
-            if (halfYearMemberShip)
-            {
-                dancer.priorityGroup = HalfGapYear;
-            }
-            else
-            {
-                dancer.priorityGroup = GapYear;
-            }
-        }
-        else if (!isStudent)
-        {
-            if (halfYearMemberShip)
-            {
-                dancer.priorityGroup = HalfNonStudying;
-            }
-            else
-            {
-                dancer.priorityGroup = NonStudying;
-            }
-        }
-        else if (halfYearMemberShip)
-        {
-            dancer.priorityGroup = HalfYear;
-        }
-        else if (wasUnenrolledLastYear)
-        {
-            dancer.priorityGroup = UnrolledLastYear;
-        }
-        else if (wasNonDancingMember)
-        {
-            dancer.priorityGroup = NonDancerLastYear;
-        }
-        else if (!isNewMember)
-        {
-            dancer.priorityGroup = ExistingMember;
-        }
-        else if (isNonFemale)
-        {
-            dancer.priorityGroup = NonFemale;
-        }
-        else
-        {
-            dancer.priorityGroup = Female;
-        }
-
-
+        Studancer dancer;
+        ParseDancerRow(line, classNames, dancer, nullptr);
         dancers.push_back(dancer);
-
-        tableIndex++;
     }
 
     // close file
@@ -389,14 +455,19 @@ std::vector<Studancer> LoadDancers(const std::vector<DanceClass>& classes)
     // This is basically all the randomness necessary for a fair assignment
     std::random_device rd;
     std::mt19937 g(rd());
-    std::shuffle(dancers.begin(), dancers.end(), g);
+    ShuffleDancers(dancers, g);
+
+    return dancers;
+}
+
+void ShuffleDancers(std::vector<Studancer>& dancers, std::mt19937& rng)
+{
+    std::shuffle(dancers.begin(), dancers.end(), rng);
 
     for (int i = 0; i < dancers.size(); i++)
     {
         dancers[i].index = i;
     }
-
-    return dancers;
 }
 
 
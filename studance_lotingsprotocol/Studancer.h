@@ -1,7 +1,9 @@
 #pragma once
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <map>
+#include <random>
 #include "DanceClass.h"
 
 enum DancerPriorityGroup
@@ -24,6 +26,14 @@ enum DancerPriorityGroup
 
 std::string DancerPriorityGroupToString(DancerPriorityGroup group);
 
+// Flags of the arc from a dancer to a chosen class that change its cost
+enum ChoiceCostFlags
+{
+    FollowsAdvice = 1,          // the chosen class is one of the advised classes of the dancer
+    UnenrolledClass = 2,        // the chosen class is unenrolled
+    ChoiceCostFlagCount = 4
+};
+
 // Describes a single person, and all attributes required for the lottery of assigning the person
 // within a dance group in Studance
 struct Studancer
@@ -31,13 +41,29 @@ struct Studancer
     DancerPriorityGroup priorityGroup;
     std::vector<std::string> advisedClasses;
     std::vector<std::string> chosenClasses;
+    std::vector<uint8_t> choiceFlags;   // ChoiceCostFlags of every chosen class, set when the dancer is parsed
     int relationNumber;
     std::string tableRow;
+    int tableRowSplit;      // offset in tableRow just past the first field, the class column is injected here on export
     int index;
 };
 
 std::string GetDancersInputHeader();
 
+// Offset in the input header just past the first field, and the number of fields in it
+int GetDancersInputHeaderSplit();
+int GetDancersInputHeaderColumns();
+
 std::map<std::string, int> GetDancersInputHeaderMap();
 
+// Names the dancers file may have in the input folder
+std::vector<std::string> DancerFileNames();
+
 std::vector<Studancer> LoadDancers(const std::vector<DanceClass>& classes);
+
+// Parses a single row in the format of the dancers file, with the header and board members of the last LoadDancers()
+// Returns false with a description in error when the row cannot be used
+bool ParseDancer(const std::string& line, const std::vector<DanceClass>& classes, Studancer& dancer, std::string& error);
+
+// Shuffles the dancers into a random priority order and updates their index
+void ShuffleDancers(std::vector<Studancer>& dancers, std::mt19937& rng);
@@ -0,0 +1,128 @@
+#include "TaskPool.h"
+#include <algorithm>
+#include <chrono>
+
+TaskPool::TaskPool(int numThreads)
+    : stopping(false)
+{
+    if (numThreads <= 0)
+    {
+        numThreads = std::max(1, (int)std::thread::hardware_concurrency());
+    }
+
+    for (int i = 0; i < numThreads; i++)
+    {
+        threads.emplace_back(&TaskPool::WorkerLoop, this);
+    }
+}
+
+TaskPool::~TaskPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueCondition.notify_all();
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+int TaskPool::GetNumThreads() const
+{
+    return (int)threads.size();
+}
+
+std::future<void> TaskPool::Submit(std::function<void()> task)
+{
+    std::packaged_task<void()> packagedTask(std::move(task));
+    std::future<void> future = packagedTask.get_future();
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queue.push_back(std::move(packagedTask));
+    }
+    queueCondition.notify_one();
+
+    return future;
+}
+
+bool TaskPool::RunQueuedTask()
+{
+    std::packaged_task<void()> task;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (queue.empty())
+        {
+            return false;
+        }
+        task = std::move(queue.front());
+        queue.pop_front();
+    }
+
+    task();
+    return true;
+}
+
+void TaskPool::Wait(std::future<void>& future)
+{
+    while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+        // Help out instead of blocking a thread the task might be waiting for
+        if (!RunQueuedTask())
+        {
+            future.wait_for(std::chrono::milliseconds(1));
+        }
+    }
+    future.get();
+}
+
+void TaskPool::ParallelFor(int count, const std::function<void(int)>& task)
+{
+    std::vector<std::future<void>> futures;
+    for (int i = 1; i < count; i++)
+    {
+        futures.push_back(Submit([&task, i]() { task(i); }));
+    }
+
+    if (count > 0)
+    {
+        task(0);
+    }
+
+    for (auto& future : futures)
+    {
+        Wait(future);
+    }
+}
+
+void TaskPool::WorkerLoop()
+{
+    while (true)
+    {
+        std::packaged_task<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this]() { return stopping || !queue.empty(); });
+
+            if (queue.empty())
+            {
+                // stopping and nothing left to do
+                return;
+            }
+            task = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        task();
+    }
+}
+
+TaskPool& GetTaskPool()
+{
+    // Never destroyed, exit() can be called from a task and must not join the thread it runs on
+    static TaskPool* pool = new TaskPool();
+    return *pool;
+}
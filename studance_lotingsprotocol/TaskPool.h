@@ -0,0 +1,45 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small fixed size thread pool shared by the stages of the program
+// Threads that wait on the pool keep executing queued tasks, so tasks can submit and wait for their own subtasks
+class TaskPool
+{
+public:
+    // 0 threads uses one thread per core
+    explicit TaskPool(int numThreads = 0);
+    ~TaskPool();
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    int GetNumThreads() const;
+
+    // Queues a task, the future is ready once the task has run
+    std::future<void> Submit(std::function<void()> task);
+
+    // Waits for a submitted task, running other queued tasks on this thread in the meantime
+    void Wait(std::future<void>& future);
+
+    // Runs task(i) for every i in [0, count) on the pool and the calling thread and returns when all are done
+    void ParallelFor(int count, const std::function<void(int)>& task);
+
+private:
+    bool RunQueuedTask();
+    void WorkerLoop();
+
+    std::vector<std::thread> threads;
+    std::deque<std::packaged_task<void()>> queue;
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    bool stopping;
+};
+
+// The pool used by all stages of the program
+TaskPool& GetTaskPool();
@@ -1,4 +1,6 @@
 #include "Utils.h"
+#include <cstdarg>
+#include <mutex>
 
 // trim from start (in place)
 void ltrim(std::string& s) {
@@ -46,7 +48,7 @@ void FindFile(std::vector<std::string> fileNames, fs::path folder, std::filesyst
         for (auto& fileName : fileNames)
         {
             fs::path path = folder / fileName.c_str();
-            printf("    %ls\n", path.c_str());
+            printf("    %s\n", path.string().c_str());
         }
         exit(-1);
     }
@@ -74,13 +76,16 @@ fs::path FindFolderInParentDirs(const std::string& folder)
 
     if (currentPath == currentPath.parent_path())
     {
-        printf("Could not find %s folder, please make a folder called %s at: %ls", folder.c_str(), folder.c_str(), fs::current_path().c_str());
+        printf("Could not find %s folder, please make a folder called %s at: %s", folder.c_str(), folder.c_str(), fs::current_path().string().c_str());
         exit(-1);
     }
 
     return currentPath / folder;
 }
 
+// Folders are found lazily from any thread
+std::mutex folderMutex;
+
 fs::path inputFolder = "";
 std::string ChoiceNumberToString(int number)
 {
@@ -103,6 +108,7 @@ std::string ChoiceNumberToString(int number)
 }
 fs::path GetInputFolder()
 {
+    std::lock_guard<std::mutex> lock(folderMutex);
     if (inputFolder != "")
     {
         return inputFolder;
@@ -116,6 +122,7 @@ fs::path GetInputFolder()
 fs::path outputFolder = "";
 fs::path GetOutputFolder()
 {
+    std::lock_guard<std::mutex> lock(folderMutex);
     if (outputFolder != "")
     {
         return outputFolder;
@@ -126,6 +133,69 @@ fs::path GetOutputFolder()
     return outputFolder;
 }
 
+void SetInputFolder(const fs::path& folder)
+{
+    std::lock_guard<std::mutex> lock(folderMutex);
+    inputFolder = folder;
+}
+
+void SetOutputFolder(const fs::path& folder)
+{
+    std::lock_guard<std::mutex> lock(folderMutex);
+    outputFolder = folder;
+}
+
+thread_local std::string* outputBuffer = nullptr;
+
+void Print(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+
+    if (outputBuffer == nullptr)
+    {
+        vprintf(format, args);
+        va_end(args);
+        return;
+    }
+
+    char line[1024];
+    va_list argsCopy;
+    va_copy(argsCopy, args);
+    int length = vsnprintf(line, sizeof(line), format, args);
+    if (length >= (int)sizeof(line))
+    {
+        // Does not fit the stack buffer, format straight into the output buffer
+        size_t offset = outputBuffer->size();
+        outputBuffer->resize(offset + length + 1);
+        vsnprintf(&(*outputBuffer)[offset], length + 1, format, argsCopy);
+        outputBuffer->resize(offset + length);
+    }
+    else if (length > 0)
+    {
+        outputBuffer->append(line, length);
+    }
+    va_end(argsCopy);
+    va_end(args);
+}
+
+ScopedOutputBuffer::ScopedOutputBuffer(std::string* buffer)
+{
+    // A thread waiting on the task pool can run another task, so restore whatever was active before
+    previousBuffer = outputBuffer;
+    outputBuffer = buffer;
+}
+
+ScopedOutputBuffer::~ScopedOutputBuffer()
+{
+    outputBuffer = previousBuffer;
+}
+
+bool IsOutputBuffered()
+{
+    return outputBuffer != nullptr;
+}
+
 // Parses untill the next comma in a CSV file
 std::string ParseTillNextComma(const std::string& inputString, int& offset)
 {
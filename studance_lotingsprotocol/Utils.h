@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <algorithm>
 #include <vector>
 #include <filesystem>
 
@@ -50,5 +51,24 @@ fs::path GetInputFolder();
 
 fs::path GetOutputFolder();
 
+// Overrides the folders that are otherwise searched for in the parent directories
+void SetInputFolder(const fs::path& folder);
+void SetOutputFolder(const fs::path& folder);
+
+// printf for reports, writes into the output buffer of the current thread when one is active
+void Print(const char* format, ...);
+
+// Collects everything the current thread writes with Print into buffer while it is alive
+// Used to keep the reports of tasks that run at the same time from interleaving
+struct ScopedOutputBuffer
+{
+    explicit ScopedOutputBuffer(std::string* buffer);
+    ~ScopedOutputBuffer();
+
+    std::string* previousBuffer;
+};
+
+bool IsOutputBuffered();
+
 // Parses until the next comma and leaves the offset at the start of the next string in a csv line
 std::string ParseTillNextComma(const std::string& inputString, int& offset);
\ No newline at end of file
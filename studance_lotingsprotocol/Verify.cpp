@@ -0,0 +1,239 @@
+#include "Verify.h"
+#include "Export.h"
+#include "Utils.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+
+// The certificate of an export is a csv with the potential of every node, named like GetNodeName()
+fs::path GetCertificatePath(const fs::path& exportPath)
+{
+    return exportPath.parent_path() / (exportPath.stem().string() + "_Certificate.csv");
+}
+
+void WriteCertificate(const MinCostMaxFlowArgs& args, const fs::path& certificatePath)
+{
+    std::ofstream certificateFile(certificatePath);
+    certificateFile << "Node,Potential\n";
+    for (int node = 0; node < args.numNodes; node++)
+    {
+        certificateFile << GetNodeName(args, node) << "," << args.potential[node] << "\n";
+    }
+    certificateFile.close();
+
+    Print("Exported to: %s\n\n", certificatePath.string().c_str());
+}
+
+void ExportCertificate(const MinCostMaxFlowArgs& args, const std::string& outputName)
+{
+    WriteCertificate(args, GetOutputFolder() / (outputName + "_Certificate.csv"));
+}
+
+// Reads the potential of every node of the network, returns false when a node is missing or a line cannot be read
+bool LoadCertificate(const MinCostMaxFlowArgs& args, const fs::path& certificatePath, std::vector<int64_t>& potential)
+{
+    std::ifstream certificateFile(certificatePath);
+    std::map<std::string, int64_t> potentialOfNode;
+    std::string line;
+    std::getline(certificateFile, line);
+    while (std::getline(certificateFile, line))
+    {
+        trim(line);
+        size_t comma = line.rfind(',');
+        std::string value = comma == std::string::npos ? "" : line.substr(comma + 1);
+        bool isNumber = !value.empty() && value != "-" && std::all_of(value.begin() + (value[0] == '-' ? 1 : 0), value.end(), ::isdigit);
+        if (!isNumber)
+        {
+            return false;
+        }
+        potentialOfNode[line.substr(0, comma)] = std::stoll(value);
+    }
+
+    potential.assign(args.numNodes, 0);
+    for (int node = 0; node < args.numNodes; node++)
+    {
+        auto entry = potentialOfNode.find(GetNodeName(args, node));
+        if (entry == potentialOfNode.end())
+        {
+            return false;
+        }
+        potential[node] = entry->second;
+    }
+    return true;
+}
+
+// Checks every placement against the choices of the dancers and the sizes of the classes, every problem is printed
+int CheckPlacements(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const std::vector<AssignmentPlacement>& placements,
+                    const CliArguments& cliArgs)
+{
+    int problems = 0;
+    std::vector<std::vector<int>> classesOfDancer(dancers.size());
+    std::vector<int> classSize(classes.size(), 0);
+    for (const AssignmentPlacement& placement : placements)
+    {
+        const Studancer& dancer = dancers[placement.dancer];
+        const std::string& className = classes[placement.danceClass].name;
+        if (!contains(dancer.chosenClasses, className))
+        {
+            Print("Problem: %i is placed in %s, but did not choose it\n", dancer.relationNumber, className.c_str());
+            problems++;
+        }
+        if (contains(classesOfDancer[placement.dancer], placement.danceClass))
+        {
+            Print("Problem: %i is placed in %s twice\n", dancer.relationNumber, className.c_str());
+            problems++;
+        }
+        classesOfDancer[placement.dancer].push_back(placement.danceClass);
+        classSize[placement.danceClass]++;
+    }
+
+    for (int i = 0; i < dancers.size(); i++)
+    {
+        const Studancer& dancer = dancers[i];
+        int numDanceClassesToChoose = dancer.priorityGroup == KBBoard || dancer.priorityGroup == Damn ? 2 : 1;
+        if (classesOfDancer[i].size() > numDanceClassesToChoose)
+        {
+            Print("Problem: %i is placed in %i classes, but may only take %i\n", dancer.relationNumber, (int)classesOfDancer[i].size(), numDanceClassesToChoose);
+            problems++;
+        }
+    }
+
+    for (int i = 0; i < classes.size(); i++)
+    {
+        const DanceClass& danceClass = classes[i];
+        int capacity = danceClass.maxSize + danceClass.additionalSpace;
+        if (danceClass.name == "niet-dansend lid" || danceClass.name == "unenrolled")
+        {
+            capacity = danceClass.name == "unenrolled" && cliArgs.maxUnenroll != 0xFFFFFFFFU ? cliArgs.maxUnenroll : danceClass.maxSize;
+        }
+        if (classSize[i] > capacity)
+        {
+            Print("Problem: %s has %i dancers, but only room for %i\n", danceClass.name.c_str(), classSize[i], capacity);
+            problems++;
+        }
+    }
+
+    return problems;
+}
+
+// An exported assignment on a network, with the proof of whether it is optimal
+struct ProvenAssignment
+{
+    int problems;               // problems with the placements or the flow, the proof is only made without them
+    fs::path assignmentPath;
+    MinCostMaxFlowArgs mcmf;
+    FlowCertificate certificate;
+    double elapsed;             // ms the proof took
+};
+
+ProvenAssignment ProveAssignment(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const std::string& fileName, const CliArguments& cliArgs)
+{
+    ProvenAssignment proven = {};
+    proven.assignmentPath = fileName;
+    if (!fs::exists(proven.assignmentPath))
+    {
+        proven.assignmentPath = GetOutputFolder() / fileName;
+    }
+    std::vector<AssignmentPlacement> placements = LoadExportPlacements(proven.assignmentPath.string(), dancers, classes);
+    Print("\n");
+
+    proven.problems = CheckPlacements(dancers, classes, placements, cliArgs);
+    if (proven.problems > 0)
+    {
+        Print("\nThe assignment is not feasible, found %i problems\n\n", proven.problems);
+        return proven;
+    }
+
+    // Every placement fits, so none of them is dropped and the flow holds the whole assignment
+    CliArguments encodeArgs = cliArgs;
+    encodeArgs.isUpdate = false;
+    proven.mcmf = EncodeMinCostMaxFlow(dancers, classes, encodeArgs);
+    LoadPlacementFlow(proven.mcmf, placements);
+
+    proven.problems = CheckFlow(proven.mcmf);
+    if (proven.problems > 0)
+    {
+        Print("\nThe flow of the assignment is not valid, found %i problems\n\n", proven.problems);
+        return proven;
+    }
+
+    fs::path certificatePath = GetCertificatePath(proven.assignmentPath);
+    std::vector<int64_t> potential;
+    bool hasCertificate = fs::exists(certificatePath) && LoadCertificate(proven.mcmf, certificatePath, potential);
+
+    auto start = std::chrono::steady_clock::now();
+    proven.certificate = CertifyFlow(proven.mcmf, hasCertificate ? &potential : nullptr);
+    proven.elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return proven;
+}
+
+int VerifyAssignment(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const std::string& fileName, const CliArguments& cliArgs)
+{
+    ProvenAssignment proven = ProveAssignment(dancers, classes, fileName, cliArgs);
+    if (proven.problems > 0)
+    {
+        return proven.problems;
+    }
+
+    const FlowCertificate& certificate = proven.certificate;
+    if (!certificate.isMaximal)
+    {
+        Print("Not optimal: more dancers can be placed, for example with these moves:\n");
+        PrintFlowChange(proven.mcmf, certificate.path);
+        Print("\n");
+        return 1;
+    }
+
+    if (!certificate.isOptimal)
+    {
+        Print("Not optimal: the cost drops by %lli with these moves:\n", (long long)-certificate.cycleCost);
+        PrintFlowChange(proven.mcmf, certificate.cycle);
+        Print("\n");
+        return 1;
+    }
+
+    Print("Optimal with cost %lli, proven %s in %.2f ms\n\n", (long long)GetFlowCost(proven.mcmf),
+        certificate.usedPotentials ? "with the potentials of the certificate" : "with a single Bellman-Ford search", proven.elapsed);
+    if (!certificate.usedPotentials)
+    {
+        WriteCertificate(proven.mcmf, GetCertificatePath(proven.assignmentPath));
+    }
+
+    return 0;
+}
+
+void ExplainDancers(const MinCostMaxFlowArgs& args, const std::vector<int>& relationNumbers)
+{
+    const std::vector<Studancer>& dancers = *args.dancers;
+    for (int relationNumber : relationNumbers)
+    {
+        auto dancer = std::find_if(dancers.begin(), dancers.end(), [&](const Studancer& d) { return d.relationNumber == relationNumber; });
+        if (dancer == dancers.end())
+        {
+            Print("%i is not one of the dancers\n\n", relationNumber);
+            continue;
+        }
+        PrintPlacementExplanation(args, ExplainPlacement(args, (int)(dancer - dancers.begin())));
+    }
+}
+
+int ExplainAssignment(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const std::string& fileName,
+                      const std::vector<int>& relationNumbers, const CliArguments& cliArgs)
+{
+    ProvenAssignment proven = ProveAssignment(dancers, classes, fileName, cliArgs);
+    if (proven.problems > 0)
+    {
+        return proven.problems;
+    }
+
+    // The moves of an explanation are only the cheapest ones when no cycle makes the assignment cheaper
+    if (!proven.certificate.isOptimal)
+    {
+        Print("The assignment is not optimal, so it cannot be explained from its network, --verify shows what to change\n\n");
+        return 1;
+    }
+
+    ExplainDancers(proven.mcmf, relationNumbers);
+    return 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Studancer.h"
+#include "DanceClass.h"
+#include "CliArgs.h"
+#include "MinCostMaxFlow.h"
+
+// Checks an exported assignment, from either algorithm or edited by hand, against the dancers and classes
+// Every dancer must have chosen its classes and not have more of them than it may take, and no class may be over its size
+// Then proves whether it is an optimal MCMF assignment, or prints the dancers to move to make it better
+// The certificate next to the assignment is used when there is one, a new one is written when the assignment is proven optimal without it
+// Returns the number of problems, an assignment that is not optimal counts as one
+int VerifyAssignment(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const std::string& fileName, const CliArguments& cliArgs);
+
+// Writes the potentials of a solved network next to the export named outputName, so VerifyAssignment() proves it in a single pass
+// The potentials must be valid for every arc, also the arcs back into the source, like after ComputeAllPotentials(args, true)
+void ExportCertificate(const MinCostMaxFlowArgs& args, const std::string& outputName);
+
+// Explains per relation number why the dancer did not get its higher choices on a solved network, see ExplainPlacement()
+// The potentials must be valid for every arc, also the arcs back into the source, like after ComputeAllPotentials(args, true)
+void ExplainDancers(const MinCostMaxFlowArgs& args, const std::vector<int>& relationNumbers);
+
+// Like ExplainDancers(), on an exported assignment after it is proven optimal like VerifyAssignment() does, so no new solve is needed
+// Returns the number of problems, an assignment that is not optimal counts as one
+int ExplainAssignment(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const std::string& fileName,
+                      const std::vector<int>& relationNumbers, const CliArguments& cliArgs);
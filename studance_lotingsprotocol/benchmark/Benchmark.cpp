@@ -0,0 +1,538 @@
+#include "Fixtures.h"
+#include "../Studancer.h"
+#include "../DanceClass.h"
+#include "../MinCostMaxFlow.h"
+#include "../Lottery.h"
+#include "../Assignment.h"
+#include "../Statistics.h"
+#include "../Export.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <new>
+#include <random>
+#include <sstream>
+
+#ifdef _WIN32
+#include <io.h>
+#define dup _dup
+#define dup2 _dup2
+#define fileno _fileno
+#define close _close
+#define NULL_DEVICE "NUL"
+#else
+#include <unistd.h>
+#include <sys/resource.h>
+#define NULL_DEVICE "/dev/null"
+#endif
+
+#ifndef BENCHMARK_BASELINE
+#define BENCHMARK_BASELINE "baseline.json"
+#endif
+
+// -----------------------------------------------
+// Allocation counting, every allocation of the process goes through these
+std::atomic<uint64_t> allocationCount(0);
+
+void* operator new(size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    void* memory = std::malloc(size > 0 ? size : 1);
+    if (memory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+// Peak resident set size of the process in KB
+int64_t GetPeakRssKb()
+{
+#ifdef _WIN32
+    return 0;
+#else
+    rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+    return (int64_t)usage.ru_maxrss;
+#endif
+}
+
+// Sends stdout to the null device while the pipeline stages print their reports
+struct QuietStdout
+{
+    int savedStdout;
+
+    QuietStdout()
+    {
+        fflush(stdout);
+        savedStdout = dup(fileno(stdout));
+        FILE* nullDevice = freopen(NULL_DEVICE, "w", stdout);
+        (void)nullDevice;
+    }
+
+    ~QuietStdout()
+    {
+        fflush(stdout);
+        dup2(savedStdout, fileno(stdout));
+        close(savedStdout);
+    }
+};
+
+// -----------------------------------------------
+struct StageResult
+{
+    std::string name;
+    int numDancers;
+    std::vector<double> milliseconds;
+    std::vector<uint64_t> allocations;
+    int64_t peakRssKb;
+
+    double medianMs;
+    double p95Ms;
+    uint64_t medianAllocations;
+};
+
+struct BenchmarkArgs
+{
+    std::vector<int> sizes;
+    int iterations;
+    double threshold;
+    double noiseFloorMs;
+    bool updateBaseline;
+    bool displayHelp;
+    fs::path baselinePath;
+    fs::path workFolder;
+};
+
+template<typename T>
+T Percentile(std::vector<T> samples, double percentile)
+{
+    if (samples.size() == 0)
+    {
+        return T();
+    }
+    std::sort(samples.begin(), samples.end());
+    int index = (int)std::ceil(percentile * samples.size()) - 1;
+    index = std::max(0, std::min(index, (int)samples.size() - 1));
+    return samples[index];
+}
+
+// Times a single stage of the pipeline and records it under the stage name
+void TimeStage(std::map<std::string, StageResult>& results, const std::string& name, int numDancers, const std::function<void()>& stage)
+{
+    uint64_t allocationsBefore = allocationCount.load();
+    auto start = std::chrono::steady_clock::now();
+
+    stage();
+
+    auto end = std::chrono::steady_clock::now();
+    uint64_t allocationsAfter = allocationCount.load();
+
+    StageResult& result = results[name];
+    result.name = name;
+    result.numDancers = numDancers;
+    result.milliseconds.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    result.allocations.push_back(allocationsAfter - allocationsBefore);
+    result.peakRssKb = GetPeakRssKb();
+}
+
+// A fixed workload that does not depend on the code under test, the baseline is scaled by how much faster or slower
+// it runs on this machine than on the one that wrote the baseline
+StageResult RunReference(const BenchmarkArgs& benchmarkArgs)
+{
+    std::map<std::string, StageResult> results;
+    for (int iteration = 0; iteration < benchmarkArgs.iterations; iteration++)
+    {
+        std::mt19937 rng(2024);
+        std::vector<uint32_t> values(1 << 18);
+        for (uint32_t& value : values)
+        {
+            value = rng();
+        }
+        TimeStage(results, "Reference", 0, [&]() { std::sort(values.begin(), values.end()); });
+    }
+
+    StageResult result = results["Reference"];
+    result.medianMs = Percentile(result.milliseconds, 0.5);
+    result.p95Ms = Percentile(result.milliseconds, 0.95);
+    result.medianAllocations = Percentile(result.allocations, 0.5);
+    return result;
+}
+
+std::vector<std::string> StageOrder()
+{
+    return {
+        "LoadClasses",
+        "LoadDancers",
+        "Lottery",
+        "EncodeMinCostMaxFlow",
+        "MinCostMaxFlow",
+        "DecodeMinCostMaxFlow",
+        "ResortAssignment",
+        "PrintAssignmentStats",
+        "ExportAssignment"
+    };
+}
+
+std::vector<StageResult> RunFixture(const BenchmarkArgs& benchmarkArgs, int numDancers)
+{
+    fs::path fixtureFolder = benchmarkArgs.workFolder / ("dancers_" + std::to_string(numDancers));
+    WriteFixture(fixtureFolder, numDancers, 2024);
+    SetInputFolder(fixtureFolder / "input");
+    SetOutputFolder(fixtureFolder / "output");
+
+    CliArguments cliArgs = {};
+    cliArgs.mcmf = true;
+    cliArgs.maxUnenroll = 0xFFFFFFFFU;
+
+    // Iterations are repeated solves of the same network, so they share the solver memory like an ensemble does
+    std::shared_ptr<SolverArena> arena = std::make_shared<SolverArena>();
+
+    std::map<std::string, StageResult> results;
+    for (int iteration = 0; iteration < benchmarkArgs.iterations; iteration++)
+    {
+        QuietStdout quiet;
+
+        std::vector<DanceClass> classes;
+        std::vector<Studancer> dancers;
+        Assignment lotteryAssignment;
+        Assignment assignment;
+        MinCostMaxFlowArgs mcmf = {};
+
+        TimeStage(results, "LoadClasses", numDancers, [&]() { classes = LoadClasses(); });
+        TimeStage(results, "LoadDancers", numDancers, [&]() { dancers = LoadDancers(classes); });
+
+        // LoadDancers() shuffles with random_device and the work of the solve depends on the order,
+        // every iteration solves the same order so the median measures the code and not the shuffle
+        std::sort(dancers.begin(), dancers.end(), [](const Studancer& a, const Studancer& b) { return a.relationNumber < b.relationNumber; });
+        std::mt19937 rng(2024);
+        ShuffleDancers(dancers, rng);
+        StatisticsInput statisticsInput = PrepareStatistics(dancers, classes);
+        TimeStage(results, "Lottery", numDancers, [&]() { lotteryAssignment = Lottery(dancers, classes); });
+        TimeStage(results, "EncodeMinCostMaxFlow", numDancers, [&]() { mcmf = EncodeMinCostMaxFlow(dancers, classes, cliArgs, arena); });
+        TimeStage(results, "MinCostMaxFlow", numDancers, [&]() { MinCostMaxFlow(mcmf, cliArgs); });
+        TimeStage(results, "DecodeMinCostMaxFlow", numDancers, [&]() { assignment = DecodeMinCostMaxFlow(mcmf); });
+        TimeStage(results, "ResortAssignment", numDancers, [&]() { ResortAssignment(assignment); });
+        TimeStage(results, "PrintAssignmentStats", numDancers, [&]() { PrintAssignmentStats(assignment, statisticsInput); });
+        TimeStage(results, "ExportAssignment", numDancers, [&]() { ExportAssignment(assignment, "ClassAssignment_Benchmark", cliArgs); });
+    }
+
+    std::vector<StageResult> orderedResults;
+    for (auto& stageName : StageOrder())
+    {
+        StageResult result = results[stageName];
+        result.medianMs = Percentile(result.milliseconds, 0.5);
+        result.p95Ms = Percentile(result.milliseconds, 0.95);
+        result.medianAllocations = Percentile(result.allocations, 0.5);
+        orderedResults.push_back(result);
+    }
+
+    return orderedResults;
+}
+
+// -----------------------------------------------
+// Baseline file, a flat list of stages:
+// { "stages": [ { "name": "MinCostMaxFlow", "dancers": 400, "median_ms": 1.0, "p95_ms": 1.2, "allocations": 10, "peak_rss_kb": 100 }, ... ] }
+struct BaselineEntry
+{
+    double medianMs;
+    double p95Ms;
+    uint64_t allocations;
+};
+
+std::string BaselineKey(const std::string& stageName, int numDancers)
+{
+    return stageName + "/" + std::to_string(numDancers);
+}
+
+void WriteBaseline(const fs::path& path, const std::vector<StageResult>& results)
+{
+    std::ofstream baselineFile(path);
+    baselineFile << "{\n    \"stages\": [\n";
+    for (int i = 0; i < results.size(); i++)
+    {
+        const StageResult& result = results[i];
+        char line[256];
+        snprintf(line, sizeof(line),
+            "        { \"name\": \"%s\", \"dancers\": %i, \"median_ms\": %.4f, \"p95_ms\": %.4f, \"allocations\": %llu, \"peak_rss_kb\": %lli }%s\n",
+            result.name.c_str(), result.numDancers, result.medianMs, result.p95Ms,
+            (unsigned long long)result.medianAllocations, (long long)result.peakRssKb,
+            i + 1 < results.size() ? "," : "");
+        baselineFile << line;
+    }
+    baselineFile << "    ]\n}\n";
+    baselineFile.close();
+}
+
+// Reads the value after "key": in a single json object, returns an empty string when the key is missing
+std::string ParseJsonValue(const std::string& object, const std::string& key)
+{
+    std::string search = "\"" + key + "\"";
+    size_t position = object.find(search);
+    if (position == std::string::npos)
+    {
+        return "";
+    }
+    position = object.find(':', position + search.length());
+    if (position == std::string::npos)
+    {
+        return "";
+    }
+    position = object.find_first_not_of(" \t\r\n", position + 1);
+    if (position == std::string::npos)
+    {
+        return "";
+    }
+    if (object[position] == '\"')
+    {
+        size_t end = object.find('\"', position + 1);
+        return object.substr(position + 1, end - position - 1);
+    }
+    size_t end = object.find_first_of(",} \t\r\n", position);
+    return object.substr(position, end - position);
+}
+
+std::map<std::string, BaselineEntry> LoadBaseline(const fs::path& path)
+{
+    std::map<std::string, BaselineEntry> baseline;
+
+    std::ifstream baselineFile(path);
+    if (!baselineFile.is_open())
+    {
+        return baseline;
+    }
+
+    std::stringstream content;
+    content << baselineFile.rdbuf();
+    std::string json = content.str();
+
+    // Every stage is a flat object, so walk over the braces inside the stages array
+    size_t arrayStart = json.find('[');
+    size_t position = arrayStart == std::string::npos ? std::string::npos : json.find('{', arrayStart);
+    while (position != std::string::npos)
+    {
+        size_t end = json.find('}', position);
+        if (end == std::string::npos)
+        {
+            break;
+        }
+        std::string object = json.substr(position, end - position + 1);
+
+        std::string name = ParseJsonValue(object, "name");
+        std::string dancers = ParseJsonValue(object, "dancers");
+        if (name != "" && dancers != "")
+        {
+            BaselineEntry entry = {};
+            entry.medianMs = std::atof(ParseJsonValue(object, "median_ms").c_str());
+            entry.p95Ms = std::atof(ParseJsonValue(object, "p95_ms").c_str());
+            entry.allocations = std::strtoull(ParseJsonValue(object, "allocations").c_str(), nullptr, 10);
+            baseline[BaselineKey(name, std::atoi(dancers.c_str()))] = entry;
+        }
+
+        position = json.find('{', end);
+    }
+
+    return baseline;
+}
+
+// -----------------------------------------------
+bool ParseBenchmarkArgs(int argc, char* argv[], BenchmarkArgs& benchmarkArgs)
+{
+    benchmarkArgs.sizes = { 100, 250, 500, 1000 };
+    benchmarkArgs.iterations = 5;
+    benchmarkArgs.threshold = 0.25;
+    benchmarkArgs.noiseFloorMs = 2.0;
+    benchmarkArgs.updateBaseline = false;
+    benchmarkArgs.displayHelp = false;
+    benchmarkArgs.baselinePath = BENCHMARK_BASELINE;
+    benchmarkArgs.workFolder = fs::temp_directory_path() / "studance_benchmark";
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--sizes" && hasValue)
+        {
+            benchmarkArgs.sizes.clear();
+            std::stringstream sizes(argv[++i]);
+            std::string size;
+            while (std::getline(sizes, size, ','))
+            {
+                benchmarkArgs.sizes.push_back(std::stoi(size));
+            }
+        }
+        else if (arg == "--iterations" && hasValue)
+        {
+            benchmarkArgs.iterations = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--threshold" && hasValue)
+        {
+            benchmarkArgs.threshold = std::stod(argv[++i]);
+        }
+        else if (arg == "--noise-floor" && hasValue)
+        {
+            benchmarkArgs.noiseFloorMs = std::stod(argv[++i]);
+        }
+        else if (arg == "--baseline" && hasValue)
+        {
+            benchmarkArgs.baselinePath = argv[++i];
+        }
+        else if (arg == "--work-dir" && hasValue)
+        {
+            benchmarkArgs.workFolder = argv[++i];
+        }
+        else if (arg == "--update-baseline")
+        {
+            benchmarkArgs.updateBaseline = true;
+        }
+        else if (arg == "--help" || arg == "-h")
+        {
+            benchmarkArgs.displayHelp = true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void DisplayBenchmarkHelp()
+{
+    printf("Usage: studance_benchmark [--sizes 100,250,500,1000] [--iterations 5] [--threshold 0.25] [--noise-floor 2.0]\n");
+    printf("                          [--baseline baseline.json] [--work-dir dir] [--update-baseline]\n");
+    printf("  --threshold     : Allowed relative regression of a stage before failing (0.25 = 25%%)\n");
+    printf("  --noise-floor   : Median differences below this many milliseconds are never a regression\n");
+    printf("                    Stages of a few milliseconds vary more than the threshold between runs on the same machine\n");
+    printf("  --update-baseline : Write the measured results as the new baseline instead of comparing\n");
+    printf("The baseline is scaled by a reference workload, so a faster or slower machine does not count as a change\n");
+}
+
+int main(int argc, char* argv[])
+{
+    BenchmarkArgs benchmarkArgs = {};
+    bool isParsed = ParseBenchmarkArgs(argc, argv, benchmarkArgs);
+    if (!isParsed || benchmarkArgs.displayHelp)
+    {
+        DisplayBenchmarkHelp();
+        return isParsed ? 0 : -1;
+    }
+
+    std::map<std::string, BaselineEntry> baseline;
+    if (!benchmarkArgs.updateBaseline)
+    {
+        baseline = LoadBaseline(benchmarkArgs.baselinePath);
+        if (baseline.size() == 0)
+        {
+            printf("No baseline found at %s, only reporting results\n\n", benchmarkArgs.baselinePath.string().c_str());
+        }
+    }
+
+    std::vector<StageResult> allResults;
+    StageResult reference = RunReference(benchmarkArgs);
+    allResults.push_back(reference);
+
+    // Without a reference in the baseline the machines are assumed to be equally fast
+    double machineScale = 1.0;
+    auto baselineReference = baseline.find(BaselineKey(reference.name, reference.numDancers));
+    if (baselineReference != baseline.end() && baselineReference->second.medianMs > 0.0)
+    {
+        machineScale = reference.medianMs / baselineReference->second.medianMs;
+        printf("Reference workload runs %.2fx as long as for the baseline, scaling the baseline times by it\n\n", machineScale);
+    }
+
+    for (int numDancers : benchmarkArgs.sizes)
+    {
+        printf("Benchmarking %i dancers (%i iterations)...\n", numDancers, benchmarkArgs.iterations);
+        std::vector<StageResult> results = RunFixture(benchmarkArgs, numDancers);
+        allResults.insert(allResults.end(), results.begin(), results.end());
+    }
+
+    printf("\n");
+    printf("========================================================================================================\n");
+    printf("| Stage                | Dancers |  Median ms |     p95 ms |  Allocations | Peak RSS MB | Baseline ms |\n");
+    printf("========================================================================================================\n");
+
+    int regressions = 0;
+    for (auto& result : allResults)
+    {
+        std::string status = "";
+        std::string baselineMs = "-";
+
+        auto entry = baseline.find(BaselineKey(result.name, result.numDancers));
+        if (entry != baseline.end())
+        {
+            // The reference itself is only the scale, never a regression
+            double expectedMs = entry == baselineReference ? entry->second.medianMs : entry->second.medianMs * machineScale;
+            char buffer[32];
+            snprintf(buffer, sizeof(buffer), "%.3f", expectedMs);
+            baselineMs = buffer;
+
+            double allowedMs = expectedMs * (1.0 + benchmarkArgs.threshold);
+            bool slower = entry != baselineReference && result.medianMs > allowedMs && result.medianMs - expectedMs > benchmarkArgs.noiseFloorMs;
+
+            double allowedAllocations = (double)entry->second.allocations * (1.0 + benchmarkArgs.threshold);
+            bool moreAllocations = (double)result.medianAllocations > allowedAllocations && result.medianAllocations > entry->second.allocations + 16;
+
+            if (slower || moreAllocations)
+            {
+                status = slower ? " REGRESSED (time)" : " REGRESSED (allocations)";
+                regressions++;
+            }
+        }
+
+        printf("| %-20s | %7i | %10.3f | %10.3f | %12llu | %11.1f | %11s |%s\n",
+            result.name.c_str(), result.numDancers, result.medianMs, result.p95Ms,
+            (unsigned long long)result.medianAllocations, (double)result.peakRssKb / 1024.0, baselineMs.c_str(), status.c_str());
+    }
+    printf("========================================================================================================\n\n");
+
+    if (benchmarkArgs.updateBaseline)
+    {
+        WriteBaseline(benchmarkArgs.baselinePath, allResults);
+        printf("Updated baseline: %s\n", benchmarkArgs.baselinePath.string().c_str());
+        return 0;
+    }
+
+    if (regressions > 0)
+    {
+        printf("%i stage(s) regressed by more than %.0f%% against the baseline\n", regressions, benchmarkArgs.threshold * 100.0);
+        return 1;
+    }
+
+    printf("No regressions against the baseline\n");
+    return 0;
+}
@@ -0,0 +1,154 @@
+#include "Fixtures.h"
+#include <fstream>
+#include <random>
+
+// Class names of a typical season, the first classes are the most popular ones
+std::vector<std::string> FixtureClassNames()
+{
+    return {
+        "Streetdance 1",
+        "Hiphop 1",
+        "Modern 1",
+        "Jazz 1",
+        "Streetdance 2",
+        "Hiphop 2",
+        "Feminine hiphop",
+        "Modern 2",
+        "Jazz 2",
+        "Streetdance 3",
+        "Hiphop 3",
+        "Feminine jazz/modern",
+        "Modern 3",
+        "Jazz 3",
+        "Mixles",
+        "Klassiek",
+        "d.a.m.n."
+    };
+}
+
+void WriteFixtureClasses(const fs::path& inputFolder, int numDancers)
+{
+    std::ofstream classesFile(inputFolder / "danceclasses.csv");
+
+    // The real season has ~22 spots per class for ~500 dancers, keep that ratio so there is always competition
+    std::vector<std::string> classNames = FixtureClassNames();
+    int maxSize = std::max(4, (numDancers * 22) / 500);
+    int minSize = maxSize / 2;
+
+    classesFile << "Naam,Maximale Ruimte,Minimale Ruimte,Extra Speel Ruimte\n";
+    for (auto& className : classNames)
+    {
+        int additionalSpace = className == "d.a.m.n." ? 0 : 2;
+        classesFile << className << "," << maxSize << "," << minSize << "," << additionalSpace << "\n";
+    }
+
+    classesFile.close();
+}
+
+void WriteFixtureDancers(const fs::path& inputFolder, int numDancers, std::mt19937& rng)
+{
+    std::ofstream dancersFile(inputFolder / "dancers.csv");
+
+    std::vector<std::string> classNames = FixtureClassNames();
+
+    // Popularity falls off with the position in the class list
+    std::vector<double> popularity;
+    for (int i = 0; i < (int)classNames.size() - 1; i++)
+    {
+        popularity.push_back(1.0 / (1.0 + 0.25 * i));
+    }
+    std::discrete_distribution<int> classDistribution(popularity.begin(), popularity.end());
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+
+    dancersFile << "Relatienummer,Voornaam,Achternaam,Studentstatus,Ben je al lid van Studance?,Gender,1e keuze,2e keuze,3e keuze,Advies,Lidmaatschap\n";
+
+    for (int i = 0; i < numDancers; i++)
+    {
+        int relationNumber = 100000 + i;
+
+        double roll = chance(rng);
+        std::string studentStatus = roll < 0.85 ? "Student" : roll < 0.9 ? "Tussenjaar" : "Werkend";
+
+        roll = chance(rng);
+        std::string wasAMember = roll < 0.5 ? "Nee" :
+                                 roll < 0.85 ? "Ja" :
+                                 roll < 0.9 ? "Ja, ik ben niet-dansend lid" :
+                                 roll < 0.95 ? "Nee, ik ben vorig seizoen uitgeloot" :
+                                               "Nee, ik stond eind vorig dansseizoen nog op de wachtlijst";
+
+        std::string gender = chance(rng) < 0.7 ? "Vrouw" : "Man";
+
+        // Pick three distinct choices, with an occasional empty 3rd choice
+        std::vector<std::string> choices;
+        if (chance(rng) < 0.02)
+        {
+            choices.push_back("d.a.m.n.");
+        }
+        while (choices.size() < 3)
+        {
+            std::string choice = classNames[classDistribution(rng)];
+            if (!contains(choices, choice))
+            {
+                choices.push_back(choice);
+            }
+        }
+        if (chance(rng) < 0.1)
+        {
+            choices[2] = "Maak een keuze";
+        }
+
+        std::string advice = "Ik was vorig jaar geen lid";
+        if (wasAMember == "Ja")
+        {
+            advice = chance(rng) < 0.5 ? "Ja" : "Nee";
+        }
+
+        std::string membership = chance(rng) < 0.1 ? "Halfjaarlijkslidmaatschap" : "Jaarlijkslidmaatschap";
+
+        dancersFile << relationNumber << ",Voornaam" << i << ",Achternaam" << i << ",";
+        dancersFile << studentStatus << ",\"" << wasAMember << "\"," << gender << ",";
+        dancersFile << choices[0] << " (wekelijks)," << choices[1] << " (wekelijks)," << choices[2] << ",";
+        dancersFile << advice << "," << membership << "\n";
+    }
+
+    dancersFile.close();
+}
+
+void WriteFixtureBoard(const fs::path& inputFolder, int numDancers)
+{
+    std::ofstream boardFile(inputFolder / "Board.txt");
+
+    // First few relation numbers are the board
+    int kbMembers = std::min(5, numDancers);
+    int hbMembers = std::min(8, numDancers - kbMembers);
+
+    boardFile << "kb:";
+    for (int i = 0; i < kbMembers; i++)
+    {
+        boardFile << (i > 0 ? "," : "") << 100000 + i;
+    }
+    boardFile << "\n";
+
+    boardFile << "hb:";
+    for (int i = 0; i < hbMembers; i++)
+    {
+        boardFile << (i > 0 ? "," : "") << 100000 + kbMembers + i;
+    }
+    boardFile << "\n";
+
+    boardFile.close();
+}
+
+void WriteFixture(const fs::path& folder, int numDancers, unsigned int seed)
+{
+    fs::path inputFolder = folder / "input";
+    fs::path outputFolder = folder / "output";
+    fs::create_directories(inputFolder);
+    fs::create_directories(outputFolder);
+
+    std::mt19937 rng(seed + numDancers);
+
+    WriteFixtureClasses(inputFolder, numDancers);
+    WriteFixtureDancers(inputFolder, numDancers, rng);
+    WriteFixtureBoard(inputFolder, numDancers);
+}
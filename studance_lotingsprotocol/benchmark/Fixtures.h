@@ -0,0 +1,6 @@
+#pragma once
+#include "../Utils.h"
+
+// Writes a synthetic season (danceclasses.csv, dancers.csv and Board.txt) with the given number of dancers
+// into <folder>/input and creates an empty <folder>/output. The same size and seed always produce the same files.
+void WriteFixture(const fs::path& folder, int numDancers, unsigned int seed);
@@ -6,42 +6,78 @@
 #include "Assignment.h"
 #include "Statistics.h"
 #include "Export.h"
+#include "Simulation.h"
+#include "Ensemble.h"
+#include "Scenarios.h"
+#include "CostModel.h"
+#include "Daemon.h"
+#include "Verify.h"
+#include "TaskPool.h"
+#include "Utils.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <numeric>
+#include <random>
+#include <thread>
 
 // Runs Lottery algorithm
-void RunLottery(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const CliArguments& cliArgs)
+void RunLottery(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const StatisticsInput& statisticsInput, const CliArguments& cliArgs)
 {
-    printf("*******************************************************************************\n");
-    printf("=================== Running Lottery algorithm for assignment ==================\n");
-    printf("*******************************************************************************\n\n");
+    Print("*******************************************************************************\n");
+    Print("=================== Running Lottery algorithm for assignment ==================\n");
+    Print("*******************************************************************************\n\n");
 
     // Create assignment
     Assignment assignment = Lottery(dancers, classes);
+    Print("Assigned everyone\n");
 
     ResortAssignment(assignment);
 
     // Print statistics to the terminal
-    PrintAssignmentStats(assignment);
+    AssignmentStatistics statistics;
+    ClearAssignmentStatistics(statistics, (int)classes.size());
+    CountAssignment(statistics, statisticsInput, assignment);
+    PrintAssignmentStats(statistics, statisticsInput);
 
     // Export solution
     ExportAssignment(assignment, "ClassAssignment_Lottery", cliArgs);
+    ExportAssignmentStats(statistics, statisticsInput, "Statistics_Lottery");
 
-    printf("*******************************************************************************\n");
-    printf("================== Finished Lottery algorithm for assignment ==================\n");
-    printf("*******************************************************************************\n\n");
+    Print("*******************************************************************************\n");
+    Print("================== Finished Lottery algorithm for assignment ==================\n");
+    Print("*******************************************************************************\n\n");
 }
 
 // Runs Min Cost Max Flow algorithm
-void RunMCMF(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const CliArguments& cliArgs)
+void RunMCMF(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const StatisticsInput& statisticsInput, const CliArguments& cliArgs)
 {
-    printf("*******************************************************************************\n");
-    printf("==================== Running MCMF algorithm for assignment ====================\n");
-    printf("*******************************************************************************\n\n");
+    Print("*******************************************************************************\n");
+    Print("==================== Running MCMF algorithm for assignment ====================\n");
+    Print("*******************************************************************************\n\n");
 
     // Encode the mincost maxflow problem
     MinCostMaxFlowArgs mcmf = EncodeMinCostMaxFlow(dancers, classes, cliArgs);
 
-    // Solve min cost max flow
-    auto result = MinCostMaxFlow(mcmf, cliArgs);
+    // Solve min cost max flow, an existing solution is only loaded into the network as a whole
+    std::pair<int64_t, int> result;
+    if (cliArgs.presolve && !cliArgs.isUpdate)
+    {
+        result = MinCostMaxFlowWithPresolve(mcmf, cliArgs);
+    }
+    else if (cliArgs.tiers && !cliArgs.isUpdate)
+    {
+        result = MinCostMaxFlowByTiers(mcmf, cliArgs);
+    }
+    else if (cliArgs.components && !cliArgs.isUpdate)
+    {
+        result = MinCostMaxFlowByComponents(mcmf, cliArgs);
+    }
+    else
+    {
+        result = MinCostMaxFlow(mcmf, cliArgs);
+    }
 
     // Retrieve solution from min cost max flow
     Assignment assignment = DecodeMinCostMaxFlow(mcmf);
@@ -52,17 +88,324 @@ void RunMCMF(const std::vector<Studancer>& dancers, const std::vector<DanceClass
     DumpDecisionLog(mcmf);
 
     // Print statistics to the terminal
-    PrintAssignmentStats(assignment);
+    AssignmentStatistics statistics;
+    ClearAssignmentStatistics(statistics, (int)classes.size());
+    CountAssignment(statistics, statisticsInput, assignment);
+    PrintAssignmentStats(statistics, statisticsInput);
 
     // Export solution
     ExportAssignment(assignment, "ClassAssignment_MCMF", cliArgs);
+    ExportAssignmentStats(statistics, statisticsInput, "Statistics_MCMF");
+
+    // Lets --verify prove the export optimal in a single pass, also after it was edited
+    if (ComputeAllPotentials(mcmf, true))
+    {
+        ExportCertificate(mcmf, "ClassAssignment_MCMF");
+
+        // The same potentials answer --explain straight from the solved network
+        ExplainDancers(mcmf, cliArgs.explainRelationNumbers);
+    }
+
+    // The searches of the reports start at class nodes the source does not reach, so every node needs a potential
+    if ((cliArgs.waitlists || cliArgs.sensitivity) && !ComputeAllPotentials(mcmf))
+    {
+        Print("Could not compute the class reports, the solved network still contains a negative cycle\n\n");
+    }
+    else
+    {
+        if (cliArgs.waitlists)
+        {
+            ExportWaitlists(ComputeWaitlists(mcmf), assignment, dancers, classes, "Waitlists_MCMF");
+        }
+
+        if (cliArgs.sensitivity)
+        {
+            std::vector<ClassSensitivity> sensitivity = ComputeClassSensitivity(mcmf);
+            if (cliArgs.verifySensitivity)
+            {
+                int mismatches = VerifyClassSensitivity(mcmf, sensitivity, cliArgs);
+                Print("Verified the sensitivity of every class, %i seat changes did not match\n\n", mismatches);
+            }
+            ExportSensitivity(sensitivity, assignment, "Sensitivity_MCMF");
+        }
+    }
+
+    Print("*******************************************************************************\n");
+    Print("=================== Finished MCMF algorithm for assignment ====================\n");
+    Print("*******************************************************************************\n\n");
+}
+
+
+// Runs the Lottery algorithm many times and exports the placement probabilities
+void RunLotterySimulation(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const StatisticsInput& statisticsInput, const CliArguments& cliArgs)
+{
+    Print("*******************************************************************************\n");
+    Print("==================== Running Lottery algorithm simulation =====================\n");
+    Print("*******************************************************************************\n\n");
+
+    unsigned int seed = cliArgs.seed;
+    if (!cliArgs.hasSeed)
+    {
+        std::random_device rd;
+        seed = rd();
+    }
+    Print("Simulating %i lottery runs with seed %u\n\n", cliArgs.simulations, seed);
+
+    SimulationResult result = SimulateLottery(dancers, classes, statisticsInput, cliArgs.simulations, seed);
+
+    // Print statistics to the terminal
+    PrintSimulationStats(result, dancers);
+
+    // Export probabilities
+    ExportSimulation(result, dancers, classes, "Simulation_Lottery");
+    ExportAssignmentStats(result.statistics, statisticsInput, "Statistics_Simulation_Lottery");
+
+    Print("*******************************************************************************\n");
+    Print("=================== Finished Lottery algorithm simulation =====================\n");
+    Print("*******************************************************************************\n\n");
+}
+
+// Solves MCMF for many shuffled dancer orders and exports the placement probabilities
+void RunMCMFEnsemble(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const StatisticsInput& statisticsInput, const CliArguments& cliArgs)
+{
+    Print("*******************************************************************************\n");
+    Print("===================== Running MCMF algorithm ensemble =========================\n");
+    Print("*******************************************************************************\n\n");
+
+    unsigned int seed = cliArgs.seed;
+    if (!cliArgs.hasSeed)
+    {
+        std::random_device rd;
+        seed = rd();
+    }
+    Print("Solving %i shuffled dancer orders with seed %u\n\n", cliArgs.ensembleRuns, seed);
+
+    SimulationResult result = EnsembleMinCostMaxFlow(dancers, classes, statisticsInput, cliArgs, cliArgs.ensembleRuns, seed);
+
+    // Print statistics to the terminal
+    PrintSimulationStats(result, dancers);
+
+    // Export probabilities
+    ExportSimulation(result, dancers, classes, "Ensemble_MCMF");
+    ExportAssignmentStats(result.statistics, statisticsInput, "Statistics_Ensemble_MCMF");
+
+    Print("*******************************************************************************\n");
+    Print("==================== Finished MCMF algorithm ensemble =========================\n");
+    Print("*******************************************************************************\n\n");
+}
+
+// Solves MCMF for every scenario of class sizes and exports a comparison
+void RunMCMFScenarios(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const StatisticsInput& statisticsInput, const CliArguments& cliArgs)
+{
+    Print("*******************************************************************************\n");
+    Print("===================== Running MCMF algorithm scenarios ========================\n");
+    Print("*******************************************************************************\n\n");
+
+    std::vector<CapacityScenario> scenarios = LoadScenarios(cliArgs.scenariosFile, classes);
+    std::vector<ScenarioResult> results = SolveScenarios(dancers, statisticsInput, scenarios, cliArgs);
+
+    PrintScenarios(scenarios, results);
+    ExportScenarios(scenarios, results, "Scenarios_MCMF");
+
+    Print("*******************************************************************************\n");
+    Print("==================== Finished MCMF algorithm scenarios ========================\n");
+    Print("*******************************************************************************\n\n");
+}
+
+// Solves MCMF for every --max-unenroll from unbounded down and exports the outcome of each
+void RunMCMFUnenrollSweep(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const StatisticsInput& statisticsInput, const CliArguments& cliArgs)
+{
+    Print("*******************************************************************************\n");
+    Print("===================== Running MCMF --max-unenroll sweep =======================\n");
+    Print("*******************************************************************************\n\n");
+
+    std::vector<UnenrollSweepStep> steps = SweepMaxUnenroll(dancers, classes, statisticsInput, cliArgs);
+
+    PrintUnenrollSweep(steps, cliArgs);
+    ExportUnenrollSweep(steps, "UnenrollSweep_MCMF");
+
+    Print("*******************************************************************************\n");
+    Print("==================== Finished MCMF --max-unenroll sweep =======================\n");
+    Print("*******************************************************************************\n\n");
+}
+
+// Solves MCMF for every cost model of the sweep and exports which dancers are placed differently
+void RunMCMFCostSweep(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const StatisticsInput& statisticsInput, const CliArguments& cliArgs)
+{
+    Print("*******************************************************************************\n");
+    Print("======================= Running MCMF cost model sweep =========================\n");
+    Print("*******************************************************************************\n\n");
+
+    std::string baseName = cliArgs.costModelFile.empty() ? "CostModel.txt" : cliArgs.costModelFile;
+    std::vector<NamedCostModel> costModels = LoadCostModelSweep(cliArgs.costSweepFile, baseName, LoadCostModelParameters(cliArgs.costModelFile));
+    std::vector<CostSweepResult> results = SolveCostSweep(dancers, classes, statisticsInput, costModels, cliArgs);
+
+    PrintCostSweep(costModels, results);
+    ExportCostSweep(costModels, results, dancers, classes, "CostSweep_MCMF");
+
+    Print("*******************************************************************************\n");
+    Print("====================== Finished MCMF cost model sweep =========================\n");
+    Print("*******************************************************************************\n\n");
+}
+
+// Improves a lottery draw towards the MCMF assignment until the time budget runs out and exports what it has by then
+void RunMCMFAnytime(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const StatisticsInput& statisticsInput, const CliArguments& cliArgs)
+{
+    Print("*******************************************************************************\n");
+    Print("================ Running MCMF algorithm within a time budget ==================\n");
+    Print("*******************************************************************************\n\n");
+
+    // The budget also covers the draw and building the network
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::milliseconds(cliArgs.timeBudget);
+
+    unsigned int seed = cliArgs.seed;
+    if (!cliArgs.hasSeed)
+    {
+        std::random_device rd;
+        seed = rd();
+    }
+    std::mt19937 rng(seed);
+
+    // The loaded dancers are already shuffled, shuffle the relation number order again like SimulateLottery() does
+    // so the same seed always gives the same draw, the network and the export follow the new order
+    std::vector<int> loadedIndex(dancers.size());
+    std::iota(loadedIndex.begin(), loadedIndex.end(), 0);
+    std::sort(loadedIndex.begin(), loadedIndex.end(), [&](int a, int b) {
+        return dancers[a].relationNumber < dancers[b].relationNumber;
+    });
+    std::shuffle(loadedIndex.begin(), loadedIndex.end(), rng);
+
+    std::vector<Studancer> seededDancers(dancers.size());
+    for (int i = 0; i < seededDancers.size(); i++)
+    {
+        seededDancers[i] = dancers[loadedIndex[i]];
+        seededDancers[i].index = i;
+    }
 
-    printf("*******************************************************************************\n");
-    printf("=================== Finished MCMF algorithm for assignment ====================\n");
-    printf("*******************************************************************************\n\n");
+    CliArguments encodeArgs = cliArgs;
+    encodeArgs.isUpdate = false;
+    MinCostMaxFlowArgs mcmf = EncodeMinCostMaxFlow(seededDancers, classes, encodeArgs);
+    LoadPlacementFlow(mcmf, LotteryPlacements(seededDancers, classes, rng));
+    Print("Seeded with the lottery draw of seed %u, cost %lli before placing the units the draw left out\n", seed, (long long)GetFlowCost(mcmf));
+
+    AnytimeResult result = ImproveFlowWithinBudget(mcmf, deadline);
+
+    int64_t gap = result.cost - result.lowerBound;
+    long long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    Print("Placed %i units the draw left out, cost %lli, and cancelled %i cycles in %lli ms\n", result.pathsAugmented,
+        (long long)result.completedCost, result.cyclesCancelled, elapsed);
+    Print("Cost %lli, lower bound %lli, gap %lli (%.4f%%)%s\n\n", (long long)result.cost, (long long)result.lowerBound, (long long)gap,
+        result.cost == 0 ? 0.0 : 100.0 * (double)gap / (double)result.cost, result.isOptimal ? ", optimal" : "");
+
+    Assignment assignment = DecodeMinCostMaxFlow(mcmf);
+    ResortAssignment(assignment);
+
+    // The statistics input follows the loaded dancers
+    AssignmentStatistics statistics;
+    ClearAssignmentStatistics(statistics, (int)classes.size());
+    for (int classIndex = 0; classIndex < assignment.size(); classIndex++)
+    {
+        for (auto& dancer : assignment[classIndex].second)
+        {
+            CountPlacement(statistics, statisticsInput, loadedIndex[dancer.index], classIndex);
+        }
+    }
+    statistics.runs++;
+    PrintAssignmentStats(statistics, statisticsInput);
+
+    ExportAssignment(assignment, "ClassAssignment_Anytime", cliArgs);
+    ExportAssignmentStats(statistics, statisticsInput, "Statistics_Anytime");
+
+    Print("*******************************************************************************\n");
+    Print("=============== Finished MCMF algorithm within a time budget ==================\n");
+    Print("*******************************************************************************\n\n");
+}
+
+// Checks an exported assignment and proves whether it is optimal
+void RunVerify(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const CliArguments& cliArgs)
+{
+    Print("*******************************************************************************\n");
+    Print("========================== Verifying the assignment ===========================\n");
+    Print("*******************************************************************************\n\n");
+
+    VerifyAssignment(dancers, classes, cliArgs.verifyFile, cliArgs);
+
+    Print("*******************************************************************************\n");
+    Print("====================== Finished verifying the assignment ======================\n");
+    Print("*******************************************************************************\n\n");
+}
+
+// Explains the placement of dancers from the last MCMF export, without solving again
+void RunExplain(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const CliArguments& cliArgs)
+{
+    Print("*******************************************************************************\n");
+    Print("======================== Explaining the MCMF assignment =======================\n");
+    Print("*******************************************************************************\n\n");
+
+    ExplainAssignment(dancers, classes, "ClassAssignment_MCMF.csv", cliArgs.explainRelationNumbers, cliArgs);
+
+    Print("*******************************************************************************\n");
+    Print("==================== Finished explaining the MCMF assignment ==================\n");
+    Print("*******************************************************************************\n\n");
 }
 
+// A stage of the program, it starts once the stages it waits for have finished
+struct ProgramStage
+{
+    std::function<void()> run;
+    std::vector<int> waitsFor;      // earlier stages whose exports this stage reads
+};
+
+// Runs the stages at the same time, their reports are buffered and printed in the given order
+// Every stage gets a thread of its own and only its subtasks go on the task pool,
+// so a stage that waits for its subtasks never picks up another whole stage
+void RunStagesConcurrently(const std::vector<ProgramStage>& stages)
+{
+    std::vector<std::string> outputs(stages.size());
+    std::vector<std::promise<void>> finished(stages.size());
+    std::vector<std::shared_future<void>> isFinished;
+    for (auto& promise : finished)
+    {
+        isFinished.push_back(promise.get_future().share());
+    }
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < stages.size(); i++)
+    {
+        threads.emplace_back([&stages, &outputs, &finished, &isFinished, i]() {
+            for (int stage : stages[i].waitsFor)
+            {
+                isFinished[stage].wait();
+            }
 
+            {
+                ScopedOutputBuffer outputBuffer(&outputs[i]);
+                stages[i].run();
+            }
+            finished[i].set_value();
+        });
+    }
+
+    for (int i = 0; i < stages.size(); i++)
+    {
+        isFinished[i].wait();
+
+        // Extra spacing for when multiple programs run
+        if (i > 0)
+        {
+            printf("\n\n\n\n");
+        }
+
+        fputs(outputs[i].c_str(), stdout);
+        fflush(stdout);
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
 
 // -----------------------------------------------
 int main(int argc, char* argv[])
@@ -83,26 +426,88 @@ int main(int argc, char* argv[])
     // Load all dancers
     std::vector<Studancer> dancers = LoadDancers(classes);
 
-    PrintChoiceStats(dancers, classes);
+    // Load the cost model, before any network is encoded
+    SetCostModel(CompileCostModel(LoadCostModelParameters(cliArgs.costModelFile)));
+
+    // The daemon answers on stdout, so it starts before anything is reported
+    if (cliArgs.daemon)
+    {
+        RunDaemon(dancers, classes, cliArgs);
+        return 0;
+    }
+
+    // Every stage counts its placements with the same ids
+    StatisticsInput statisticsInput = PrepareStatistics(dancers, classes);
+
+    PrintChoiceStats(statisticsInput, classes);
+
+    // All stages only read the dancers and classes, so they can run at the same time
+    // Stages that read an export wait for the stages before them
+    std::vector<ProgramStage> stages;
+    auto allStagesSoFar = [&stages]() {
+        std::vector<int> waitsFor(stages.size());
+        std::iota(waitsFor.begin(), waitsFor.end(), 0);
+        return waitsFor;
+    };
 
     if (cliArgs.lottery)
     {
-        RunLottery(dancers, classes, cliArgs);
+        stages.push_back({ [&]() { RunLottery(dancers, classes, statisticsInput, cliArgs); } });
     }
 
     if (cliArgs.mcmf)
     {
-        // Extra spacing for when both programs run
-        if (cliArgs.lottery)
-        {
-            printf("\n\n\n\n");
-        }
+        stages.push_back({ [&]() { RunMCMF(dancers, classes, statisticsInput, cliArgs); } });
+    }
 
-        RunMCMF(dancers, classes, cliArgs);
+    if (cliArgs.simulations > 0)
+    {
+        stages.push_back({ [&]() { RunLotterySimulation(dancers, classes, statisticsInput, cliArgs); } });
     }
 
+    if (cliArgs.ensembleRuns > 0)
+    {
+        stages.push_back({ [&]() { RunMCMFEnsemble(dancers, classes, statisticsInput, cliArgs); } });
+    }
+
+    if (!cliArgs.scenariosFile.empty())
+    {
+        stages.push_back({ [&]() { RunMCMFScenarios(dancers, classes, statisticsInput, cliArgs); } });
+    }
+
+    if (cliArgs.sweepMaxUnenroll)
+    {
+        stages.push_back({ [&]() { RunMCMFUnenrollSweep(dancers, classes, statisticsInput, cliArgs); } });
+    }
+
+    if (!cliArgs.costSweepFile.empty())
+    {
+        stages.push_back({ [&]() { RunMCMFCostSweep(dancers, classes, statisticsInput, cliArgs); } });
+    }
+
+    if (cliArgs.timeBudget > 0)
+    {
+        stages.push_back({ [&]() { RunMCMFAnytime(dancers, classes, statisticsInput, cliArgs); } });
+    }
+
+    if (!cliArgs.verifyFile.empty())
+    {
+        // The file can be the export of one of the stages before it
+        stages.push_back({ [&]() { RunVerify(dancers, classes, cliArgs); }, allStagesSoFar() });
+    }
+
+    // With -m the solve explains them itself
+    if (!cliArgs.explainRelationNumbers.empty() && !cliArgs.mcmf)
+    {
+        stages.push_back({ [&]() { RunExplain(dancers, classes, cliArgs); }, allStagesSoFar() });
+    }
+
+    RunStagesConcurrently(stages);
+
     // Wait for input to exit
+#ifdef _WIN32
     system("pause");
+#endif
 
     return 0;
 }
\ No newline at end of file
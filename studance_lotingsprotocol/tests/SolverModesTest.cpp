@@ -0,0 +1,193 @@
+#include "../benchmark/Fixtures.h"
+#include "../Studancer.h"
+#include "../DanceClass.h"
+#include "../MinCostMaxFlow.h"
+#include "../Presolve.h"
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <random>
+
+// Checks that every solver mode finds an assignment with the cost and the flow of the monolithic MinCostMaxFlow()
+// --tiers only gets there through the repair on the whole network, --components and --presolve are exact by construction,
+// each fixture makes sure the mode has something to do, otherwise the mode would just be the monolithic solve again
+
+typedef std::function<std::pair<int64_t, int>(MinCostMaxFlowArgs&, const CliArguments&)> SolverMode;
+
+struct SolveOutcome
+{
+    int64_t cost;
+    int flow;
+    int problems;
+};
+
+int failures = 0;
+
+void Check(bool condition, const std::string& fixtureName, const std::string& message)
+{
+    printf("%s %s: %s\n", condition ? "PASS" : "FAIL", fixtureName.c_str(), message.c_str());
+    if (!condition)
+    {
+        failures++;
+    }
+}
+
+SolveOutcome Solve(const std::vector<Studancer>& dancers, const std::vector<DanceClass>& classes, const CliArguments& cliArgs, const SolverMode& solverMode)
+{
+    // The solvers report their progress, only the outcome matters here
+    std::string output;
+    ScopedOutputBuffer outputBuffer(&output);
+
+    MinCostMaxFlowArgs args = EncodeMinCostMaxFlow(dancers, classes, cliArgs);
+    solverMode(args, cliArgs);
+
+    SolveOutcome outcome = {};
+    outcome.cost = GetFlowCost(args);
+    for (int neighbour : args.adjecencyList[args.sourceNode])
+    {
+        outcome.flow += args.flow[(size_t)args.sourceNode * args.numNodes + neighbour];
+    }
+    outcome.problems = CheckFlow(args);
+    return outcome;
+}
+
+void CheckSolverModes(const std::string& fixtureName, const fs::path& folder, const CliArguments& cliArgs)
+{
+    SetInputFolder(folder / "input");
+    SetOutputFolder(folder / "output");
+    std::vector<DanceClass> classes = LoadClasses();
+    std::vector<Studancer> dancers = LoadDancers(classes);
+
+    SolveOutcome monolithic = Solve(dancers, classes, cliArgs, MinCostMaxFlow);
+
+    std::vector<std::pair<std::string, SolverMode>> solverModes = {
+        { "tiers", MinCostMaxFlowByTiers },
+        { "components", MinCostMaxFlowByComponents },
+        { "presolve", MinCostMaxFlowWithPresolve }
+    };
+    for (auto& solverMode : solverModes)
+    {
+        SolveOutcome outcome = Solve(dancers, classes, cliArgs, solverMode.second);
+        char message[256];
+        snprintf(message, sizeof(message), "%s cost %lli flow %i, monolithic cost %lli flow %i", solverMode.first.c_str(),
+            (long long)outcome.cost, outcome.flow, (long long)monolithic.cost, monolithic.flow);
+        Check(outcome.cost == monolithic.cost && outcome.flow == monolithic.flow && outcome.problems == 0, fixtureName, message);
+    }
+}
+
+// Two families of classes that no dancer mixes, so the classes split into two components
+void WriteComponentFixture(const fs::path& folder, int numDancers, unsigned int seed)
+{
+    WriteFixture(folder, numDancers, seed);
+
+    std::vector<std::vector<std::string>> families = {
+        { "Streetdance 1", "Streetdance 2", "Streetdance 3", "Hiphop 1", "Hiphop 2", "Hiphop 3" },
+        { "Jazz 1", "Jazz 2", "Jazz 3", "Modern 1", "Modern 2", "Modern 3", "Klassiek" }
+    };
+
+    std::ofstream classesFile(folder / "input" / "danceclasses.csv");
+    classesFile << "Naam,Maximale Ruimte,Minimale Ruimte,Extra Speel Ruimte\n";
+    for (auto& family : families)
+    {
+        for (auto& className : family)
+        {
+            classesFile << className << ",16,8,2\n";
+        }
+    }
+    classesFile.close();
+
+    std::mt19937 rng(seed);
+    std::ofstream dancersFile(folder / "input" / "dancers.csv");
+    dancersFile << "Relatienummer,Voornaam,Achternaam,Studentstatus,Ben je al lid van Studance?,Gender,1e keuze,2e keuze,3e keuze,Advies,Lidmaatschap\n";
+    for (int i = 0; i < numDancers; i++)
+    {
+        std::vector<std::string> family = families[i % families.size()];
+        std::shuffle(family.begin(), family.end(), rng);
+
+        std::string wasAMember = i % 3 == 0 ? "Ja" : "Nee";
+        std::string advice = wasAMember == "Ja" ? "Ja" : "Ik was vorig jaar geen lid";
+        dancersFile << 100000 + i << ",Voornaam" << i << ",Achternaam" << i << ",Student,\"" << wasAMember << "\"," << (i % 4 == 0 ? "Man" : "Vrouw") << ",";
+        dancersFile << family[0] << " (wekelijks)," << family[1] << " (wekelijks)," << family[2] << "," << advice << ",Jaarlijkslidmaatschap\n";
+    }
+    dancersFile.close();
+}
+
+// A season where a few classes need many more dancers than chose them, so the presolve can fix their dancers
+void WritePresolveFixture(const fs::path& folder, int numDancers, unsigned int seed)
+{
+    WriteFixture(folder, numDancers, seed);
+
+    std::ifstream generatedFile(folder / "input" / "danceclasses.csv");
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(generatedFile, line))
+    {
+        lines.push_back(line);
+    }
+    generatedFile.close();
+
+    std::ofstream classesFile(folder / "input" / "danceclasses.csv");
+    for (int i = 0; i < lines.size(); i++)
+    {
+        // Every fourth class has room for far more dancers than choose it
+        if (i > 0 && i % 4 == 3)
+        {
+            classesFile << lines[i].substr(0, lines[i].find(',')) << "," << numDancers / 4 << "," << numDancers / 5 << ",2\n";
+        }
+        else
+        {
+            classesFile << lines[i] << "\n";
+        }
+    }
+    classesFile.close();
+}
+
+int main()
+{
+    fs::path workFolder = fs::temp_directory_path() / "studance_tests";
+
+    CliArguments cliArgs = {};
+    cliArgs.mcmf = true;
+    cliArgs.maxUnenroll = 0xFFFFFFFFU;
+
+    for (int numDancers : { 100, 500 })
+    {
+        std::string fixtureName = "season_" + std::to_string(numDancers);
+        WriteFixture(workFolder / fixtureName, numDancers, 2024);
+        CheckSolverModes(fixtureName, workFolder / fixtureName, cliArgs);
+    }
+
+    // Not every dancer fits, a later tier can need a seat an earlier tier took
+    {
+        std::string fixtureName = "season_500_max_unenroll_5";
+        CliArguments limitedArgs = cliArgs;
+        limitedArgs.maxUnenroll = 5;
+        WriteFixture(workFolder / fixtureName, 500, 2024);
+        CheckSolverModes(fixtureName, workFolder / fixtureName, limitedArgs);
+    }
+
+    {
+        std::string fixtureName = "components_300";
+        WriteComponentFixture(workFolder / fixtureName, 300, 2024);
+        SetInputFolder(workFolder / fixtureName / "input");
+        std::vector<DanceClass> classes = LoadClasses();
+        std::vector<Studancer> dancers = LoadDancers(classes);
+        size_t numComponents = FindClassComponents(dancers, classes, cliArgs).size();
+        Check(numComponents >= 2, fixtureName, "splits into " + std::to_string(numComponents) + " class components");
+        CheckSolverModes(fixtureName, workFolder / fixtureName, cliArgs);
+    }
+
+    {
+        std::string fixtureName = "presolve_500";
+        WritePresolveFixture(workFolder / fixtureName, 500, 2024);
+        SetInputFolder(workFolder / fixtureName / "input");
+        std::vector<DanceClass> classes = LoadClasses();
+        std::vector<Studancer> dancers = LoadDancers(classes);
+        size_t numFixed = PresolveAssignment(dancers, classes).fixedPlacements.size();
+        Check(numFixed > 0, fixtureName, "presolve fixes " + std::to_string(numFixed) + " placements");
+        CheckSolverModes(fixtureName, workFolder / fixtureName, cliArgs);
+    }
+
+    printf("\n%i failed\n", failures);
+    return failures == 0 ? 0 : 1;
+}